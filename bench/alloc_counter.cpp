@@ -0,0 +1,41 @@
+// bench/alloc_counter.cpp
+// Counts heap allocations by interposing the C allocator, which both
+// operator new and rapidjson's CrtAllocator end up in.
+#include "alloc_counter.h"
+#include <atomic>
+#include <cstddef>
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+}
+
+namespace {
+
+std::atomic<uint64_t> allocations(0);
+
+} // namespace
+
+extern "C" {
+
+void *malloc(size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_realloc(ptr, size);
+}
+
+} // extern "C"
+
+uint64_t allocation_count() {
+  return allocations.load(std::memory_order_relaxed);
+}
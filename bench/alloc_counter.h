@@ -0,0 +1,11 @@
+// bench/alloc_counter.h
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+#include <cstdint>
+
+// Number of malloc/calloc/realloc calls made by the process so far. Only
+// counts when alloc_counter.cpp is linked in (glibc only).
+uint64_t allocation_count();
+
+#endif // ALLOC_COUNTER_H
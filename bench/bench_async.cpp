@@ -0,0 +1,67 @@
+// bench/bench_async.cpp
+// Wall-clock time of fetching the five getters one after another with the
+// blocking API versus all in flight at once through the async engine.
+// Usage: bench_async [rounds] [latency-ms]
+#include "bench_util.h"
+#include "mock_spotify.h"
+#include "spotify_api.h"
+#include "spotify_operations/LibraryOperations.h"
+#include "spotify_operations/PlaylistOperations.h"
+#include "spotify_operations/RecommendationsOperations.h"
+#include "spotify_operations/SearchOperations.h"
+#include <cstdlib>
+
+namespace {
+
+const std::string kToken = "bench-token";
+
+bool fetch_blocking() {
+  rapidjson::Document playlists, tracks, saved, results, recommendations;
+  return get_user_playlists(kToken, playlists) &&
+         get_playlist_tracks(kToken, "pl0", tracks) &&
+         get_saved_tracks(kToken, saved) &&
+         search_spotify(kToken, "bench", SearchType::TRACK, results) &&
+         get_recommendations(kToken, {"rock"}, recommendations);
+}
+
+bool fetch_async() {
+  rapidjson::Document playlists, tracks, saved, results, recommendations;
+  std::future<bool> futures[] = {
+      get_user_playlists_async(kToken, playlists),
+      get_playlist_tracks_async(kToken, "pl0", tracks),
+      get_saved_tracks_async(kToken, saved),
+      search_spotify_async(kToken, "bench", SearchType::TRACK, results),
+      get_recommendations_async(kToken, {"rock"}, recommendations)};
+  bool ok = true;
+  for (auto &future : futures)
+    ok = future.get() && ok;
+  return ok;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int rounds = argc > 1 ? std::atoi(argv[1]) : 50;
+  MockSpotifyConfig config;
+  config.latency_ms = argc > 2 ? std::atoi(argv[2]) : 20;
+
+  MockServer server(make_mock_spotify_handler(config));
+  if (!start_mock_spotify(server))
+    return 1;
+
+  std::vector<double> blocking, async;
+  for (int i = 0; i < rounds; ++i) {
+    auto start = BenchClock::now();
+    fetch_blocking();
+    blocking.push_back(elapsed_us(start, BenchClock::now()));
+  }
+  for (int i = 0; i < rounds; ++i) {
+    auto start = BenchClock::now();
+    fetch_async();
+    async.push_back(elapsed_us(start, BenchClock::now()));
+  }
+  print_latency("5 getters, blocking", blocking);
+  print_latency("5 getters, async", async);
+  server.stop();
+  return 0;
+}
@@ -0,0 +1,76 @@
+// bench/bench_batch.cpp
+// Runs a generated script of saves, playlist additions, searches and queue
+// additions through batch mode: one request at a time, pipelined, and
+// pipelined with consecutive saves and additions coalesced. Reports
+// commands/sec and the requests each run needed.
+// Usage: bench_batch [commands] [latency-ms] [concurrency]
+#include "batch_mode.h"
+#include "bench_util.h"
+#include "mock_spotify.h"
+#include "name_generator.h"
+#include "spotify_api.h"
+#include <cstdlib>
+#include <sstream>
+
+namespace {
+
+const int kPlaylists = 10;
+
+// Mostly library and playlist changes, as a sync script would send, with
+// searches and a few ordered queue additions mixed in
+std::string make_script(int commands) {
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<int> percent(0, 99);
+  std::uniform_int_distribution<int> playlist(0, kPlaylists - 1);
+  std::ostringstream script;
+  script << "# generated by bench_batch\n";
+  for (int i = 0; i < commands; ++i) {
+    std::string uri = "spotify:track:bench" + std::to_string(i);
+    int roll = percent(rng);
+    if (roll < 45)
+      script << "save " << uri << "\n";
+    else if (roll < 80)
+      script << "playlist-add pl" << playlist(rng) << " " << uri << "\n";
+    else if (roll < 98)
+      script << "search track " << make_name(rng) << "\n";
+    else
+      script << "queue " << uri << "\n";
+  }
+  return script.str();
+}
+
+void run(const std::string &label, const std::string &script,
+         const BatchOptions &options) {
+  std::istringstream in(script);
+  std::ostringstream out;
+  BatchStats stats = run_batch("bench-token", in, out, options);
+  std::printf("%-26s %6zu commands %4zu failed %6zu requests %8.1fms "
+              "%8.0f commands/s\n",
+              label.c_str(), stats.commands, stats.failed, stats.requests,
+              stats.elapsed_ms, stats.commands * 1000.0 / stats.elapsed_ms);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int commands = argc > 1 ? std::atoi(argv[1]) : 10000;
+  MockSpotifyConfig config;
+  config.latency_ms = argc > 2 ? std::atoi(argv[2]) : 10;
+  int concurrency = argc > 3 ? std::atoi(argv[3]) : kDefaultBatchConcurrency;
+
+  MockServer server(make_mock_spotify_handler(config));
+  if (!start_mock_spotify(server))
+    return 1;
+  std::string script = make_script(commands);
+
+  BatchOptions options;
+  options.concurrency = 1;
+  options.coalesce = false;
+  run("one at a time", script, options);
+  options.concurrency = concurrency;
+  run("pipelined", script, options);
+  options.coalesce = true;
+  run("pipelined and coalesced", script, options);
+  server.stop();
+  return 0;
+}
@@ -0,0 +1,140 @@
+// bench/bench_catalog.cpp
+// Loads a synthetic library into the catalog and into the per-menu
+// name/URI pairs and saved-track structs it replaces, and reports heap bytes
+// per track and the time to select a track by name and by URI.
+// Usage: bench_catalog [tracks] [lookups]
+#include "bench_util.h"
+#include "catalog.h"
+#include "library_store.h"
+#include "name_generator.h"
+#include <cstdlib>
+#include <malloc.h>
+
+namespace {
+
+// Heap bytes in use, including blocks large enough to be mmapped (glibc
+// only)
+size_t heap_in_use() {
+  struct mallinfo2 info = mallinfo2();
+  return info.uordblks + info.hblkhd;
+}
+
+std::string make_id(std::mt19937 &rng) {
+  static const char kBase62[] =
+      "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+  std::uniform_int_distribution<int> digit(0, 61);
+  std::string id(22, '0');
+  for (char &c : id)
+    c = kBase62[digit(rng)];
+  return id;
+}
+
+void print_memory(const char *label, size_t bytes, size_t tracks) {
+  std::printf("%-32s %8.1f MB  %6.1f bytes/track\n", label, bytes / 1e6,
+              double(bytes) / tracks);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+  int lookups = argc > 2 ? std::atoi(argv[2]) : 200;
+  std::mt19937 rng(42);
+
+  // Artists and albums repeat across tracks as in a real library
+  std::vector<std::string> artists;
+  std::vector<std::string> albums;
+  for (size_t i = 0; i < count / 20 + 1; ++i)
+    artists.push_back(make_name(rng));
+  for (size_t i = 0; i < count / 10 + 1; ++i)
+    albums.push_back(make_name(rng));
+  std::uniform_int_distribution<size_t> artist(0, artists.size() - 1);
+  std::uniform_int_distribution<size_t> album(0, albums.size() - 1);
+  std::uniform_int_distribution<int> duration(90000, 420000);
+
+  std::vector<SavedTrack> source(count);
+  for (auto &track : source) {
+    track.id = make_id(rng);
+    track.uri = "spotify:track:" + track.id;
+    track.name = make_name(rng);
+    track.artist = artists[artist(rng)];
+    track.album = albums[album(rng)];
+    track.duration_ms = duration(rng);
+  }
+  std::printf("%zu tracks, %zu artists, %zu albums\n\n", count,
+              artists.size(), albums.size());
+
+  size_t before = heap_in_use();
+  std::vector<std::pair<std::string, std::string>> pairs;
+  for (auto &track : source)
+    pairs.emplace_back(track.name, track.uri);
+  print_memory("name/URI pairs", heap_in_use() - before, count);
+
+  before = heap_in_use();
+  std::vector<SavedTrack> copies(source);
+  print_memory("saved-track structs", heap_in_use() - before, count);
+
+  before = heap_in_use();
+  Catalog catalog;
+  CatalogView view;
+  auto start = BenchClock::now();
+  for (auto &track : source)
+    view.push_back(catalog.add_track(track.name, track.uri, track.artist,
+                                     track.album, track.duration_ms));
+  double load_ms = elapsed_us(start, BenchClock::now()) / 1000;
+  print_memory("catalog", heap_in_use() - before, count);
+  std::printf("%-32s %8.1f MB  (columns, indexes and strings)\n",
+              "  of which reported", catalog.memory_bytes() / 1e6);
+  std::printf("%-32s %8.1f MB  (the view of all tracks)\n", "  of which",
+              view.capacity() * sizeof(CatalogRef) / 1e6);
+  std::printf("%-32s %8.1f ms\n\n", "  load time", load_ms);
+
+  std::uniform_int_distribution<size_t> pick(0, count - 1);
+  std::vector<double> scan_name;
+  std::vector<double> scan_uri;
+  std::vector<double> catalog_name;
+  std::vector<double> catalog_uri;
+  size_t mismatches = 0;
+  for (int i = 0; i < lookups; ++i) {
+    const SavedTrack &target = source[pick(rng)];
+
+    auto begin = BenchClock::now();
+    std::string uri;
+    for (auto &pair : pairs) {
+      if (pair.first == target.name) {
+        uri = pair.second;
+        break;
+      }
+    }
+    scan_name.push_back(elapsed_us(begin, BenchClock::now()));
+
+    begin = BenchClock::now();
+    std::string name;
+    for (auto &pair : pairs) {
+      if (pair.second == target.uri) {
+        name = pair.first;
+        break;
+      }
+    }
+    scan_uri.push_back(elapsed_us(begin, BenchClock::now()));
+
+    begin = BenchClock::now();
+    CatalogView named = catalog.find_name(target.name);
+    catalog_name.push_back(elapsed_us(begin, BenchClock::now()));
+
+    begin = BenchClock::now();
+    CatalogRef ref = catalog.find(CatalogKind::TRACK, target.uri);
+    catalog_uri.push_back(elapsed_us(begin, BenchClock::now()));
+
+    if (named.empty() || ref == kNoCatalogEntry ||
+        catalog.uri(ref) != target.uri)
+      ++mismatches;
+  }
+  print_latency("scan pairs by name", scan_name);
+  print_latency("scan pairs by URI", scan_uri);
+  print_latency("catalog by name", catalog_name);
+  print_latency("catalog by URI", catalog_uri);
+  if (mismatches)
+    std::printf("%zu lookups failed\n", mismatches);
+  return mismatches ? 1 : 0;
+}
@@ -0,0 +1,137 @@
+// bench/bench_document_pool.cpp
+// Counts heap allocations of DOM parsing with a fresh rapidjson::Document per
+// page against documents leased from the pool, first on one page body alone
+// and then over a full playlist load through the pagination engine. Load
+// counts include the HTTP client and the in-process mock server, which are
+// the same for both.
+// Usage: bench_document_pool [pages] [iterations]
+#include "alloc_counter.h"
+#include "bench_util.h"
+#include "document_pool.h"
+#include "mock_spotify.h"
+#include "pagination.h"
+#include "spotify_api.h"
+#include "spotify_operations/PlaylistOperations.h"
+#include <cstdlib>
+
+namespace {
+
+const int kPageSize = 100;
+
+template <typename Fn>
+void run_parse(const std::string &label, int iterations, Fn fn) {
+  std::vector<double> samples;
+  uint64_t allocations_before = allocation_count();
+  for (int i = 0; i < iterations; ++i) {
+    auto start = BenchClock::now();
+    fn();
+    samples.push_back(elapsed_us(start, BenchClock::now()));
+  }
+  print_latency(label, samples);
+  std::printf("%-32s allocs/parse=%.2f\n", "",
+              double(allocation_count() - allocations_before) / iterations);
+}
+
+// Fetches every page one request at a time
+template <typename Fetch>
+void run_load(const std::string &label, int pages, Fetch fetch) {
+  uint64_t allocations_before = allocation_count();
+  auto start = BenchClock::now();
+  size_t items = 0;
+  bool ok = true;
+  for (int page = 0; page < pages && ok; ++page)
+    ok = fetch(page * kPageSize, items);
+  double total_us = elapsed_us(start, BenchClock::now());
+  std::printf("%-32s %s items=%zu total=%.1fms allocs/page=%.1f\n",
+              label.c_str(), ok ? "ok" : "FAILED", items, total_us / 1000,
+              double(allocation_count() - allocations_before) / pages);
+}
+
+std::string page_url(int offset) {
+  return spotify_api_url("/playlists/pl0/tracks?limit=" +
+                         std::to_string(kPageSize) +
+                         "&offset=" + std::to_string(offset));
+}
+
+void print_pool_stats() {
+  DocumentPoolStats stats = document_pool().stats();
+  std::printf("  pool: leases=%llu arenas-created=%llu arenas-grown=%llu "
+              "idle=%zu idle-bytes=%zu\n",
+              (unsigned long long)stats.leases,
+              (unsigned long long)stats.arenas_created,
+              (unsigned long long)stats.arenas_grown, stats.idle,
+              stats.idle_bytes);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int pages = argc > 1 ? std::atoi(argv[1]) : 50;
+  int iterations = argc > 2 ? std::atoi(argv[2]) : 2000;
+  MockSpotifyConfig config;
+  config.tracks_per_playlist = pages * kPageSize;
+  config.max_page_size = kPageSize;
+  // Cached copies would add allocations of their own to every page
+  config.etags = false;
+  MockServer::Handler handler = make_mock_spotify_handler(config);
+
+  MockRequest request;
+  request.method = "GET";
+  request.target = "/v1/playlists/pl0/tracks?limit=100&offset=0";
+  std::string body = handler(request).body;
+
+  std::printf("parse one %zu-byte playlist tracks page\n", body.size());
+  run_parse("  fresh Document", iterations, [&] {
+    rapidjson::Document doc;
+    doc.Parse(body.c_str());
+  });
+  run_parse("  pooled", iterations, [&] {
+    DocumentLease doc = document_pool().acquire();
+    doc->Parse(body.c_str());
+  });
+  print_pool_stats();
+
+  MockServer server(handler);
+  if (!start_mock_spotify(server))
+    return 1;
+
+  std::printf("load a %d-page playlist\n", pages);
+  // The first pass warms up connections and the pool's arenas
+  for (int pass = 0; pass < 2; ++pass) {
+    const char *suffix = pass == 0 ? " (cold)" : " (warm)";
+    run_load(std::string("  fresh Document") + suffix, pages,
+             [](int offset, size_t &items) {
+               rapidjson::Document doc;
+               if (!spotify_get_json("bench-token", page_url(offset), doc))
+                 return false;
+               items += doc["items"].Size();
+               return true;
+             });
+    run_load(std::string("  pooled") + suffix, pages,
+             [](int offset, size_t &items) {
+               DocumentLease doc;
+               if (!spotify_get_pooled_json("bench-token", page_url(offset),
+                                            doc))
+                 return false;
+               items += (*doc)["items"].Size();
+               return true;
+             });
+
+    uint64_t allocations_before = allocation_count();
+    auto start = BenchClock::now();
+    size_t items = 0;
+    bool ok = get_all_playlist_tracks(
+        "bench-token", "pl0", [&](const rapidjson::Value &page, int) {
+          items += page["items"].Size();
+          return true;
+        });
+    double total_us = elapsed_us(start, BenchClock::now());
+    std::printf("%-32s %s items=%zu total=%.1fms allocs/page=%.1f\n",
+                (std::string("  pooled, pipelined") + suffix).c_str(),
+                ok ? "ok" : "FAILED", items, total_us / 1000,
+                double(allocation_count() - allocations_before) / pages);
+  }
+  print_pool_stats();
+  server.stop();
+  return 0;
+}
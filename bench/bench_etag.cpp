@@ -0,0 +1,66 @@
+// bench/bench_etag.cpp
+// Re-fetches the same playlist pages several times, parsed into a DOM and
+// extracted as list items. The first pass fills the response cache; later
+// passes are conditional GETs answered with 304.
+// Usage: bench_etag [playlists] [passes] [latency-ms]
+#include "bench_util.h"
+#include "mock_spotify.h"
+#include "response_cache.h"
+#include "spotify_api.h"
+#include "spotify_operations/PlaylistOperations.h"
+#include <cstdlib>
+#include <functional>
+
+namespace {
+
+void run_passes(const char *label, int playlists, int passes,
+                const std::function<void(const std::string &)> &fetch) {
+  response_cache().clear();
+  std::printf("%s\n", label);
+  for (int pass = 0; pass < passes; ++pass) {
+    std::vector<double> samples;
+    for (int i = 0; i < playlists; ++i) {
+      auto start = BenchClock::now();
+      fetch("pl" + std::to_string(i));
+      samples.push_back(elapsed_us(start, BenchClock::now()));
+    }
+    print_latency(pass == 0 ? "  cold pass" : "  revalidated pass", samples);
+  }
+
+  ResponseCacheStats stats = response_cache().stats();
+  std::printf("  lookups=%llu hits=%llu hit-ratio=%.1f%% stored=%llu "
+              "bytes-saved=%llu\n",
+              static_cast<unsigned long long>(stats.lookups),
+              static_cast<unsigned long long>(stats.hits),
+              stats.hit_ratio() * 100,
+              static_cast<unsigned long long>(stats.stores),
+              static_cast<unsigned long long>(stats.bytes_saved));
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int playlists = argc > 1 ? std::atoi(argv[1]) : 40;
+  int passes = argc > 2 ? std::atoi(argv[2]) : 5;
+  MockSpotifyConfig config;
+  config.latency_ms = argc > 3 ? std::atoi(argv[3]) : 0;
+  config.max_page_size = 100;
+
+  MockServer server(make_mock_spotify_handler(config));
+  if (!start_mock_spotify(server))
+    return 1;
+
+  run_passes("DOM", playlists, passes, [](const std::string &id) {
+    rapidjson::Document tracks;
+    get_playlist_tracks("bench-token", id, tracks, 100);
+  });
+  run_passes("items", playlists, passes, [](const std::string &id) {
+    ItemPage page;
+    spotify_get_items("bench-token",
+                      spotify_api_url("/playlists/" + id +
+                                      "/tracks?limit=100&offset=0"),
+                      ItemView::TRACK_ITEMS, page);
+  });
+  server.stop();
+  return 0;
+}
@@ -0,0 +1,104 @@
+// bench/bench_extract.cpp
+// Compares building a DOM and walking it with the SAX extractor on the
+// responses the list views are built from. Bodies come straight from the mock
+// handler, so no sockets are involved.
+// Usage: bench_extract [iterations]
+#include "alloc_counter.h"
+#include "bench_util.h"
+#include "json_extract.h"
+#include "mock_spotify.h"
+#include "rapidjson/document.h"
+#include <cstdlib>
+
+namespace {
+
+std::string mock_body(const MockServer::Handler &handler,
+                      const std::string &target) {
+  MockRequest request;
+  request.method = "GET";
+  request.target = target;
+  return handler(request).body;
+}
+
+// What the menus did before: parse everything, then copy out two fields
+size_t dom_extract(const std::string &body, const char *items_key,
+                   const char *inner, const char *key_field) {
+  rapidjson::Document doc;
+  doc.Parse(body.c_str());
+  std::vector<NamedItem> items;
+  if (doc.HasParseError() || !doc.IsObject())
+    return 0;
+  const rapidjson::Value *list = &doc;
+  if (inner)
+    list = &doc[inner];
+  for (auto &entry : (*list)[items_key].GetArray()) {
+    const rapidjson::Value &item =
+        entry.HasMember("track") ? entry["track"] : entry;
+    NamedItem named;
+    named.name = item["name"].GetString();
+    named.key = item[key_field].GetString();
+    items.push_back(named);
+  }
+  return items.size();
+}
+
+size_t sax_extract(const std::string &body, ItemView view) {
+  ItemPage page;
+  extract_items(body.c_str(), view, page);
+  return page.items.size();
+}
+
+template <typename Fn>
+void run(const std::string &label, int iterations, size_t bytes, Fn fn) {
+  std::vector<double> samples;
+  size_t items = 0;
+  uint64_t allocations_before = allocation_count();
+  for (int i = 0; i < iterations; ++i) {
+    auto start = BenchClock::now();
+    items = fn();
+    samples.push_back(elapsed_us(start, BenchClock::now()));
+  }
+  double allocations =
+      double(allocation_count() - allocations_before) / iterations;
+  double total_us = 0;
+  for (double s : samples)
+    total_us += s;
+  print_latency(label, samples);
+  std::printf("%-32s items=%zu allocs/page=%.1f MB/s=%.1f\n", "", items,
+              allocations, bytes * iterations / total_us);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int iterations = argc > 1 ? std::atoi(argv[1]) : 2000;
+  MockSpotifyConfig config;
+  config.max_page_size = 100;
+  config.etags = false;
+  MockServer::Handler handler = make_mock_spotify_handler(config);
+
+  std::string tracks =
+      mock_body(handler, "/v1/playlists/pl0/tracks?limit=100&offset=0");
+  std::string playlists = mock_body(handler, "/v1/me/playlists?limit=50");
+  std::string search =
+      mock_body(handler, "/v1/search?q=mock&type=track&limit=50");
+
+  std::printf("playlist tracks page: %zu bytes\n", tracks.size());
+  run("  DOM", iterations, tracks.size(),
+      [&] { return dom_extract(tracks, "items", nullptr, "uri"); });
+  run("  SAX", iterations, tracks.size(),
+      [&] { return sax_extract(tracks, ItemView::TRACK_ITEMS); });
+
+  std::printf("playlists page: %zu bytes\n", playlists.size());
+  run("  DOM", iterations, playlists.size(),
+      [&] { return dom_extract(playlists, "items", nullptr, "id"); });
+  run("  SAX", iterations, playlists.size(),
+      [&] { return sax_extract(playlists, ItemView::PLAYLISTS); });
+
+  std::printf("track search: %zu bytes\n", search.size());
+  run("  DOM", iterations, search.size(),
+      [&] { return dom_extract(search, "items", "tracks", "uri"); });
+  run("  SAX", iterations, search.size(),
+      [&] { return sax_extract(search, ItemView::SEARCH_TRACKS); });
+  return 0;
+}
@@ -0,0 +1,75 @@
+// bench/bench_http_client.cpp
+// Per-request latency of a fresh cURL handle per call (the old request path)
+// against the pooled, shared-cache client, both hitting a local mock server.
+#include "bench_util.h"
+#include "http_client.h"
+#include "mock_server.h"
+#include "utils.h"
+#include <cstdlib>
+#include <curl/curl.h>
+
+namespace {
+
+bool fresh_handle_get(const std::string &url) {
+  CURL *curl = curl_easy_init();
+  if (!curl)
+    return false;
+  std::string response;
+  struct curl_slist *headers = NULL;
+  headers = curl_slist_append(headers, "Authorization: Bearer bench-token");
+  curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+  curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
+  curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+  CURLcode res = curl_easy_perform(curl);
+  curl_slist_free_all(headers);
+  curl_easy_cleanup(curl);
+  return res == CURLE_OK;
+}
+
+bool pooled_get(const std::string &url) {
+  HttpRequest request;
+  request.url = url;
+  request.headers.push_back("Authorization: Bearer bench-token");
+  HttpResponse response;
+  return http_perform(request, response);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int iterations = argc > 1 ? std::atoi(argv[1]) : 2000;
+
+  MockServer server;
+  if (!server.start()) {
+    std::fprintf(stderr, "failed to start mock server\n");
+    return 1;
+  }
+  std::string url = server.base_url() + "/v1/me/playlists?limit=20&offset=0";
+
+  std::vector<double> samples;
+  size_t connections_before = server.connections_accepted();
+  for (int i = 0; i < iterations; ++i) {
+    auto start = BenchClock::now();
+    fresh_handle_get(url);
+    samples.push_back(elapsed_us(start, BenchClock::now()));
+  }
+  print_latency("fresh handle per request", samples);
+  std::printf("  connections opened: %zu\n",
+              server.connections_accepted() - connections_before);
+
+  samples.clear();
+  connections_before = server.connections_accepted();
+  for (int i = 0; i < iterations; ++i) {
+    auto start = BenchClock::now();
+    pooled_get(url);
+    samples.push_back(elapsed_us(start, BenchClock::now()));
+  }
+  print_latency("pooled shared client", samples);
+  std::printf("  connections opened: %zu, easy handles created: %zu\n",
+              server.connections_accepted() - connections_before,
+              http_handles_created());
+
+  server.stop();
+  return 0;
+}
@@ -0,0 +1,45 @@
+// bench/bench_library_batch.cpp
+// Saves the same set of tracks one request per track and then in 50-ID
+// batches with increasing concurrency, and reports wall time and requests.
+// Usage: bench_library_batch [tracks] [latency-ms]
+#include "bench_util.h"
+#include "mock_spotify.h"
+#include "spotify_api.h"
+#include "spotify_operations/LibraryOperations.h"
+#include <cstdlib>
+
+int main(int argc, char **argv) {
+  int count = argc > 1 ? std::atoi(argv[1]) : 500;
+  MockSpotifyConfig config;
+  config.latency_ms = argc > 2 ? std::atoi(argv[2]) : 20;
+
+  MockServer server(make_mock_spotify_handler(config));
+  if (!start_mock_spotify(server))
+    return 1;
+
+  std::vector<std::string> uris;
+  for (int i = 0; i < count; ++i)
+    uris.push_back("spotify:track:bench" + std::to_string(i));
+
+  size_t requests_before = server.requests_served();
+  size_t saved = 0;
+  auto start = BenchClock::now();
+  for (auto &uri : uris)
+    saved += add_track_to_library("bench-token", uri) ? 1 : 0;
+  std::printf("%-24s saved=%zu requests=%zu total=%.1fms\n", "per track",
+              saved, server.requests_served() - requests_before,
+              elapsed_us(start, BenchClock::now()) / 1000);
+
+  const int concurrencies[] = {1, 2, 4, 8};
+  for (int concurrency : concurrencies) {
+    requests_before = server.requests_served();
+    start = BenchClock::now();
+    saved = save_tracks_to_library("bench-token", uris, concurrency);
+    std::printf("batched concurrency=%-4d saved=%zu requests=%zu "
+                "total=%.1fms\n",
+                concurrency, saved, server.requests_served() - requests_before,
+                elapsed_us(start, BenchClock::now()) / 1000);
+  }
+  server.stop();
+  return 0;
+}
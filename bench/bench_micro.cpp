@@ -0,0 +1,278 @@
+// bench/bench_micro.cpp
+// Microbenchmarks of the CPU-bound paths: Document::Parse of list responses
+// of several sizes, the display_* functions that walk a parsed response,
+// the SAX extractor, base64, url_encode, split and trim. Payloads come from
+// the mock handler, so no sockets are involved and every run sees the same
+// bytes. Each case is warmed up, sized so that one sample takes at least
+// kSampleMs, and sampled repeatedly; the median is reported with the spread
+// of the middle half of the samples, so two runs can be compared line by
+// line. Menu output goes to a discarding stream and prompts are answered
+// from a fixed string.
+// Usage: bench_micro [filter] [samples]
+#include "base64/base64.h"
+#include "bench_util.h"
+#include "json_extract.h"
+#include "mock_spotify.h"
+#include "rapidjson/document.h"
+#include "spotify_operations/LibraryOperations.h"
+#include "spotify_operations/PlaylistOperations.h"
+#include "spotify_operations/RecommendationsOperations.h"
+#include "spotify_operations/SearchOperations.h"
+#include "utils.h"
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <streambuf>
+
+namespace {
+
+const double kSampleMs = 20;
+const double kWarmupMs = 50;
+
+// Results are added here so the compiler cannot drop the work
+volatile size_t sink;
+
+// Swallows everything written to it
+class NullBuffer : public std::streambuf {
+protected:
+  int overflow(int c) override { return c; }
+  std::streamsize xsputn(const char *, std::streamsize n) override {
+    return n;
+  }
+};
+
+struct Case {
+  std::string name;
+  size_t bytes; // processed per call, 0 when throughput means nothing
+  std::function<size_t()> fn;
+};
+
+std::string mock_body(const MockServer::Handler &handler,
+                      const std::string &target) {
+  MockRequest request;
+  request.method = "GET";
+  request.target = target;
+  return handler(request).body;
+}
+
+// Time per call in ns of a batch of iterations
+double sample_ns(const Case &c, size_t iterations) {
+  size_t total = 0;
+  auto start = BenchClock::now();
+  for (size_t i = 0; i < iterations; ++i)
+    total += c.fn();
+  double us = elapsed_us(start, BenchClock::now());
+  sink = sink + total;
+  return us * 1000 / iterations;
+}
+
+void run(const Case &c, int samples) {
+  // Warm caches and the branch predictor, and size the batches from it
+  size_t iterations = 1;
+  double warmed_us = 0;
+  while (warmed_us < kWarmupMs * 1000) {
+    auto start = BenchClock::now();
+    sample_ns(c, iterations);
+    warmed_us += elapsed_us(start, BenchClock::now());
+    if (warmed_us < kSampleMs * 1000)
+      iterations *= 2;
+  }
+  double per_call_ns = sample_ns(c, iterations);
+  iterations = std::max<size_t>(
+      1, static_cast<size_t>(kSampleMs * 1e6 / std::max(per_call_ns, 1.0)));
+
+  std::vector<double> ns;
+  for (int s = 0; s < samples; ++s)
+    ns.push_back(sample_ns(c, iterations));
+  std::sort(ns.begin(), ns.end());
+  double median = ns[ns.size() / 2];
+  double spread = (ns[ns.size() * 3 / 4] - ns[ns.size() / 4]) / median * 100;
+  std::printf("%-36s %9zu %12.1f %6.1f%%", c.name.c_str(), c.bytes, median,
+              spread);
+  if (c.bytes)
+    std::printf(" %9.1f", c.bytes / median * 1000);
+  std::printf("\n");
+}
+
+// A response parsed on first use, so that filtered-out cases cost nothing
+class ParsedBody {
+public:
+  explicit ParsedBody(const std::string &body) : body_(body) {}
+
+  const rapidjson::Document &doc() {
+    if (!doc_) {
+      doc_.reset(new rapidjson::Document());
+      doc_->Parse(body_.c_str());
+    }
+    return *doc_;
+  }
+
+private:
+  const std::string &body_;
+  std::unique_ptr<rapidjson::Document> doc_;
+};
+
+size_t parse(const std::string &body) {
+  rapidjson::Document doc;
+  doc.Parse(body.c_str());
+  return doc.HasParseError() ? 0 : 1;
+}
+
+size_t extract(const std::string &body, ItemView view) {
+  ItemPage page;
+  extract_items(body.c_str(), view, page);
+  return page.items.size();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::string filter = argc > 1 ? argv[1] : "";
+  int samples = argc > 2 ? std::max(1, std::atoi(argv[2])) : 15;
+
+  MockSpotifyConfig config;
+  config.max_page_size = 100;
+  config.etags = false;
+  MockServer::Handler handler = make_mock_spotify_handler(config);
+
+  struct Payload {
+    const char *name;
+    std::string body;
+    ItemView view;
+  };
+  std::vector<Payload> payloads = {
+      {"playlists/20", mock_body(handler, "/v1/me/playlists?limit=20"),
+       ItemView::PLAYLISTS},
+      {"playlists/50", mock_body(handler, "/v1/me/playlists?limit=50"),
+       ItemView::PLAYLISTS},
+      {"playlist_tracks/10",
+       mock_body(handler, "/v1/playlists/pl0/tracks?limit=10"),
+       ItemView::TRACK_ITEMS},
+      {"playlist_tracks/100",
+       mock_body(handler, "/v1/playlists/pl0/tracks?limit=100"),
+       ItemView::TRACK_ITEMS},
+      {"saved_tracks/50", mock_body(handler, "/v1/me/tracks?limit=50"),
+       ItemView::TRACK_ITEMS},
+      {"search_tracks/10",
+       mock_body(handler, "/v1/search?q=mock&type=track&limit=10"),
+       ItemView::SEARCH_TRACKS},
+      {"search_tracks/50",
+       mock_body(handler, "/v1/search?q=mock&type=track&limit=50"),
+       ItemView::SEARCH_TRACKS},
+      {"recommendations/100",
+       mock_body(handler, "/v1/recommendations?seed_genres=rock&limit=100"),
+       ItemView::RECOMMENDATIONS},
+  };
+  std::string genres =
+      mock_body(handler, "/v1/recommendations/available-genre-seeds");
+
+  std::vector<Case> cases;
+  for (auto &payload : payloads) {
+    const std::string &body = payload.body;
+    cases.push_back({std::string("parse/") + payload.name, body.size(),
+                     [&body] { return parse(body); }});
+    ItemView view = payload.view;
+    cases.push_back({std::string("extract_items/") + payload.name,
+                     body.size(),
+                     [&body, view] { return extract(body, view); }});
+  }
+  cases.push_back({"parse/genres", genres.size(),
+                   [&genres] { return parse(genres); }});
+
+  // The display functions walk an already parsed document
+  ParsedBody playlists(payloads[1].body), tracks(payloads[3].body),
+      saved(payloads[4].body), search(payloads[6].body),
+      recommendations(payloads[7].body), genre_doc(genres);
+  std::istringstream answers;
+  auto answer = [&answers](const char *text) {
+    answers.clear();
+    answers.str(text);
+  };
+  cases.push_back({"display_playlists_and_select/50", 0, [&playlists] {
+                     return display_playlists_and_select(playlists.doc())
+                         .size();
+                   }});
+  cases.push_back({"display_tracks_and_select/100", 0, [&tracks] {
+                     return display_tracks_and_select(tracks.doc()).size();
+                   }});
+  cases.push_back({"display_saved_tracks_and_select/50", 0, [&saved] {
+                     return display_saved_tracks_and_select(saved.doc())
+                         .size();
+                   }});
+  cases.push_back({"display_search_results/50", 0, [&search] {
+                     display_search_results(search.doc(), SearchType::TRACK);
+                     return size_t(1);
+                   }});
+  cases.push_back({"display_recommendations_and_select/100", 0,
+                   [&recommendations, &answer] {
+                     answer("1\n");
+                     return size_t(display_recommendations_and_select(
+                         recommendations.doc()));
+                   }});
+  cases.push_back({"display_available_genres_and_select", 0,
+                   [&genre_doc, &answer] {
+                     answer("rock, jazz, pop\n");
+                     return display_available_genres_and_select(genre_doc.doc())
+                         .size();
+                   }});
+
+  std::string credentials = "0123456789abcdef0123456789abcdef:"
+                            "fedcba9876543210fedcba9876543210";
+  std::string block(64 * 1024, '\0');
+  for (size_t i = 0; i < block.size(); ++i)
+    block[i] = static_cast<char>(i * 131 + 7);
+  std::string credentials64 = base64_encode(credentials);
+  std::string block64 = base64_encode(block);
+  cases.push_back({"base64_encode/credentials", credentials.size(),
+                   [&credentials] {
+                     return base64_encode(credentials).size();
+                   }});
+  cases.push_back({"base64_encode/64k", block.size(),
+                   [&block] { return base64_encode(block).size(); }});
+  cases.push_back({"base64_decode/credentials", credentials64.size(),
+                   [&credentials64] {
+                     return base64_decode(credentials64).size();
+                   }});
+  cases.push_back({"base64_decode/64k", block64.size(),
+                   [&block64] { return base64_decode(block64).size(); }});
+
+  std::string query = "Beyoncé & Jay-Z: Crazy in Love (Remix) 2003";
+  std::string ascii_query = "bohemian rhapsody";
+  cases.push_back({"url_encode/query", query.size(),
+                   [&query] { return url_encode(query).size(); }});
+  cases.push_back({"url_encode/ascii", ascii_query.size(),
+                   [&ascii_query] { return url_encode(ascii_query).size(); }});
+
+  std::string genre_list = "rock, jazz, pop, hip-hop, classical, metal";
+  std::string uri_list;
+  for (int i = 0; i < 100; ++i)
+    uri_list += (i ? ",spotify:track:4uLU6hMCjMI75M1A2tKUQ"
+                   : "spotify:track:4uLU6hMCjMI75M1A2tKUQ") +
+                std::to_string(i % 10);
+  std::string padded = "   \t bohemian rhapsody \r\n";
+  cases.push_back({"split/genres", genre_list.size(),
+                   [&genre_list] { return split(genre_list, ',').size(); }});
+  cases.push_back({"split/100_uris", uri_list.size(),
+                   [&uri_list] { return split(uri_list, ',').size(); }});
+  cases.push_back({"trim/padded", padded.size(),
+                   [&padded] { return trim(padded).size(); }});
+  cases.push_back({"trim/clean", ascii_query.size(),
+                   [&ascii_query] { return trim(ascii_query).size(); }});
+
+  NullBuffer discard;
+  std::streambuf *out = std::cout.rdbuf(&discard);
+  std::streambuf *in = std::cin.rdbuf(answers.rdbuf());
+  std::printf("%-36s %9s %12s %7s %9s\n", "case", "bytes", "ns/call",
+              "spread", "MB/s");
+  for (auto &c : cases) {
+    if (c.name.find(filter) == std::string::npos)
+      continue;
+    run(c, samples);
+    std::fflush(stdout);
+  }
+  std::cout.rdbuf(out);
+  std::cin.rdbuf(in);
+  return 0;
+}
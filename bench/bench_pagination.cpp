@@ -0,0 +1,45 @@
+// bench/bench_pagination.cpp
+// Loads one large playlist through the pagination engine with different
+// prefetch windows and reports time-to-first-item, total time and pages/sec.
+// Usage: bench_pagination [tracks] [latency-ms]
+#include "bench_util.h"
+#include "mock_spotify.h"
+#include "spotify_api.h"
+#include "spotify_operations/PlaylistOperations.h"
+#include <cstdlib>
+
+int main(int argc, char **argv) {
+  MockSpotifyConfig config;
+  config.tracks_per_playlist = argc > 1 ? std::atoi(argv[1]) : 3000;
+  config.latency_ms = argc > 2 ? std::atoi(argv[2]) : 20;
+  config.max_page_size = 100;
+
+  MockServer server(make_mock_spotify_handler(config));
+  if (!start_mock_spotify(server))
+    return 1;
+
+  const int windows[] = {1, 2, 4, 8};
+  for (int window : windows) {
+    int pages = 0;
+    size_t items = 0;
+    double first_item_us = 0;
+    auto start = BenchClock::now();
+    bool ok = get_all_playlist_tracks(
+        "bench-token", "pl0",
+        [&](const rapidjson::Value &page, int) {
+          if (pages++ == 0)
+            first_item_us = elapsed_us(start, BenchClock::now());
+          items += page["items"].Size();
+          return true;
+        },
+        window);
+    double total_us = elapsed_us(start, BenchClock::now());
+    std::printf("window=%d %s items=%zu pages=%d first-item=%.1fms "
+                "total=%.1fms %.1f pages/s\n",
+                window, ok ? "ok" : "FAILED", items, pages,
+                first_item_us / 1000, total_us / 1000,
+                pages / (total_us / 1e6));
+  }
+  server.stop();
+  return 0;
+}
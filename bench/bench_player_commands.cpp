@@ -0,0 +1,96 @@
+// bench/bench_player_commands.cpp
+// Replays a held volume key (one change every key-interval ms) followed by a
+// burst of skips, first with the blocking player calls and then through the
+// optimistic command queue, without and with its settle interval. Reports
+// how long each key kept the caller waiting, requests sent, and the time
+// until the last change was confirmed.
+// Usage: bench_player_commands [keys] [key-interval-ms] [latency-ms]
+#include "bench_util.h"
+#include "http_client.h"
+#include "mock_spotify.h"
+#include "spotify_api.h"
+#include "spotify_operations/PlaybackOperations.h"
+#include <cstdlib>
+#include <functional>
+#include <thread>
+
+namespace {
+
+const int kSkips = 3;
+const int kBaseVolume = 40;
+
+uint64_t requests_started() {
+  HttpSchedulerStats stats = http_scheduler_stats();
+  uint64_t total = 0;
+  for (int p = 0; p < kRequestPriorities; ++p)
+    total += stats.started[p];
+  return total;
+}
+
+// Presses keys, each after key_interval_ms or once the previous one returned
+void run(const std::string &label, int keys, int key_interval_ms,
+         const std::function<void(int)> &volume,
+         const std::function<void()> &skip, const std::function<void()> &wait) {
+  uint64_t before = requests_started();
+  std::vector<double> waits;
+  auto start = BenchClock::now();
+  auto next = start;
+  for (int i = 0; i < keys + kSkips; ++i) {
+    std::this_thread::sleep_until(next);
+    auto pressed = BenchClock::now();
+    if (i < keys)
+      volume(kBaseVolume + i);
+    else
+      skip();
+    waits.push_back(elapsed_us(pressed, BenchClock::now()));
+    next = std::max(next + std::chrono::milliseconds(key_interval_ms),
+                    BenchClock::now());
+  }
+  wait();
+  double total_ms = elapsed_us(start, BenchClock::now()) / 1000;
+  std::printf("%s\n", label.c_str());
+  print_latency("  caller blocked per key", waits);
+  std::printf("  %llu requests for %d keys, last change confirmed after "
+              "%.1fms\n",
+              (unsigned long long)(requests_started() - before), keys + kSkips,
+              total_ms);
+}
+
+void run_queue(const std::string &label, PlayerCommands &commands, int keys,
+               int key_interval_ms, const std::string &token) {
+  run(label, keys, key_interval_ms,
+      [&](int volume) { commands.set_volume(token, volume); },
+      [&] { commands.skip(token); }, [&] { commands.wait(); });
+  PlayerCommandStats stats = commands.stats();
+  std::printf("  %llu commands, %llu sent, %llu coalesced, %llu failed\n",
+              (unsigned long long)stats.requested,
+              (unsigned long long)stats.sent,
+              (unsigned long long)stats.coalesced,
+              (unsigned long long)stats.failed);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int keys = argc > 1 ? std::atoi(argv[1]) : 10;
+  int key_interval_ms = argc > 2 ? std::atoi(argv[2]) : 30;
+  MockSpotifyConfig config;
+  config.latency_ms = argc > 3 ? std::atoi(argv[3]) : 50;
+
+  MockServer server(make_mock_spotify_handler(config));
+  if (!start_mock_spotify(server))
+    return 1;
+  const std::string token = "bench-token";
+
+  run("blocking", keys, key_interval_ms,
+      [&token](int volume) { set_volume(token, volume); },
+      [&token] { skip_track(token); }, [] {});
+
+  PlayerCommands immediate(0);
+  run_queue("optimistic, no settle interval", immediate, keys,
+            key_interval_ms, token);
+  run_queue("optimistic, 150ms settle interval", player_commands(), keys,
+            key_interval_ms, token);
+  server.stop();
+  return 0;
+}
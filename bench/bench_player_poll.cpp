@@ -0,0 +1,183 @@
+// bench/bench_player_poll.cpp
+// Plays a scripted session against the mock player (pause, resume, skip,
+// volume, then a long pause) while a cache of the player state is kept fresh
+// by polling me/player at a fixed fast interval, at a fixed slow interval,
+// and with the adaptive poller. Every 100ms the cache is compared with the
+// mock's actual state. Reports requests sent, how often the cache showed the
+// wrong track or play state, and the error of its interpolated progress.
+// Usage: bench_player_poll [seconds] [track-ms] [latency-ms]
+#include "bench_util.h"
+#include "mock_spotify.h"
+#include "player_state.h"
+#include "spotify_api.h"
+#include "spotify_operations/PlaybackOperations.h"
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+const int kSampleIntervalMs = 100;
+
+struct Command {
+  double at; // fraction of the session
+  const char *label;
+  std::function<bool()> send;
+};
+
+std::vector<Command> script() {
+  const std::string token = "bench-token";
+  return {
+      {0.13, "pause", [token] { return pause_music(token); }},
+      {0.27, "play", [token] { return play_music(token); }},
+      {0.40, "next", [token] { return skip_track(token); }},
+      {0.53, "volume", [token] { return set_volume(token, 70); }},
+      {0.67, "pause", [token] { return pause_music(token); }},
+  };
+}
+
+// Source of the cached state under test, and the requests it has sent
+struct Cache {
+  std::function<bool(PlayerState &)> snapshot;
+  std::function<uint64_t()> requests;
+};
+
+// Polls me/player every interval_ms into a cache of its own
+class FixedPoller {
+public:
+  explicit FixedPoller(int interval_ms)
+      : interval_ms_(interval_ms), running_(true), polls_(0), have_(false) {
+    thread_ = std::thread([this] {
+      while (running_) {
+        PlayerState fresh;
+        bool ok = get_player_state("bench-token", fresh);
+        ++polls_;
+        if (ok) {
+          std::lock_guard<std::mutex> lock(mutex_);
+          state_ = fresh;
+          have_ = true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms_));
+      }
+    });
+  }
+  ~FixedPoller() {
+    running_ = false;
+    thread_.join();
+  }
+
+  Cache cache() {
+    return {[this](PlayerState &state) {
+              std::lock_guard<std::mutex> lock(mutex_);
+              state = state_;
+              return have_;
+            },
+            [this] { return polls_.load(); }};
+  }
+
+private:
+  int interval_ms_;
+  std::atomic<bool> running_;
+  std::atomic<uint64_t> polls_;
+  std::mutex mutex_;
+  PlayerState state_;
+  bool have_;
+  std::thread thread_;
+};
+
+void run(const std::string &label, const MockSpotifyConfig &config,
+         double seconds, const std::function<Cache()> &make_cache,
+         const std::function<void()> &finish) {
+  // A fresh server restarts the mock player
+  MockServer server(make_mock_spotify_handler(config));
+  if (!start_mock_spotify(server))
+    std::exit(1);
+  Cache cache = make_cache();
+
+  std::vector<Command> commands = script();
+  size_t next_command = 0;
+  int samples = 0;
+  int wrong = 0;
+  int compared = 0;
+  double progress_error = 0;
+  auto start = BenchClock::now();
+  auto end = start + std::chrono::milliseconds(
+                         static_cast<long>(seconds * 1000));
+  for (auto tick = start; tick < end;
+       tick += std::chrono::milliseconds(kSampleIntervalMs)) {
+    std::this_thread::sleep_until(tick);
+    double fraction = elapsed_us(start, tick) / (seconds * 1e6);
+    while (next_command < commands.size() &&
+           commands[next_command].at <= fraction) {
+      if (!commands[next_command].send())
+        std::printf("  %s failed\n", commands[next_command].label);
+      ++next_command;
+    }
+
+    // The reference read does not count as a poll of the cache under test
+    PlayerState actual;
+    PlayerState cached;
+    if (!get_player_state("bench-token", actual))
+      continue;
+    ++samples;
+    if (!cache.snapshot(cached) || cached.track_uri != actual.track_uri ||
+        cached.playing != actual.playing) {
+      ++wrong;
+      continue;
+    }
+    progress_error += std::abs(cached.progress_at(actual.fetched_at) -
+                               actual.progress_ms);
+    ++compared;
+  }
+  uint64_t requests = cache.requests();
+  finish();
+  server.stop();
+
+  std::printf("%-22s %5llu requests (%5.1f/min) wrong %5.1f%% of %d samples "
+              "progress error %6.1fms\n",
+              label.c_str(), (unsigned long long)requests,
+              requests * 60.0 / seconds, samples ? 100.0 * wrong / samples : 0,
+              samples, compared ? progress_error / compared : 0);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  double seconds = argc > 1 ? std::atof(argv[1]) : 30;
+  MockSpotifyConfig config;
+  config.track_ms = argc > 2 ? std::atoi(argv[2]) : 7000;
+  config.latency_ms = argc > 3 ? std::atoi(argv[3]) : 20;
+  config.etags = false;
+
+  const int fixed[] = {1000, 5000};
+  for (int interval : fixed) {
+    std::unique_ptr<FixedPoller> poller;
+    run("fixed " + std::to_string(interval) + "ms", config, seconds,
+        [&poller, interval] {
+          poller.reset(new FixedPoller(interval));
+          return poller->cache();
+        },
+        [&poller] { poller.reset(); });
+  }
+
+  // Player commands poke the shared poller, so the adaptive run uses it
+  PlayerPoller &poller = player_poller();
+  uint64_t before = 0;
+  run("adaptive", config, seconds,
+      [&poller, &before] {
+        before = poller.stats().polls;
+        poller.start("bench-token");
+        return Cache{[&poller](PlayerState &state) {
+                       return poller.snapshot(state);
+                     },
+                     [&poller, &before] {
+                       return poller.stats().polls - before;
+                     }};
+      },
+      [&poller] { poller.stop(); });
+  return 0;
+}
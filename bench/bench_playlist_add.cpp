@@ -0,0 +1,68 @@
+// bench/bench_playlist_add.cpp
+// Adds the same tracks to a playlist and to the queue one request per track
+// and through the batching paths, and reports tracks/sec for each.
+// Usage: bench_playlist_add [tracks] [latency-ms]
+#include "bench_util.h"
+#include "mock_spotify.h"
+#include "spotify_api.h"
+#include "spotify_operations/PlaylistOperations.h"
+#include "spotify_operations/SearchOperations.h"
+#include <cstdlib>
+
+namespace {
+
+void report(const std::string &label, size_t added, size_t requests,
+            BenchClock::time_point start) {
+  double seconds = elapsed_us(start, BenchClock::now()) / 1e6;
+  std::printf("%-28s added=%-6zu requests=%-6zu %.1fs %.0f tracks/sec\n",
+              label.c_str(), added, requests, seconds, added / seconds);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int count = argc > 1 ? std::atoi(argv[1]) : 500;
+  MockSpotifyConfig config;
+  config.latency_ms = argc > 2 ? std::atoi(argv[2]) : 10;
+
+  MockServer server(make_mock_spotify_handler(config));
+  if (!start_mock_spotify(server))
+    return 1;
+
+  std::vector<std::string> uris;
+  for (int i = 0; i < count; ++i)
+    uris.push_back("spotify:track:bench" + std::to_string(i));
+
+  size_t requests = server.requests_served();
+  size_t added = 0;
+  auto start = BenchClock::now();
+  for (auto &uri : uris)
+    added += add_track_to_playlist("bench-token", "pl0", uri) ? 1 : 0;
+  report("playlist, per track", added, server.requests_served() - requests,
+         start);
+
+  requests = server.requests_served();
+  start = BenchClock::now();
+  added = add_tracks_to_playlist("bench-token", "pl0", uris, 0);
+  report("playlist, 100-URI batches", added,
+         server.requests_served() - requests, start);
+
+  requests = server.requests_served();
+  added = 0;
+  start = BenchClock::now();
+  for (auto &uri : uris)
+    added += add_track_to_queue("bench-token", uri) ? 1 : 0;
+  report("queue, per track", added, server.requests_served() - requests,
+         start);
+
+  const int windows[] = {1, 4, 8};
+  for (int window : windows) {
+    requests = server.requests_served();
+    start = BenchClock::now();
+    added = add_tracks_to_queue("bench-token", uris, window);
+    report("queue, window=" + std::to_string(window), added,
+           server.requests_served() - requests, start);
+  }
+  server.stop();
+  return 0;
+}
@@ -0,0 +1,100 @@
+// bench/bench_playlist_refresh.cpp
+// Requests and time to refresh every playlist of an account with the
+// snapshot_id store: cold (empty store), warm (nothing changed) and after a
+// few playlists were edited. Then the time to open an unchanged playlist
+// from the network and from the store. The store lives in a temporary cache
+// directory.
+// Usage: bench_playlist_refresh [playlists] [edited] [latency-ms]
+#include "bench_util.h"
+#include "mock_spotify.h"
+#include "playlist_store.h"
+#include "spotify_api.h"
+#include "spotify_operations/PlaylistOperations.h"
+#include <cstdlib>
+#include <unistd.h>
+
+namespace {
+
+const char *const kToken = "bench-token";
+
+uint64_t requests_started() {
+  HttpSchedulerStats stats = http_scheduler_stats();
+  uint64_t started = 0;
+  for (int p = 0; p < kRequestPriorities; ++p)
+    started += stats.started[p];
+  return started;
+}
+
+void run_refresh(const char *label) {
+  uint64_t before = requests_started();
+  PlaylistRefresh result;
+  auto start = BenchClock::now();
+  bool ok = refresh_playlists(kToken, result);
+  double ms = elapsed_us(start, BenchClock::now()) / 1000;
+  std::printf("%-24s %s playlists=%zu unchanged=%zu fetched=%zu failed=%zu "
+              "requests=%llu %.1fms\n",
+              label, ok ? "ok" : "FAILED", result.playlists, result.unchanged,
+              result.fetched, result.failed,
+              (unsigned long long)(requests_started() - before), ms);
+}
+
+// Opens pl1, which no run edits, from the network and from the store
+void run_open(const char *label, bool stored) {
+  uint64_t before = requests_started();
+  size_t tracks = 0;
+  auto count = [&tracks](const ItemPage &page, int) {
+    tracks += page.items.size();
+    return true;
+  };
+  auto start = BenchClock::now();
+  if (stored)
+    get_playlist_track_items_cached(kToken, "pl1", "snap-pl1-1", count);
+  else
+    get_all_playlist_track_items(kToken, "pl1", count);
+  std::printf("%-24s tracks=%zu requests=%llu %.2fms\n", label, tracks,
+              (unsigned long long)(requests_started() - before),
+              elapsed_us(start, BenchClock::now()) / 1000);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  MockSpotifyConfig config;
+  config.playlists = argc > 1 ? std::atoi(argv[1]) : 300;
+  int edited = argc > 2 ? std::atoi(argv[2]) : 10;
+  config.latency_ms = argc > 3 ? std::atoi(argv[3]) : 20;
+  config.tracks_per_playlist = 150;
+  config.max_page_size = 100;
+
+  char cache[] = "/tmp/bench_playlist_refresh.XXXXXX";
+  if (!mkdtemp(cache)) {
+    std::perror("mkdtemp");
+    return 1;
+  }
+  setenv("XDG_CACHE_HOME", cache, 1);
+
+  MockServer server(make_mock_spotify_handler(config));
+  if (!start_mock_spotify(server))
+    return 1;
+
+  run_refresh("cold");
+  run_refresh("warm, unchanged");
+  for (int i = 0; i < edited; ++i) {
+    std::string id = "pl" + std::to_string(i * 7 % config.playlists);
+    add_tracks_to_playlist(kToken, id, {"spotify:track:bench"});
+  }
+  char label[32];
+  std::snprintf(label, sizeof(label), "%d edited", edited);
+  run_refresh(label);
+
+  run_open("open pl1, network", false);
+  run_open("open pl1, stored", true);
+
+  PlaylistStoreStats stats = playlist_store().stats();
+  std::printf("store: hits=%llu misses=%llu saves=%llu (in %s)\n",
+              (unsigned long long)stats.hits,
+              (unsigned long long)stats.misses,
+              (unsigned long long)stats.saves, cache);
+  server.stop();
+  return 0;
+}
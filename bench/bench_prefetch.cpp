@@ -0,0 +1,108 @@
+// bench/bench_prefetch.cpp
+// Time from picking a playlist to its first page of tracks, as in the
+// playlist menu: once with a plain fetch, once with the first pages of the
+// top of the list prefetched at background priority while the user "reads"
+// the list for think-ms. Three picks in four are in the prefetched top four.
+// Then under a client rate limit of rate-limit requests per second, the last
+// of the top four picked at once, while its prefetch is still queued behind
+// the budget background requests leave unused. Reports the prefetcher's hit
+// rate and wasted bytes.
+// Usage: bench_prefetch [rounds] [latency-ms] [think-ms] [rate-limit]
+#include "bench_util.h"
+#include "mock_spotify.h"
+#include "page_prefetch.h"
+#include "spotify_api.h"
+#include "spotify_operations/PlaylistOperations.h"
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+namespace {
+
+const int kPrefetched = 4;
+const char *const kToken = "bench-token";
+
+// The URL playlist_menu prefetches and get_all_playlist_track_items asks for
+std::string first_page_url(int playlist) {
+  return spotify_api_url("/playlists/pl" + std::to_string(playlist) +
+                         "/tracks?limit=100&offset=0");
+}
+
+// Microseconds until the first page of the playlist's tracks arrives
+double first_page_us(int playlist) {
+  auto start = BenchClock::now();
+  double us = 0;
+  get_all_playlist_track_items(kToken, "pl" + std::to_string(playlist),
+                               [&](const ItemPage &, int) {
+                                 us = elapsed_us(start, BenchClock::now());
+                                 return false;
+                               });
+  return us;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int rounds = argc > 1 ? std::atoi(argv[1]) : 40;
+  MockSpotifyConfig config;
+  config.latency_ms = argc > 2 ? std::atoi(argv[2]) : 50;
+  int think_ms = argc > 3 ? std::atoi(argv[3]) : 200;
+  double rate_limit = argc > 4 ? std::atof(argv[4]) : 4;
+  config.max_page_size = 100;
+
+  MockServer server(make_mock_spotify_handler(config));
+  if (!start_mock_spotify(server))
+    return 1;
+
+  std::vector<double> plain, prefetched;
+  for (int round = 0; round < rounds; ++round) {
+    int pick = round % 4 == 3 ? kPrefetched + round % 30 : round % kPrefetched;
+    std::this_thread::sleep_for(std::chrono::milliseconds(think_ms));
+    plain.push_back(first_page_us(pick));
+
+    for (int p = 0; p < kPrefetched; ++p)
+      page_prefetcher().prefetch(kToken, first_page_url(p),
+                                 ItemView::TRACK_ITEMS);
+    std::this_thread::sleep_for(std::chrono::milliseconds(think_ms));
+    prefetched.push_back(first_page_us(pick));
+    page_prefetcher().discard();
+  }
+  print_latency("first page, plain", plain);
+  print_latency("first page, prefetched", prefetched);
+
+  // A burst of kPrefetched leaves the last prefetch waiting for the budget
+  // background requests leave unused; that one is picked at once. The
+  // budget refills between rounds.
+  http_set_rate_limit(rate_limit, kPrefetched);
+  plain.clear();
+  prefetched.clear();
+  int refill_ms = static_cast<int>(kPrefetched * 1000 / rate_limit);
+  for (int round = 0; round < rounds / 4; ++round) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(refill_ms));
+    plain.push_back(first_page_us(kPrefetched - 1));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(refill_ms));
+    for (int p = 0; p < kPrefetched; ++p)
+      page_prefetcher().prefetch(kToken, first_page_url(p),
+                                 ItemView::TRACK_ITEMS);
+    prefetched.push_back(first_page_us(kPrefetched - 1));
+    page_prefetcher().discard();
+  }
+  std::printf("with a client rate limit of %.0f/s, picked at once:\n",
+              rate_limit);
+  print_latency("first page, plain", plain);
+  print_latency("first page, prefetch pending", prefetched);
+
+  PrefetchStats stats = page_prefetcher().stats();
+  std::printf("prefetched=%llu hits=%llu misses=%llu hit-rate=%.0f%% "
+              "wasted=%llu promoted=%llu bytes-used=%llu bytes-wasted=%llu\n",
+              (unsigned long long)stats.started,
+              (unsigned long long)stats.hits,
+              (unsigned long long)stats.misses, stats.hit_ratio() * 100,
+              (unsigned long long)stats.wasted,
+              (unsigned long long)stats.promoted,
+              (unsigned long long)stats.bytes_used,
+              (unsigned long long)stats.bytes_wasted);
+  server.stop();
+  return 0;
+}
@@ -0,0 +1,95 @@
+// bench/bench_rate_limit.cpp
+// Runs a burst of background requests against a mock that answers 429 above
+// a fixed rate, while player commands are sent every 100ms, first with no
+// client-side budget and then with one under the server's limit. Reports
+// 429s, retries, background completion time, command latency and queue wait
+// per priority.
+// Usage: bench_rate_limit [requests] [server-rate] [latency-ms]
+#include "bench_util.h"
+#include "http_client.h"
+#include "mock_spotify.h"
+#include "spotify_api.h"
+#include "spotify_operations/PlaybackOperations.h"
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+
+namespace {
+
+const int kBackgroundConcurrency = 16;
+const int kCommandIntervalMs = 100;
+
+void run(const std::string &label, int requests, double client_rate) {
+  // A short burst keeps the first second under the server's fixed window
+  http_set_rate_limit(client_rate, client_rate / 4);
+  HttpSchedulerStats before = http_scheduler_stats();
+
+  std::atomic<bool> done(false);
+  int succeeded = 0;
+  double background_ms = 0;
+  std::thread background([&] {
+    RequestPriorityScope scope(RequestPriority::BACKGROUND);
+    std::vector<std::string> urls(requests,
+                                  spotify_api_url("/me/tracks?limit=1"));
+    auto start = BenchClock::now();
+    std::vector<bool> results = spotify_send_batch(
+        "bench-token", "GET", urls, kBackgroundConcurrency);
+    background_ms = elapsed_us(start, BenchClock::now()) / 1000;
+    for (bool ok : results)
+      succeeded += ok;
+    done = true;
+  });
+
+  std::vector<double> commands;
+  int failed_commands = 0;
+  while (!done) {
+    auto start = BenchClock::now();
+    if (!pause_music("bench-token"))
+      ++failed_commands;
+    commands.push_back(elapsed_us(start, BenchClock::now()));
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(kCommandIntervalMs));
+  }
+  background.join();
+
+  HttpSchedulerStats after = http_scheduler_stats();
+  std::printf("%s\n", label.c_str());
+  std::printf("  background: %d/%d ok in %.1fms, 429s=%llu retried=%llu\n",
+              succeeded, requests, background_ms,
+              (unsigned long long)(after.throttled - before.throttled),
+              (unsigned long long)(after.retried - before.retried));
+  print_latency("  player commands", commands);
+  if (failed_commands)
+    std::printf("  %d player commands failed\n", failed_commands);
+  const char *const names[kRequestPriorities] = {"interactive", "normal",
+                                                 "background"};
+  for (int p = 0; p < kRequestPriorities; ++p) {
+    uint64_t started = after.started[p] - before.started[p];
+    if (!started)
+      continue;
+    std::printf("  %-12s started=%llu mean-wait=%.1fms max-queued=%zu\n",
+                names[p], (unsigned long long)started,
+                (after.total_wait_ms[p] - before.total_wait_ms[p]) / started,
+                after.max_queued[p]);
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int requests = argc > 1 ? std::atoi(argv[1]) : 300;
+  MockSpotifyConfig config;
+  config.rate_limit = argc > 2 ? std::atoi(argv[2]) : 50;
+  config.latency_ms = argc > 3 ? std::atoi(argv[3]) : 10;
+
+  MockServer server(make_mock_spotify_handler(config));
+  if (!start_mock_spotify(server))
+    return 1;
+
+  run("no client budget", requests, 0);
+  // Let the server's window empty before the next run
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+  run("budget of 80% of the server limit", requests, config.rate_limit * 0.8);
+  server.stop();
+  return 0;
+}
@@ -0,0 +1,95 @@
+// bench/bench_render.cpp
+// Compares printing every line of a long list, as the menus did, with
+// drawing it in a full-screen list view and sending only the cells that
+// changed. Rendering is off screen, so the numbers are the bytes a terminal
+// would receive and the time spent producing them.
+// Usage: bench_render [rows] [frames]
+#include "bench_util.h"
+#include "list_view.h"
+#include "name_generator.h"
+#include <cstdlib>
+#include <sstream>
+
+namespace {
+
+const int kScreenRows = 50;
+const int kScreenCols = 120;
+
+struct FrameTotals {
+  double us = 0;
+  size_t bytes = 0;
+  size_t cells = 0;
+  int frames = 0;
+};
+
+void frame(Screen &screen, ListView &view, FrameTotals &totals) {
+  auto start = BenchClock::now();
+  view.draw(screen);
+  screen.present();
+  totals.us += elapsed_us(start, BenchClock::now());
+  totals.bytes += screen.frame_stats().bytes_written;
+  totals.cells += screen.frame_stats().cells_changed;
+  ++totals.frames;
+}
+
+void report(const char *label, const FrameTotals &totals) {
+  std::printf("  %-16s %8.1fus/frame %8zu bytes/frame %6zu cells/frame\n",
+              label, totals.us / totals.frames, totals.bytes / totals.frames,
+              totals.cells / totals.frames);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  size_t rows = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 5000;
+  int frames = argc > 2 ? std::atoi(argv[2]) : 200;
+
+  std::mt19937 rng(42);
+  std::vector<std::string> lines;
+  for (size_t i = 0; i < rows; ++i)
+    lines.push_back(make_name(rng) + " (URI: spotify:track:" +
+                    std::to_string(1000000 + i) + ")");
+  RowText row_text = [&lines](size_t index) { return lines[index]; };
+
+  auto start = BenchClock::now();
+  std::ostringstream printed;
+  for (size_t i = 0; i < rows; ++i)
+    printed << i + 1 << ". " << row_text(i) << "\n";
+  double print_us = elapsed_us(start, BenchClock::now());
+  std::printf("print every line: %.1fus, %zu bytes for %zu rows\n", print_us,
+              printed.str().size(), rows);
+
+  Screen screen;
+  screen.resize(kScreenRows, kScreenCols);
+  ListView view("Tracks", rows, row_text);
+  std::printf("list view on a %dx%d screen:\n", kScreenRows, kScreenCols);
+
+  FrameTotals first;
+  frame(screen, view, first);
+  report("first frame", first);
+
+  FrameTotals line;
+  for (int i = 0; i < frames; ++i) {
+    view.handle_key(KeyEvent(Key::DOWN));
+    frame(screen, view, line);
+  }
+  report("next row", line);
+
+  FrameTotals page;
+  for (int i = 0; i < frames; ++i) {
+    view.handle_key(KeyEvent(Key::PAGE_DOWN));
+    frame(screen, view, page);
+  }
+  report("next page", page);
+
+  FrameTotals unchanged;
+  for (int i = 0; i < frames; ++i)
+    frame(screen, view, unchanged);
+  report("unchanged", unchanged);
+
+  const FrameStats &stats = screen.frame_stats();
+  std::printf("slowest present %.3fms, %llu of %llu over the %.0fms budget\n",
+              stats.max_ms, (unsigned long long)stats.over_budget,
+              (unsigned long long)stats.frames, kFrameBudgetMs);
+  return 0;
+}
@@ -0,0 +1,174 @@
+// bench/bench_request_builder.cpp
+// Time and heap allocations to build the parts of a request: a search URL,
+// JSON bodies and the Authorization header list, each the way it was built
+// before the request builder and through it. Then whole requests sent to
+// the mock with the header list built per request and with the shared one;
+// those allocation counts are process-wide, so they include cURL and the
+// mock server thread.
+// Usage: bench_request_builder [iterations] [requests]
+#include "alloc_counter.h"
+#include "bench_util.h"
+#include "mock_spotify.h"
+#include "request_builder.h"
+#include "spotify_api.h"
+#include "utils.h"
+#include <cstdlib>
+#include <curl/curl.h>
+
+namespace {
+
+// As long as a real access token
+const std::string kToken =
+    "BQDa8Pq3_y5hXz0xJm1tQ2nR7kLw9vE4cU6iO0pA3sD5fG7hJ9kL1zX3cV5bN7mQ9wE1r"
+    "T3yU5iO7pA9sD1fG3hJ5kL7zX9cV1bN3mQ5wE7rT3yU5iO7pA9sD1fG3hJ5kL7zX9cV1b";
+
+volatile size_t sink;
+
+// The encoder before the table: a cURL handle per call
+std::string previous_url_encode(const std::string &value) {
+  CURL *curl = curl_easy_init();
+  if (curl) {
+    char *output =
+        curl_easy_escape(curl, value.c_str(), static_cast<int>(value.length()));
+    if (output) {
+      std::string encoded(output);
+      curl_free(output);
+      curl_easy_cleanup(curl);
+      return encoded;
+    }
+    curl_easy_cleanup(curl);
+  }
+  return "";
+}
+
+// Mean ns and allocations per call of fn
+template <typename Fn> void run(const char *label, int iterations, Fn fn) {
+  for (int i = 0; i < iterations / 10; ++i)
+    sink = sink + fn();
+  uint64_t allocations_before = allocation_count();
+  auto start = BenchClock::now();
+  for (int i = 0; i < iterations; ++i)
+    sink = sink + fn();
+  double us = elapsed_us(start, BenchClock::now());
+  std::printf("%-36s %9.1f ns %7.2f allocs\n", label, us * 1000 / iterations,
+              double(allocation_count() - allocations_before) / iterations);
+}
+
+// Allocations and mean latency per request sent one at a time
+template <typename Fn>
+void run_requests(const char *label, int requests, Fn fn) {
+  fn();
+  uint64_t allocations_before = allocation_count();
+  auto start = BenchClock::now();
+  int failed = 0;
+  for (int i = 0; i < requests; ++i)
+    failed += fn() ? 0 : 1;
+  double us = elapsed_us(start, BenchClock::now());
+  std::printf("%-36s %9.1f us %7.2f allocs%s\n", label, us / requests,
+              double(allocation_count() - allocations_before) / requests,
+              failed ? " FAILED" : "");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int iterations = argc > 1 ? std::atoi(argv[1]) : 200000;
+  int requests = argc > 2 ? std::atoi(argv[2]) : 2000;
+
+  MockSpotifyConfig config;
+  config.latency_ms = 0;
+  MockServer server(make_mock_spotify_handler(config));
+  if (!start_mock_spotify(server))
+    return 1;
+
+  const std::string query = "Beyoncé & Jay-Z: Crazy in Love";
+  const std::string uri = "spotify:track:4uLU6hMCjMI75M1A2tKUQQ";
+  std::vector<std::string> uris(50, uri);
+
+  std::printf("=== URLs ===\n");
+  run("search url, previous", iterations, [&] {
+    return (spotify_api_url("/search?q=") + previous_url_encode(query) +
+            "&type=track&limit=" + std::to_string(20))
+        .size();
+  });
+  run("search url, UrlBuilder", iterations, [&] {
+    UrlBuilder url(spotify_api_url("/search"));
+    return url.param("q", query)
+        .param("type", "track")
+        .param("limit", 20)
+        .str()
+        .size();
+  });
+  UrlBuilder reused(spotify_api_url("/search"));
+  run("search url, reused UrlBuilder", iterations, [&] {
+    return reused.reset()
+        .param("q", query)
+        .param("type", "track")
+        .param("limit", 20)
+        .str()
+        .size();
+  });
+  UrlBuilder queue(spotify_api_url("/me/player/queue"));
+  run("queue url, reused UrlBuilder", iterations,
+      [&] { return queue.reset().param("uri", uri).str().size(); });
+
+  std::printf("=== JSON bodies ===\n");
+  run("play body, previous", iterations, [&] {
+    return (std::string("{ \"uris\": [\"") + uri + "\"] }").size();
+  });
+  run("play body, json_string_array_body", iterations,
+      [&] { return json_string_array_body("uris", uri).size(); });
+  run("50 ids, previous", iterations / 10, [&] {
+    std::string body = "{\"ids\":[";
+    for (size_t i = 0; i < uris.size(); ++i) {
+      if (i)
+        body += ",";
+      body += "\"" + spotify_id_from_uri(uris[i]) + "\"";
+    }
+    return (body + "]}").size();
+  });
+  JsonBuilder body;
+  run("50 ids, reused JsonBuilder", iterations / 10, [&] {
+    body.clear().begin_object().key("ids").begin_array();
+    for (auto &u : uris)
+      body.value(spotify_id_from_uri(u));
+    return body.end_array().end_object().str().size();
+  });
+
+  std::printf("=== Authorization header ===\n");
+  run("header list, previous", iterations, [&] {
+    std::vector<std::string> headers;
+    headers.push_back("Authorization: Bearer " + kToken);
+    struct curl_slist *list = NULL;
+    for (auto &header : headers)
+      list = curl_slist_append(list, header.c_str());
+    curl_slist_free_all(list);
+    return headers.size();
+  });
+  run("header list, spotify_auth_headers", iterations, [&] {
+    return spotify_auth_headers(kToken, false)->lines().size();
+  });
+
+  std::printf("=== Requests to the mock ===\n");
+  std::string volume = spotify_api_url("/me/player/volume?volume_percent=50");
+  run_requests("PUT, headers per request", requests, [&] {
+    HttpRequest request;
+    request.method = "PUT";
+    request.url = volume;
+    request.headers.push_back("Authorization: Bearer " + kToken);
+    HttpResponse response;
+    return http_perform(request, response) && response.status < 300;
+  });
+  run_requests("PUT, shared header list", requests, [&] {
+    HttpRequest request;
+    request.method = "PUT";
+    request.url = volume;
+    request.shared_headers = spotify_auth_headers(kToken, false);
+    HttpResponse response;
+    return http_perform(request, response) && response.status < 300;
+  });
+  run_requests("spotify_send", requests,
+               [&] { return spotify_send(kToken, "PUT", volume); });
+  server.stop();
+  return 0;
+}
@@ -0,0 +1,109 @@
+// bench/bench_request_stats.cpp
+// Cost of recording a request in the per-endpoint statistics, from one
+// thread and from several at once; how far the histogram's percentiles are
+// from the exact ones; and the report for a mix of requests sent to the mock.
+// Usage: bench_request_stats [requests] [latency-ms]
+#include "bench_util.h"
+#include "mock_spotify.h"
+#include "request_stats.h"
+#include "spotify_api.h"
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+
+namespace {
+
+const int kRecords = 1000000;
+const int kThreads = 4;
+
+HttpRequest sample_request(int i) {
+  HttpRequest request;
+  request.url = "https://api.spotify.com/v1/playlists/"
+                "37i9dQZF1DXcBWIGoYBM5M/tracks?offset=" +
+                std::to_string(i % 1000 * 100) + "&limit=100";
+  return request;
+}
+
+// Nanoseconds per record_transfer, each thread recording records / threads
+double record_cost_ns(int threads) {
+  RequestStats stats;
+  HttpResponse response;
+  response.transport_ok = true;
+  response.status = 200;
+  response.body.assign(4096, ' ');
+  response.timings.first_byte_us = 40000;
+  response.timings.total_us = 42000;
+  std::vector<HttpRequest> requests;
+  for (int i = 0; i < 1000; ++i)
+    requests.push_back(sample_request(i));
+
+  auto start = BenchClock::now();
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t) {
+    workers.push_back(std::thread([&stats, &requests, &response, threads] {
+      for (int i = 0; i < kRecords / threads; ++i)
+        stats.record_transfer(requests[i % requests.size()], response);
+    }));
+  }
+  for (auto &worker : workers)
+    worker.join();
+  return elapsed_us(start, BenchClock::now()) * 1000 / kRecords;
+}
+
+// Largest relative difference between histogram and exact percentiles of
+// log-normal latencies around 50ms
+void check_accuracy() {
+  std::mt19937 rng(11);
+  std::lognormal_distribution<double> latency(std::log(50000.0), 0.8);
+  LatencyHistogram histogram;
+  std::vector<double> exact;
+  for (int i = 0; i < 100000; ++i) {
+    uint64_t us = static_cast<uint64_t>(latency(rng));
+    histogram.record(us);
+    exact.push_back(static_cast<double>(us));
+  }
+  std::sort(exact.begin(), exact.end());
+  const double percents[] = {50, 90, 99, 99.9};
+  for (double percent : percents) {
+    double want = exact[static_cast<size_t>(percent / 100 * exact.size()) - 1];
+    double got = static_cast<double>(histogram.percentile(percent));
+    std::printf("p%-5g exact %10.0fus histogram %10.0fus error %+.2f%%\n",
+                percent, want, got, (got - want) / want * 100);
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int requests = argc > 1 ? std::atoi(argv[1]) : 200;
+  MockSpotifyConfig config;
+  config.latency_ms = argc > 2 ? std::atoi(argv[2]) : 5;
+
+  std::printf("record_transfer, 1 thread:  %6.0f ns\n", record_cost_ns(1));
+  std::printf("record_transfer, %d threads: %6.0f ns\n", kThreads,
+              record_cost_ns(kThreads));
+  check_accuracy();
+
+  MockServer server(make_mock_spotify_handler(config));
+  if (!start_mock_spotify(server))
+    return 1;
+  const std::string token = "bench-token";
+  request_stats().clear();
+  for (int i = 0; i < requests; ++i) {
+    ItemPage page;
+    spotify_get_items(token,
+                      spotify_api_url("/playlists/pl" +
+                                      std::to_string(i % 5) +
+                                      "/tracks?limit=100"),
+                      ItemView::TRACK_ITEMS, page);
+    if (i % 4 == 0)
+      spotify_send(token, "PUT", spotify_api_url("/me/player/volume?"
+                                                 "volume_percent=50"));
+  }
+  std::printf("\n");
+  write_request_stats(std::cout, request_stats().snapshot());
+  server.stop();
+  return 0;
+}
@@ -0,0 +1,76 @@
+// bench/bench_requests.cpp
+// Latency and throughput of each client request path against the local
+// stand-in. Usage: bench_requests [iterations] [latency-ms]
+#include "bench_util.h"
+#include "mock_spotify.h"
+#include "spotify_api.h"
+#include "spotify_operations/LibraryOperations.h"
+#include "spotify_operations/PlaybackOperations.h"
+#include "spotify_operations/PlaylistOperations.h"
+#include "spotify_operations/RecommendationsOperations.h"
+#include "spotify_operations/SearchOperations.h"
+#include <cstdlib>
+#include <functional>
+
+namespace {
+
+const std::string kToken = "bench-token";
+
+void run(const std::string &label, int iterations,
+         const std::function<bool()> &request) {
+  std::vector<double> samples;
+  int failures = 0;
+  auto begin = BenchClock::now();
+  for (int i = 0; i < iterations; ++i) {
+    auto start = BenchClock::now();
+    if (!request())
+      ++failures;
+    samples.push_back(elapsed_us(start, BenchClock::now()));
+  }
+  double seconds = elapsed_us(begin, BenchClock::now()) / 1e6;
+  print_latency(label, samples);
+  std::printf("  %.1f req/s, %d failures\n", iterations / seconds, failures);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int iterations = argc > 1 ? std::atoi(argv[1]) : 500;
+  MockSpotifyConfig config;
+  config.latency_ms = argc > 2 ? std::atoi(argv[2]) : 0;
+
+  MockServer server(make_mock_spotify_handler(config));
+  if (!start_mock_spotify(server))
+    return 1;
+
+  run("get_user_playlists", iterations, [] {
+    rapidjson::Document doc;
+    return get_user_playlists(kToken, doc, 50);
+  });
+  run("get_playlist_tracks", iterations, [] {
+    rapidjson::Document doc;
+    return get_playlist_tracks(kToken, "pl0", doc, 50);
+  });
+  run("get_saved_tracks", iterations, [] {
+    rapidjson::Document doc;
+    return get_saved_tracks(kToken, doc, 50);
+  });
+  run("search_spotify", iterations, [] {
+    rapidjson::Document doc;
+    return search_spotify(kToken, "bench query", SearchType::TRACK, doc);
+  });
+  run("get_available_genres", iterations, [] {
+    rapidjson::Document doc;
+    return get_available_genres(kToken, doc);
+  });
+  run("get_recommendations", iterations, [] {
+    rapidjson::Document doc;
+    return get_recommendations(kToken, {"rock", "jazz"}, doc);
+  });
+  run("set_volume", iterations, [] { return set_volume(kToken, 50); });
+
+  std::printf("connections opened: %zu, requests served: %zu\n",
+              server.connections_accepted(), server.requests_served());
+  server.stop();
+  return 0;
+}
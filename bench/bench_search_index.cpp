@@ -0,0 +1,60 @@
+// bench/bench_search_index.cpp
+// Builds the local search index over synthetic track, artist, album and
+// playlist names and times exact, prefix, case-folded and misspelled queries.
+// Usage: bench_search_index [entries] [queries]
+#include "bench_util.h"
+#include "name_generator.h"
+#include "search_index.h"
+#include <cctype>
+#include <cstdlib>
+
+int main(int argc, char **argv) {
+  int count = argc > 1 ? std::atoi(argv[1]) : 100000;
+  int queries = argc > 2 ? std::atoi(argv[2]) : 2000;
+  std::mt19937 rng(42);
+
+  std::vector<std::string> names;
+  for (int i = 0; i < count; ++i)
+    names.push_back(make_name(rng));
+
+  SearchIndex index;
+  auto start = BenchClock::now();
+  for (int i = 0; i < count; ++i) {
+    LocalKind kind = static_cast<LocalKind>(i % 4);
+    index.add(kind, names[i], "spotify:mock:" + std::to_string(i));
+  }
+  std::printf("indexed %zu entries in %.1fms\n", index.size(),
+              elapsed_us(start, BenchClock::now()) / 1000);
+
+  std::uniform_int_distribution<int> pick(0, count - 1);
+  const char *labels[] = {"exact", "prefix", "upper case", "misspelled"};
+  for (int mode = 0; mode < 4; ++mode) {
+    std::vector<double> samples;
+    size_t found = 0;
+    for (int q = 0; q < queries; ++q) {
+      int target = pick(rng);
+      std::string query = names[target];
+      if (mode == 1) {
+        query = query.substr(0, std::min<size_t>(query.size(), 5));
+      } else if (mode == 2) {
+        for (char &c : query)
+          c = static_cast<char>(std::toupper(c));
+      } else if (mode == 3 && query.size() > 4) {
+        std::swap(query[2], query[3]);
+      }
+      auto begin = BenchClock::now();
+      std::vector<LocalHit> hits = index.search(query, 10);
+      samples.push_back(elapsed_us(begin, BenchClock::now()));
+      for (auto &hit : hits) {
+        if (hit.name == names[target]) {
+          ++found;
+          break;
+        }
+      }
+    }
+    print_latency(labels[mode], samples);
+    std::printf("%-32s target in top 10: %.1f%%\n", "",
+                100.0 * found / queries);
+  }
+  return 0;
+}
@@ -0,0 +1,54 @@
+// bench/bench_session.cpp
+// Measures startup authentication from a saved session: a still-valid access
+// token needs no request, an expired one a single refresh against the mock
+// accounts service.
+// Usage: bench_session [iterations] [latency-ms]
+#include "bench_util.h"
+#include "mock_spotify.h"
+#include "spotify_api.h"
+#include "spotify_auth.h"
+#include <cstdlib>
+#include <ctime>
+#include <unistd.h>
+
+int main(int argc, char **argv) {
+  int iterations = argc > 1 ? std::atoi(argv[1]) : 200;
+  MockSpotifyConfig config;
+  config.latency_ms = argc > 2 ? std::atoi(argv[2]) : 20;
+
+  MockServer server(make_mock_spotify_handler(config));
+  if (!start_mock_spotify(server))
+    return 1;
+  std::string path = "/tmp/bench_session." + std::to_string(getpid());
+
+  SpotifySession saved;
+  saved.client_id = "bench-client";
+  saved.client_secret = "bench-secret";
+  saved.access_token = "bench-access-token";
+  saved.refresh_token = "bench-refresh-token";
+
+  const char *labels[] = {"valid access token", "expired access token"};
+  for (int expired = 0; expired < 2; ++expired) {
+    std::vector<double> samples;
+    size_t requests_before = server.requests_served();
+    for (int i = 0; i < iterations; ++i) {
+      saved.expires_at = std::time(nullptr) + (expired ? -10 : 3600);
+      save_session(path, saved);
+      SpotifySession session;
+      auto start = BenchClock::now();
+      bool ok = resume_session(path, session);
+      samples.push_back(elapsed_us(start, BenchClock::now()));
+      if (!ok) {
+        std::fprintf(stderr, "resume failed\n");
+        return 1;
+      }
+    }
+    print_latency(labels[expired], samples);
+    std::printf("%-32s requests/start=%.1f\n", "",
+                double(server.requests_served() - requests_before) /
+                    iterations);
+  }
+  unlink(path.c_str());
+  server.stop();
+  return 0;
+}
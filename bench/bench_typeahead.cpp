@@ -0,0 +1,99 @@
+// bench/bench_typeahead.cpp
+// Types queries into the type-ahead search against the mock Web API: bursts
+// of keys, a pause, then backspacing to a prefix and typing on. Compares no
+// debounce with the default interval by requests sent, requests cancelled and
+// keystroke-to-results latency.
+// Usage: bench_typeahead [latency-ms] [key-interval-ms]
+#include "bench_util.h"
+#include "mock_spotify.h"
+#include "spotify_api.h"
+#include "typeahead_search.h"
+#include <cstdlib>
+#include <poll.h>
+
+namespace {
+
+const char *kQueries[] = {"daft punk", "radiohead", "massive attack",
+                          "portishead", "boards of canada"};
+
+// Waits for results until deadline, recording the latency of each one
+void pump(TypeAheadSearch &search, TypeAheadClock::time_point deadline,
+          std::vector<double> &network, std::vector<double> &cached) {
+  while (true) {
+    auto now = TypeAheadClock::now();
+    if (now >= deadline)
+      return;
+    int timeout = static_cast<int>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now)
+            .count());
+    int due = search.poll();
+    if (due >= 0 && due < timeout)
+      timeout = due;
+    struct pollfd fd = {search.wake_fd(), POLLIN, 0};
+    ::poll(&fd, 1, std::max(timeout, 1));
+    TypeAheadResult result;
+    if (search.take_result(result)) {
+      double us = elapsed_us(result.keystroke_at, TypeAheadClock::now());
+      (result.from_cache ? cached : network).push_back(us);
+    }
+  }
+}
+
+void type_queries(int debounce_ms, int key_interval_ms) {
+  TypeAheadSearch search("bench-token", SearchType::TRACK, 10, debounce_ms);
+  std::vector<double> network;
+  std::vector<double> cached;
+  auto key = std::chrono::milliseconds(key_interval_ms);
+  auto pause = std::chrono::milliseconds(600);
+  for (const char *text : kQueries) {
+    std::string query;
+    std::string full = text;
+    for (char c : full) {
+      query += c;
+      search.set_query(query);
+      pump(search, TypeAheadClock::now() + key, network, cached);
+    }
+    pump(search, TypeAheadClock::now() + pause, network, cached);
+    // Delete back to the first word and retype the rest
+    size_t space = full.find(' ');
+    size_t keep = space == std::string::npos ? full.size() / 2 : space;
+    while (query.size() > keep) {
+      query.pop_back();
+      search.set_query(query);
+      pump(search, TypeAheadClock::now() + key, network, cached);
+    }
+    for (size_t i = keep; i < full.size(); ++i) {
+      query += full[i];
+      search.set_query(query);
+      pump(search, TypeAheadClock::now() + key, network, cached);
+    }
+    pump(search, TypeAheadClock::now() + pause, network, cached);
+  }
+
+  TypeAheadStats stats = search.stats();
+  std::printf("debounce %dms: keystrokes=%llu requests=%llu cancelled=%llu "
+              "cache_hits=%llu\n",
+              debounce_ms, static_cast<unsigned long long>(stats.keystrokes),
+              static_cast<unsigned long long>(stats.requests),
+              static_cast<unsigned long long>(stats.cancelled),
+              static_cast<unsigned long long>(stats.cache_hits));
+  print_latency("  keystroke to network result", network);
+  print_latency("  keystroke to cached result", cached);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  MockSpotifyConfig config;
+  config.latency_ms = argc > 1 ? std::atoi(argv[1]) : 80;
+  int key_interval_ms = argc > 2 ? std::atoi(argv[2]) : 60;
+
+  MockServer server(make_mock_spotify_handler(config));
+  if (!start_mock_spotify(server))
+    return 1;
+
+  type_queries(0, key_interval_ms);
+  type_queries(TypeAheadSearch::kDefaultDebounceMs, key_interval_ms);
+  server.stop();
+  return 0;
+}
@@ -0,0 +1,37 @@
+// bench/bench_util.h
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+typedef std::chrono::steady_clock BenchClock;
+
+inline double elapsed_us(BenchClock::time_point start,
+                         BenchClock::time_point end) {
+  return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+// Sorts the samples and prints mean, p50, p95 and p99 in microseconds
+inline void print_latency(const std::string &label,
+                          std::vector<double> samples) {
+  if (samples.empty())
+    return;
+  std::sort(samples.begin(), samples.end());
+  double sum = 0;
+  for (double s : samples)
+    sum += s;
+  auto pct = [&samples](double p) {
+    size_t index = static_cast<size_t>(p * (samples.size() - 1));
+    return samples[index];
+  };
+  std::printf("%-32s n=%-6zu mean=%9.1fus p50=%9.1fus p95=%9.1fus "
+              "p99=%9.1fus\n",
+              label.c_str(), samples.size(), sum / samples.size(), pct(0.50),
+              pct(0.95), pct(0.99));
+}
+
+#endif // BENCH_UTIL_H
@@ -0,0 +1,198 @@
+// bench/mock_server.cpp
+#include "mock_server.h"
+#include <arpa/inet.h>
+#include <cctype>
+#include <cstdlib>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+const int kPollIntervalMs = 100;
+
+const char *status_text(int status) {
+  switch (status) {
+  case 200:
+    return "OK";
+  case 201:
+    return "Created";
+  case 204:
+    return "No Content";
+  case 304:
+    return "Not Modified";
+  case 400:
+    return "Bad Request";
+  case 401:
+    return "Unauthorized";
+  case 404:
+    return "Not Found";
+  case 429:
+    return "Too Many Requests";
+  default:
+    return "Error";
+  }
+}
+
+std::string lowercase(std::string s) {
+  for (auto &c : s)
+    c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  return s;
+}
+
+} // namespace
+
+MockServer::MockServer(Handler handler)
+    : handler_(handler), listen_fd_(-1), port_(0), running_(false),
+      connections_(0), requests_(0) {
+  if (!handler_) {
+    handler_ = [](const MockRequest &) {
+      MockResponse response;
+      response.body = "{}";
+      return response;
+    };
+  }
+}
+
+MockServer::~MockServer() { stop(); }
+
+bool MockServer::start(int port) {
+  listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+  if (listen_fd_ < 0)
+    return false;
+  int one = 1;
+  setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(static_cast<uint16_t>(port));
+  if (bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) <
+          0 ||
+      listen(listen_fd_, 128) < 0) {
+    close(listen_fd_);
+    listen_fd_ = -1;
+    return false;
+  }
+  socklen_t len = sizeof(addr);
+  getsockname(listen_fd_, reinterpret_cast<sockaddr *>(&addr), &len);
+  port_ = ntohs(addr.sin_port);
+
+  running_ = true;
+  accept_thread_ = std::thread(&MockServer::accept_loop, this);
+  return true;
+}
+
+void MockServer::stop() {
+  if (!running_.exchange(false))
+    return;
+  accept_thread_.join();
+  close(listen_fd_);
+  listen_fd_ = -1;
+  std::lock_guard<std::mutex> lock(workers_mutex_);
+  for (auto &worker : workers_)
+    worker.join();
+  workers_.clear();
+}
+
+std::string MockServer::base_url() const {
+  return "http://127.0.0.1:" + std::to_string(port_);
+}
+
+void MockServer::accept_loop() {
+  while (running_) {
+    pollfd pfd = {listen_fd_, POLLIN, 0};
+    if (poll(&pfd, 1, kPollIntervalMs) <= 0)
+      continue;
+    int fd = accept(listen_fd_, NULL, NULL);
+    if (fd < 0)
+      continue;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    ++connections_;
+    std::lock_guard<std::mutex> lock(workers_mutex_);
+    workers_.push_back(std::thread(&MockServer::serve_connection, this, fd));
+  }
+}
+
+void MockServer::serve_connection(int fd) {
+  std::string buffer;
+  char chunk[16384];
+  bool keep_alive = true;
+  while (running_ && keep_alive) {
+    size_t header_end = buffer.find("\r\n\r\n");
+    if (header_end == std::string::npos) {
+      pollfd pfd = {fd, POLLIN, 0};
+      if (poll(&pfd, 1, kPollIntervalMs) <= 0)
+        continue;
+      ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+      if (n <= 0)
+        break;
+      buffer.append(chunk, static_cast<size_t>(n));
+      continue;
+    }
+
+    MockRequest request;
+    size_t line_end = buffer.find("\r\n");
+    std::string request_line = buffer.substr(0, line_end);
+    size_t sp1 = request_line.find(' ');
+    size_t sp2 = request_line.find(' ', sp1 + 1);
+    request.method = request_line.substr(0, sp1);
+    request.target = request_line.substr(sp1 + 1, sp2 - sp1 - 1);
+
+    size_t content_length = 0;
+    size_t pos = line_end + 2;
+    while (pos < header_end) {
+      size_t eol = buffer.find("\r\n", pos);
+      std::string line = buffer.substr(pos, eol - pos);
+      size_t colon = line.find(':');
+      if (colon != std::string::npos) {
+        std::string name = lowercase(line.substr(0, colon));
+        std::string value = line.substr(colon + 1);
+        value.erase(0, value.find_first_not_of(' '));
+        request.headers[name] = value;
+        if (name == "content-length")
+          content_length = std::strtoul(value.c_str(), NULL, 10);
+        else if (name == "connection" && lowercase(value) == "close")
+          keep_alive = false;
+      }
+      pos = eol + 2;
+    }
+
+    size_t body_start = header_end + 4;
+    while (buffer.size() < body_start + content_length && running_) {
+      ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+      if (n <= 0)
+        break;
+      buffer.append(chunk, static_cast<size_t>(n));
+    }
+    if (buffer.size() < body_start + content_length)
+      break;
+    request.body = buffer.substr(body_start, content_length);
+    buffer.erase(0, body_start + content_length);
+
+    MockResponse response = handler_(request);
+    ++requests_;
+    std::string out = "HTTP/1.1 " + std::to_string(response.status) + " " +
+                      status_text(response.status) + "\r\n";
+    out += "Content-Type: application/json\r\n";
+    for (auto &header : response.headers)
+      out += header.first + ": " + header.second + "\r\n";
+    out += "Content-Length: " + std::to_string(response.body.size()) + "\r\n";
+    out += keep_alive ? "Connection: keep-alive\r\n\r\n"
+                      : "Connection: close\r\n\r\n";
+    out += response.body;
+    size_t sent = 0;
+    while (sent < out.size()) {
+      ssize_t n = send(fd, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+      if (n <= 0) {
+        keep_alive = false;
+        break;
+      }
+      sent += static_cast<size_t>(n);
+    }
+  }
+  close(fd);
+}
@@ -0,0 +1,62 @@
+// bench/mock_server.h
+#ifndef MOCK_SERVER_H
+#define MOCK_SERVER_H
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct MockRequest {
+  std::string method;
+  std::string target;
+  std::map<std::string, std::string> headers; // names are lowercase
+  std::string body;
+};
+
+struct MockResponse {
+  int status;
+  std::vector<std::pair<std::string, std::string>> headers;
+  std::string body;
+
+  MockResponse() : status(200) {}
+};
+
+// Minimal HTTP/1.1 server on the loopback interface with keep-alive support.
+// Every connection is served on its own thread; the handler must therefore be
+// thread-safe.
+class MockServer {
+public:
+  typedef std::function<MockResponse(const MockRequest &)> Handler;
+
+  explicit MockServer(Handler handler = Handler());
+  ~MockServer();
+
+  // Binds to 127.0.0.1 (port 0 picks a free port) and starts serving
+  bool start(int port = 0);
+  void stop();
+
+  int port() const { return port_; }
+  std::string base_url() const;
+  size_t connections_accepted() const { return connections_; }
+  size_t requests_served() const { return requests_; }
+
+private:
+  void accept_loop();
+  void serve_connection(int fd);
+
+  Handler handler_;
+  int listen_fd_;
+  int port_;
+  std::atomic<bool> running_;
+  std::atomic<size_t> connections_;
+  std::atomic<size_t> requests_;
+  std::thread accept_thread_;
+  std::mutex workers_mutex_;
+  std::vector<std::thread> workers_;
+};
+
+#endif // MOCK_SERVER_H
@@ -0,0 +1,489 @@
+// bench/mock_spotify.cpp
+#include "mock_spotify.h"
+#include "spotify_api.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace {
+
+std::string quoted(const std::string &s) { return "\"" + s + "\""; }
+
+std::string path_of(const std::string &target) {
+  return target.substr(0, target.find('?'));
+}
+
+int int_param(const std::string &target, const std::string &key,
+              int fallback) {
+  std::string value = mock_query_param(target, key);
+  return value.empty() ? fallback : std::atoi(value.c_str());
+}
+
+bool starts_with(const std::string &s, const std::string &prefix) {
+  return s.compare(0, prefix.size(), prefix) == 0;
+}
+
+bool ends_with(const std::string &s, const std::string &suffix) {
+  return s.size() >= suffix.size() &&
+         s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+std::string playlist_id(int index) { return "pl" + std::to_string(index); }
+
+std::string track_id(const std::string &scope, int index) {
+  return scope + "tr" + std::to_string(index);
+}
+
+// Spotify returns saved tracks newest first; mock timestamps count down from
+// a fixed point so that each item has a distinct added_at.
+std::string added_at(int index) {
+  int day = 28 - (index / 86400) % 28;
+  int seconds = 86399 - index % 86400;
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "2024-01-%02dT%02d:%02d:%02dZ", day,
+                seconds / 3600, (seconds / 60) % 60, seconds % 60);
+  return buffer;
+}
+
+// Wraps items in a paging object
+std::string paging(const std::string &href,
+                   const std::vector<std::string> &items, int limit,
+                   int offset, int total) {
+  std::string out = "{\"href\":" + quoted(href) + ",\"items\":[";
+  for (size_t i = 0; i < items.size(); ++i) {
+    if (i)
+      out += ",";
+    out += items[i];
+  }
+  out += "],\"limit\":" + std::to_string(limit) +
+         ",\"offset\":" + std::to_string(offset) +
+         ",\"total\":" + std::to_string(total) + ",\"next\":";
+  out += offset + limit < total ? quoted(href) : "null";
+  out += ",\"previous\":null}";
+  return out;
+}
+
+// Tracks-added requests per playlist; each one moves the playlist to a new
+// snapshot_id, as on the Web API
+struct MockPlaylistEdits {
+  std::mutex mutex;
+  std::map<std::string, int> count;
+
+  int of(const std::string &id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = count.find(id);
+    return it == count.end() ? 0 : it->second;
+  }
+
+  int add(const std::string &id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return ++count[id];
+  }
+};
+
+std::string snapshot_id(const std::string &id, int edits) {
+  return "snap-" + id + "-" + std::to_string(edits + 1);
+}
+
+std::string playlist_json(const MockSpotifyConfig &config, int index,
+                          MockPlaylistEdits &edits) {
+  std::string id = playlist_id(index);
+  return "{\"collaborative\":false,\"description\":\"Mock playlist\","
+         "\"id\":" +
+         quoted(id) + ",\"name\":" +
+         quoted("Playlist " + std::to_string(index)) +
+         ",\"owner\":{\"id\":\"mock_user\",\"display_name\":\"Mock User\"},"
+         "\"public\":true,\"snapshot_id\":" +
+         quoted(snapshot_id(id, edits.of(id))) + ",\"tracks\":{\"total\":" +
+         std::to_string(config.tracks_per_playlist) +
+         "},\"type\":\"playlist\",\"uri\":" +
+         quoted("spotify:playlist:" + id) + "}";
+}
+
+std::string saved_item_json(const std::string &id, const std::string &name,
+                            int index) {
+  return "{\"added_at\":" + quoted(added_at(index)) +
+         ",\"track\":" + mock_track_json(id, name) + "}";
+}
+
+// Strong validator derived from the body (64-bit FNV-1a)
+std::string etag(const std::string &body) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (unsigned char c : body) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  char buffer[24];
+  std::snprintf(buffer, sizeof(buffer), "\"%016llx\"",
+                static_cast<unsigned long long>(hash));
+  return buffer;
+}
+
+MockResponse json(const std::string &body, int status = 200) {
+  MockResponse response;
+  response.status = status;
+  response.body = body;
+  return response;
+}
+
+// A page of playlists when playlists is set, of saved tracks otherwise
+MockResponse list_page(const MockRequest &request,
+                       const MockSpotifyConfig &config, int total,
+                       const std::string &scope, MockPlaylistEdits *playlists) {
+  int limit = std::min(int_param(request.target, "limit", 20),
+                       config.max_page_size);
+  int offset = int_param(request.target, "offset", 0);
+  std::vector<std::string> items;
+  for (int i = offset; i < std::min(offset + limit, total); ++i) {
+    if (playlists)
+      items.push_back(playlist_json(config, i, *playlists));
+    else
+      items.push_back(saved_item_json(track_id(scope, i),
+                                      "Track " + std::to_string(i), i));
+  }
+  return json(paging(path_of(request.target), items, limit, offset, total));
+}
+
+MockResponse album_tracks(const MockRequest &request,
+                          const MockSpotifyConfig &config,
+                          const std::string &album_id) {
+  int limit = std::min(int_param(request.target, "limit", 20),
+                       config.max_page_size);
+  int offset = int_param(request.target, "offset", 0);
+  std::vector<std::string> items;
+  for (int i = offset; i < std::min(offset + limit, config.album_tracks); ++i)
+    items.push_back(mock_track_json(track_id(album_id + "_", i),
+                                    "Track " + std::to_string(i)));
+  return json(paging(path_of(request.target), items, limit, offset,
+                     config.album_tracks));
+}
+
+// Number of strings in the one array of a body such as {"ids": [...]}
+size_t array_size(const std::string &body) {
+  size_t quotes = std::count(body.begin(), body.end(), '"') / 2;
+  return quotes > 0 ? quotes - 1 : 0;
+}
+
+MockResponse too_many(const std::string &what) {
+  return json("{\"error\":{\"status\":400,\"message\":\"Too many " + what +
+                  " requested\"}}",
+              400);
+}
+
+// Library saves and removals take at most 50 IDs in an {"ids": [...]} body
+MockResponse change_library(const MockRequest &request) {
+  if (array_size(request.body) > 50)
+    return too_many("ids");
+  return json("", 200);
+}
+
+// Playlist additions take at most 100 URIs in a {"uris": [...]} body
+MockResponse add_to_playlist(const MockRequest &request, const std::string &id,
+                             MockPlaylistEdits &edits) {
+  std::string body = request.body;
+  size_t position = body.find(",\"position\"");
+  if (position != std::string::npos)
+    body.erase(position);
+  if (array_size(body) > 100)
+    return too_many("uris");
+  int edit = edits.add(id);
+  return json("{\"snapshot_id\":" + quoted(snapshot_id(id, edit)) + "}", 201);
+}
+
+MockResponse search(const MockRequest &request) {
+  std::string q = mock_query_param(request.target, "q", "query");
+  std::string type = mock_query_param(request.target, "type", "track");
+  int limit = int_param(request.target, "limit", 10);
+  std::vector<std::string> items;
+  for (int i = 0; i < limit; ++i) {
+    std::string id = type + std::to_string(i);
+    std::string name = q + " " + std::to_string(i);
+    if (type == "track") {
+      items.push_back(mock_track_json("s" + id, name));
+    } else {
+      items.push_back("{\"id\":" + quoted(id) + ",\"name\":" + quoted(name) +
+                      ",\"type\":" + quoted(type) + ",\"uri\":" +
+                      quoted("spotify:" + type + ":" + id) + "}");
+    }
+  }
+  return json("{" + quoted(type + "s") + ":" +
+              paging("/v1/search", items, limit, 0, limit * 10) + "}");
+}
+
+MockResponse recommendations(const MockRequest &request) {
+  int limit = int_param(request.target, "limit", 20);
+  std::string out = "{\"seeds\":[],\"tracks\":[";
+  for (int i = 0; i < limit; ++i) {
+    if (i)
+      out += ",";
+    out += mock_track_json(track_id("rec", i),
+                           "Recommendation " + std::to_string(i));
+  }
+  return json(out + "]}");
+}
+
+MockResponse genres() {
+  static const char *const names[] = {"acoustic", "ambient", "blues",
+                                      "classical", "electronic", "folk",
+                                      "jazz", "metal", "pop", "rock"};
+  std::string out = "{\"genres\":[";
+  for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+    if (i)
+      out += ",";
+    out += quoted(names[i]);
+  }
+  return json(out + "]}");
+}
+
+// Playback on the mock device. Progress runs on the wall clock, and tracks
+// advance when they end, so a client has to poll to keep up.
+struct MockPlayer {
+  std::mutex mutex;
+  bool playing = true;
+  int track = 0;
+  int position_ms = 0; // as of since
+  std::chrono::steady_clock::time_point since =
+      std::chrono::steady_clock::now();
+  int volume = 50;
+  bool shuffle = false;
+  std::string repeat = "off";
+};
+
+// Brings position_ms up to now, moving to the next track at each end
+void advance(MockPlayer &player, int track_ms) {
+  auto now = std::chrono::steady_clock::now();
+  if (player.playing) {
+    player.position_ms += static_cast<int>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(now -
+                                                              player.since)
+            .count());
+    while (player.position_ms >= track_ms) {
+      player.position_ms -= track_ms;
+      if (player.repeat != "track")
+        ++player.track;
+    }
+  }
+  player.since = now;
+}
+
+MockResponse player_state(MockPlayer &player,
+                          const MockSpotifyConfig &config) {
+  std::lock_guard<std::mutex> lock(player.mutex);
+  advance(player, config.track_ms);
+  std::string id = "nowplaying" + std::to_string(player.track);
+  return json("{\"device\":{\"id\":\"dev1\",\"is_active\":true,"
+              "\"name\":\"Mock Device\",\"type\":\"Computer\","
+              "\"volume_percent\":" +
+              std::to_string(player.volume) + "},\"shuffle_state\":" +
+              (player.shuffle ? "true" : "false") + ",\"repeat_state\":" +
+              quoted(player.repeat) + ",\"timestamp\":0,\"progress_ms\":" +
+              std::to_string(player.position_ms) + ",\"is_playing\":" +
+              (player.playing ? "true" : "false") + ",\"item\":" +
+              mock_track_json(id, "Track " + std::to_string(player.track),
+                              config.track_ms) +
+              "}");
+}
+
+MockResponse player_command(const MockRequest &request, MockPlayer &player,
+                            const MockSpotifyConfig &config,
+                            const std::string &path) {
+  std::lock_guard<std::mutex> lock(player.mutex);
+  advance(player, config.track_ms);
+  if (path == "/v1/me/player/play") {
+    player.playing = true;
+  } else if (path == "/v1/me/player/pause") {
+    player.playing = false;
+  } else if (path == "/v1/me/player/next") {
+    ++player.track;
+    player.position_ms = 0;
+  } else if (path == "/v1/me/player/previous") {
+    player.track = std::max(0, player.track - 1);
+    player.position_ms = 0;
+  } else if (path == "/v1/me/player/volume") {
+    player.volume = int_param(request.target, "volume_percent", player.volume);
+  } else if (path == "/v1/me/player/shuffle") {
+    player.shuffle = mock_query_param(request.target, "state") == "true";
+  } else if (path == "/v1/me/player/repeat") {
+    player.repeat = mock_query_param(request.target, "state", "off");
+  }
+  return json("", 204);
+}
+
+// Authorization code grants get a refresh token; refresh grants reuse the
+// one they present, and the refresh token "revoked" is rejected
+MockResponse token(const MockRequest &request) {
+  std::string form = "?" + request.body;
+  std::string grant = mock_query_param(form, "grant_type");
+  std::string refresh_token = "mock-refresh-token";
+  if (grant == "refresh_token") {
+    refresh_token = mock_query_param(form, "refresh_token");
+    if (refresh_token.empty() || refresh_token == "revoked")
+      return json("{\"error\":\"invalid_grant\","
+                  "\"error_description\":\"Invalid refresh token\"}",
+                  400);
+  } else if (grant != "authorization_code") {
+    return json("{\"error\":\"unsupported_grant_type\"}", 400);
+  }
+  std::string body = "{\"access_token\":\"mock-access-token\",\"token_type\":"
+                     "\"Bearer\",\"expires_in\":3600,\"scope\":\"\"";
+  if (grant == "authorization_code")
+    body += ",\"refresh_token\":" + quoted(refresh_token);
+  return json(body + "}");
+}
+
+MockResponse route(const MockRequest &request, const MockSpotifyConfig &config,
+                   MockPlayer &player, MockPlaylistEdits &edits) {
+  std::string path = path_of(request.target);
+  const std::string &method = request.method;
+
+  if (path == "/api/token" && method == "POST")
+    return token(request);
+
+  if (path == "/v1/me/playlists" && method == "GET")
+    return list_page(request, config, config.playlists, "", &edits);
+
+  if (starts_with(path, "/v1/playlists/") && ends_with(path, "/tracks")) {
+    std::string id = path.substr(14, path.size() - 14 - 7);
+    if (method == "GET")
+      return list_page(request, config, config.tracks_per_playlist, id + "_",
+                       NULL);
+    return add_to_playlist(request, id, edits);
+  }
+
+  if (path == "/v1/me/tracks") {
+    if (method == "GET")
+      return list_page(request, config, config.saved_tracks, "saved", NULL);
+    return change_library(request);
+  }
+
+  if (starts_with(path, "/v1/albums/") && ends_with(path, "/tracks") &&
+      method == "GET")
+    return album_tracks(request, config, path.substr(11, path.size() - 11 - 7));
+
+  if (path == "/v1/search" && method == "GET")
+    return search(request);
+
+  if (path == "/v1/recommendations/available-genre-seeds")
+    return genres();
+
+  if (path == "/v1/recommendations")
+    return recommendations(request);
+
+  if (path == "/v1/me/player" && method == "GET")
+    return player_state(player, config);
+
+  if (starts_with(path, "/v1/me/player"))
+    return player_command(request, player, config, path);
+
+  return json("{\"error\":{\"status\":404,\"message\":\"Not found\"}}", 404);
+}
+
+// Web API requests seen in the current one-second window
+struct RateWindow {
+  std::mutex mutex;
+  std::chrono::steady_clock::time_point start;
+  int requests = 0;
+};
+
+// Counts the request and tells whether it is over the per-second limit
+bool over_limit(RateWindow &window, int limit) {
+  std::lock_guard<std::mutex> lock(window.mutex);
+  auto now = std::chrono::steady_clock::now();
+  if (now - window.start >= std::chrono::seconds(1)) {
+    window.start = now;
+    window.requests = 0;
+  }
+  return ++window.requests > limit;
+}
+
+MockResponse rate_limited(int retry_after_s) {
+  MockResponse response = json(
+      "{\"error\":{\"status\":429,\"message\":\"API rate limit exceeded\"}}",
+      429);
+  response.headers.push_back(
+      std::make_pair("Retry-After", std::to_string(retry_after_s)));
+  return response;
+}
+
+} // namespace
+
+MockServer::Handler make_mock_spotify_handler(const MockSpotifyConfig &config) {
+  std::shared_ptr<RateWindow> window = std::make_shared<RateWindow>();
+  std::shared_ptr<MockPlayer> player = std::make_shared<MockPlayer>();
+  std::shared_ptr<MockPlaylistEdits> edits =
+      std::make_shared<MockPlaylistEdits>();
+  return [config, window, player,
+          edits](const MockRequest &request) -> MockResponse {
+    if (config.latency_ms > 0)
+      std::this_thread::sleep_for(std::chrono::milliseconds(config.latency_ms));
+    if (config.rate_limit > 0 && starts_with(request.target, "/v1/") &&
+        over_limit(*window, config.rate_limit))
+      return rate_limited(config.retry_after_s);
+    MockResponse response = route(request, config, *player, *edits);
+    if (config.etags && request.method == "GET" && response.status == 200) {
+      std::string tag = etag(response.body);
+      auto match = request.headers.find("if-none-match");
+      if (match != request.headers.end() && match->second == tag) {
+        response.status = 304;
+        response.body.clear();
+      }
+      response.headers.push_back(std::make_pair("ETag", tag));
+    }
+    return response;
+  };
+}
+
+std::string mock_track_json(const std::string &id, const std::string &name,
+                            int duration_ms) {
+  std::string artist = "{\"external_urls\":{\"spotify\":"
+                       "\"https://open.spotify.com/artist/a" +
+                       id +
+                       "\"},\"id\":" + quoted("a" + id) +
+                       ",\"name\":" + quoted("Artist " + id) +
+                       ",\"type\":\"artist\",\"uri\":" +
+                       quoted("spotify:artist:a" + id) + "}";
+  std::string album =
+      "{\"album_type\":\"album\",\"artists\":[" + artist +
+      "],\"id\":" + quoted("al" + id) + ",\"images\":[{\"height\":640,"
+      "\"url\":\"https://i.scdn.co/image/mock640\",\"width\":640},"
+      "{\"height\":300,\"url\":\"https://i.scdn.co/image/mock300\","
+      "\"width\":300}],\"name\":" + quoted("Album " + id) +
+      ",\"release_date\":\"2020-01-01\",\"total_tracks\":12,"
+      "\"type\":\"album\",\"uri\":" + quoted("spotify:album:al" + id) + "}";
+  return "{\"album\":" + album + ",\"artists\":[" + artist +
+         "],\"disc_number\":1,\"duration_ms\":" +
+         std::to_string(duration_ms) + ",\"explicit\":false,"
+         "\"external_ids\":{\"isrc\":\"USMOCK0000001\"},\"id\":" +
+         quoted(id) + ",\"is_local\":false,\"name\":" + quoted(name) +
+         ",\"popularity\":50,\"preview_url\":null,\"track_number\":1,"
+         "\"type\":\"track\",\"uri\":" + quoted("spotify:track:" + id) + "}";
+}
+
+std::string mock_query_param(const std::string &target, const std::string &key,
+                             const std::string &fallback) {
+  size_t query = target.find('?');
+  while (query != std::string::npos) {
+    size_t start = query + 1;
+    size_t end = target.find('&', start);
+    std::string pair = target.substr(start, end - start);
+    size_t eq = pair.find('=');
+    if (pair.substr(0, eq) == key)
+      return eq == std::string::npos ? "" : pair.substr(eq + 1);
+    query = end;
+  }
+  return fallback;
+}
+
+bool start_mock_spotify(MockServer &server) {
+  if (!server.start()) {
+    std::fprintf(stderr, "failed to start mock server\n");
+    return false;
+  }
+  set_spotify_endpoint_root(server.base_url());
+  return true;
+}
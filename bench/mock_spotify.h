@@ -0,0 +1,51 @@
+// bench/mock_spotify.h
+#ifndef MOCK_SPOTIFY_H
+#define MOCK_SPOTIFY_H
+
+#include "mock_server.h"
+
+// Shape of the canned library served by the stand-in
+struct MockSpotifyConfig {
+  int latency_ms;          // added to every response
+  int playlists;           // size of me/playlists
+  int tracks_per_playlist; // size of each playlists/{id}/tracks
+  int saved_tracks;        // size of me/tracks
+  int album_tracks;        // size of each albums/{id}/tracks
+  int max_page_size;       // upper bound for ?limit=
+  bool etags;              // send ETags and answer If-None-Match with 304
+  int rate_limit;          // Web API requests per second before 429s, 0: any
+  int retry_after_s;       // Retry-After sent with those 429s
+  int track_ms;            // length of each track the mock player plays
+
+  MockSpotifyConfig()
+      : latency_ms(0), playlists(40), tracks_per_playlist(300),
+        saved_tracks(2000), album_tracks(12), max_page_size(50), etags(true),
+        rate_limit(0), retry_after_s(1), track_ms(215000) {}
+};
+
+// Handler serving canned Web API and accounts responses:
+//   GET  /v1/me/playlists, /v1/playlists/{id}/tracks, /v1/me/tracks,
+//        /v1/albums/{id}/tracks, /v1/search, /v1/recommendations,
+//        /v1/recommendations/available-genre-seeds, /v1/me/player
+//   PUT/POST/DELETE on /v1/me/player/*, /v1/me/tracks,
+//        /v1/playlists/{id}/tracks
+// The player endpoints share one simulated device, which starts playing on
+// creation and moves through tracks of track_ms as time passes.
+// Adding tracks to a playlist gives it a new snapshot_id; its track listing
+// stays the same.
+//   POST /api/token
+MockServer::Handler make_mock_spotify_handler(const MockSpotifyConfig &config);
+
+// Starts server and points the client's Web API and accounts URLs at it.
+// Reports a failure on stderr.
+bool start_mock_spotify(MockServer &server);
+
+// Builds the JSON of one full track object as the Web API returns it
+std::string mock_track_json(const std::string &id, const std::string &name,
+                            int duration_ms = 215000);
+
+// Extracts a query parameter from a request target, or fallback if absent
+std::string mock_query_param(const std::string &target, const std::string &key,
+                             const std::string &fallback = "");
+
+#endif // MOCK_SPOTIFY_H
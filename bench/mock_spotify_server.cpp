@@ -0,0 +1,74 @@
+// bench/mock_spotify_server.cpp
+// Standalone stand-in for the Spotify Web API and accounts service. Point the
+// client at it with SPOTIFY_TUI_ENDPOINT=http://127.0.0.1:<port>.
+#include "mock_spotify.h"
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+namespace {
+
+volatile std::sig_atomic_t stop_requested = 0;
+
+void handle_signal(int) { stop_requested = 1; }
+
+void print_usage(const char *program) {
+  std::fprintf(stderr,
+               "Usage: %s [--port N] [--latency-ms N] [--playlists N] "
+               "[--tracks N] [--saved N] [--page-size N] [--rate-limit N] "
+               "[--track-ms N]\n",
+               program);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int port = 8080;
+  MockSpotifyConfig config;
+  for (int i = 1; i < argc; ++i) {
+    if (i + 1 >= argc) {
+      print_usage(argv[0]);
+      return 1;
+    }
+    int value = std::atoi(argv[i + 1]);
+    if (std::strcmp(argv[i], "--port") == 0)
+      port = value;
+    else if (std::strcmp(argv[i], "--latency-ms") == 0)
+      config.latency_ms = value;
+    else if (std::strcmp(argv[i], "--playlists") == 0)
+      config.playlists = value;
+    else if (std::strcmp(argv[i], "--tracks") == 0)
+      config.tracks_per_playlist = value;
+    else if (std::strcmp(argv[i], "--saved") == 0)
+      config.saved_tracks = value;
+    else if (std::strcmp(argv[i], "--page-size") == 0)
+      config.max_page_size = value;
+    else if (std::strcmp(argv[i], "--rate-limit") == 0)
+      config.rate_limit = value;
+    else if (std::strcmp(argv[i], "--track-ms") == 0)
+      config.track_ms = value;
+    else {
+      print_usage(argv[0]);
+      return 1;
+    }
+    ++i;
+  }
+
+  MockServer server(make_mock_spotify_handler(config));
+  if (!server.start(port)) {
+    std::fprintf(stderr, "failed to listen on port %d\n", port);
+    return 1;
+  }
+  std::signal(SIGINT, handle_signal);
+  std::signal(SIGTERM, handle_signal);
+  std::printf("Mock Spotify listening on %s\n", server.base_url().c_str());
+  std::fflush(stdout);
+  while (!stop_requested)
+    pause();
+  server.stop();
+  std::printf("Served %zu requests on %zu connections\n",
+              server.requests_served(), server.connections_accepted());
+  return 0;
+}
@@ -0,0 +1,44 @@
+// bench/name_generator.h
+#ifndef NAME_GENERATOR_H
+#define NAME_GENERATOR_H
+
+#include <cctype>
+#include <random>
+#include <string>
+
+// Syllables are an onset, a vowel and an optional coda, which gives a spread
+// of trigrams closer to real titles than a small fixed word list
+inline std::string make_syllable(std::mt19937 &rng) {
+  static const char kOnsets[] = "bcdfghjklmnprstvwz";
+  static const char kVowels[] = "aeiouy";
+  static const char kCodas[] = "nrlstm";
+  std::uniform_int_distribution<int> onset(0, sizeof(kOnsets) - 2);
+  std::uniform_int_distribution<int> vowel(0, sizeof(kVowels) - 2);
+  std::uniform_int_distribution<int> coda(0, 2 * (sizeof(kCodas) - 1));
+  std::string syllable;
+  syllable += kOnsets[onset(rng)];
+  syllable += kVowels[vowel(rng)];
+  size_t c = static_cast<size_t>(coda(rng));
+  if (c < sizeof(kCodas) - 1)
+    syllable += kCodas[c];
+  return syllable;
+}
+
+inline std::string make_word(std::mt19937 &rng) {
+  std::uniform_int_distribution<int> syllables(1, 3);
+  std::string word;
+  for (int n = syllables(rng); n > 0; --n)
+    word += make_syllable(rng);
+  word[0] = static_cast<char>(std::toupper(word[0]));
+  return word;
+}
+
+inline std::string make_name(std::mt19937 &rng) {
+  std::uniform_int_distribution<int> words(1, 4);
+  std::string name;
+  for (int n = words(rng); n > 0; --n)
+    name += (name.empty() ? "" : " ") + make_word(rng);
+  return name;
+}
+
+#endif // NAME_GENERATOR_H
@@ -2,18 +2,51 @@
 #ifndef BASE64_H
 #define BASE64_H
 
+#include <cstddef>
 #include <string>
 
+// Instruction sets the codec has a path for. The best one the CPU supports
+// is picked on first use; a path handles whole blocks and leaves the tail
+// to the scalar code.
+enum class Base64Isa { SCALAR, SSSE3, AVX2 };
+
+// The path in use
+Base64Isa base64_isa();
+
+// Uses isa, or the best supported path below it, from now on; meant for
+// benchmarks and tests comparing the paths. Returns the path now in use.
+Base64Isa base64_use_isa(Base64Isa isa);
+
+// Characters needed to encode len bytes, padding included
+inline size_t base64_encoded_length(size_t len) { return (len + 2) / 3 * 4; }
+
+// Upper bound on the bytes that len characters decode to
+inline size_t base64_decoded_max_length(size_t len) { return len / 4 * 3 + 2; }
+
+// Encodes len bytes into out, which must have room for
+// base64_encoded_length(len) characters; returns the characters written
+size_t base64_encode(const unsigned char *data, size_t len, char *out);
+
+// Decodes standard, padded or unpadded Base64 into out, which must have room
+// for base64_decoded_max_length(len) bytes. Fails on a character outside the
+// alphabet, padding anywhere but at the end, or a length no encoding has,
+// leaving out_len 0.
+bool base64_decode(const char *data, size_t len, unsigned char *out,
+                   size_t &out_len);
+
 // Encodes a standard string to Base64
 std::string base64_encode(const std::string &in);
 
 // Encodes a byte array to Base64
 std::string base64_encode(const unsigned char *data, size_t len);
 
-// Decodes a Base64 encoded string
+// Decodes a Base64 encoded string; empty if the input is not valid Base64
 std::string base64_decode(const std::string &in);
 
-// Decodes a Base64 encoded byte array
+// Decodes a Base64 encoded byte array; empty if the input is not valid Base64
 std::string base64_decode(const char *data, size_t len);
 
+// Decodes into out; false, with out empty, if the input is not valid Base64
+bool base64_decode(const char *data, size_t len, std::string &out);
+
 #endif // BASE64_H
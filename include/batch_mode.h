@@ -0,0 +1,45 @@
+// include/batch_mode.h
+#ifndef BATCH_MODE_H
+#define BATCH_MODE_H
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+
+// Requests a batch keeps in flight by default
+const int kDefaultBatchConcurrency = 16;
+
+struct BatchOptions {
+  int concurrency; // requests in flight at once
+  // Sends runs of consecutive saves, removes and additions to one playlist
+  // as single requests of up to the endpoint's limit
+  bool coalesce;
+
+  BatchOptions() : concurrency(kDefaultBatchConcurrency), coalesce(true) {}
+};
+
+struct BatchStats {
+  size_t commands;   // lines that held a command
+  size_t failed;     // of which failed or did not parse
+  size_t requests;   // Web API requests sent
+  double elapsed_ms; // from the start of the run to the last result
+
+  BatchStats() : commands(0), failed(0), requests(0), elapsed_ms(0) {}
+};
+
+// Runs newline-delimited commands read from in until end of input and writes
+// one JSON object per command to out, in input order. Each command starts as
+// soon as its line is read, so input from a pipe runs while it is still being
+// written. Commands that touch the same thing run in order: player commands
+// among themselves, saves against removes, and additions to the same
+// playlist. Everything else runs concurrently. A `wait` line waits for every
+// earlier command to finish. Blank lines and lines starting with # are
+// skipped. The access token is refreshed whenever it is about to expire.
+BatchStats run_batch(const std::string &access_token, std::istream &in,
+                     std::ostream &out,
+                     const BatchOptions &options = BatchOptions());
+
+// Lists the commands run_batch understands
+void print_batch_usage(std::ostream &out);
+
+#endif // BATCH_MODE_H
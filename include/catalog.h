@@ -0,0 +1,150 @@
+// include/catalog.h
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include "json_extract.h"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Stores each distinct string once. The strings sit back to back, null
+// terminated, in one buffer and are referred to by their index; an open
+// addressing table over those indexes finds an existing copy. Not
+// thread-safe.
+class StringPool {
+public:
+  typedef uint32_t Ref;
+
+  StringPool();
+
+  Ref intern(const std::string &text);
+  // Stores a string known to be unique, such as an ID, without entering it
+  // in the table; find() will not see it
+  Ref add(const std::string &text);
+  // Ref of text, or kNone if it was never interned
+  Ref find(const std::string &text) const;
+
+  std::string str(Ref ref) const;
+  // Valid until the next intern()
+  const char *c_str(Ref ref) const { return &bytes_[offsets_[ref]]; }
+  size_t length(Ref ref) const {
+    return offsets_[ref + 1] - offsets_[ref] - 1;
+  }
+
+  size_t size() const { return offsets_.size() - 1; }
+  size_t memory_bytes() const;
+  void clear();
+
+  static const Ref kNone = UINT32_MAX;
+
+private:
+  size_t slot_of(const char *data, size_t length, uint32_t hash) const;
+  void grow();
+
+  std::vector<char> bytes_;
+  // Start of each string, followed by the end of the buffer
+  std::vector<uint32_t> offsets_;
+  // ref + 1 of the string hashed to each slot, 0 when empty
+  std::vector<uint32_t> slots_;
+  size_t interned_;
+};
+
+enum class CatalogKind : uint8_t { TRACK, ARTIST, ALBUM, PLAYLIST };
+
+typedef uint32_t CatalogRef;
+const CatalogRef kNoCatalogEntry = UINT32_MAX;
+
+// Entries a menu displayed, in display order
+typedef std::vector<CatalogRef> CatalogView;
+
+// Every track, playlist, album and artist the menus have shown, stored once.
+// Strings are interned, so a name, artist or album shared by many tracks is
+// kept a single time, and the entries are laid out as parallel columns of
+// string refs rather than one struct of strings each. Entries are indexed by
+// (kind, ID) and by normalized name (see fold_for_search); the normalized
+// name itself is not stored. Thread-safe.
+class Catalog {
+public:
+  Catalog();
+
+  // Adds an entry, or updates the name of the one with the same kind and
+  // ID. key is a Spotify URI or a bare ID; a URI of another kind (a local
+  // file or an episode in a playlist) is kept whole. Entries without a key
+  // are told apart by name.
+  CatalogRef add(CatalogKind kind, const std::string &name,
+                 const std::string &key);
+  CatalogRef add_track(const std::string &name, const std::string &key,
+                       const std::string &artist, const std::string &album,
+                       int duration_ms);
+  // Adds every item of a page and appends them to view
+  void add_page(CatalogKind kind, const ItemPage &page, CatalogView &view);
+
+  CatalogRef find(CatalogKind kind, const std::string &key);
+  // Entries whose normalized name equals that of name, newest first
+  CatalogView find_name(const std::string &name);
+
+  CatalogKind kind(CatalogRef ref);
+  std::string name(CatalogRef ref);
+  std::string id(CatalogRef ref);
+  std::string uri(CatalogRef ref);
+  // What the Web API takes for the entry: the ID of a playlist, the URI of
+  // anything else
+  std::string key(CatalogRef ref);
+  std::string artist(CatalogRef ref);
+  std::string album(CatalogRef ref);
+  int duration_ms(CatalogRef ref);
+
+  size_t size();
+  // Heap bytes held by the columns, indexes and string pool
+  size_t memory_bytes();
+  void clear();
+
+private:
+  CatalogRef add_locked(CatalogKind kind, const std::string &name,
+                        const std::string &key);
+  // Splits key into the ID stored for it and the entry's tag
+  uint8_t tag_of(CatalogKind kind, const std::string &key,
+                 std::string &id) const;
+  CatalogRef find_id(const std::string &id, uint8_t tag) const;
+  void link_name(CatalogRef ref);
+  void unlink_name(CatalogRef ref);
+  size_t id_slot(const std::string &id, uint8_t tag) const;
+  size_t name_slot(uint32_t name_hash) const;
+  void erase_name_slot(size_t slot);
+  void grow_indexes();
+  std::string uri_locked(CatalogRef ref) const;
+
+  std::mutex mutex_;
+  StringPool strings_;
+
+  // One element per entry
+  std::vector<StringPool::Ref> id_;
+  std::vector<StringPool::Ref> name_;
+  // Hash of the normalized name
+  std::vector<uint32_t> name_hash_;
+  std::vector<StringPool::Ref> artist_;
+  std::vector<StringPool::Ref> album_;
+  std::vector<uint32_t> duration_ms_;
+  // CatalogKind, plus kWholeUri when id_ holds a URI of another kind
+  std::vector<uint8_t> tag_;
+  // Previous entry with the same normalized name, or kNoCatalogEntry
+  std::vector<CatalogRef> next_same_name_;
+
+  // Open addressing tables of ref + 1, 0 when empty: by (kind, ID), and by
+  // name hash to the newest entry of its chain
+  std::vector<uint32_t> by_id_;
+  std::vector<uint32_t> by_name_;
+
+  static const uint8_t kWholeUri = 0x80;
+};
+
+// Process-wide catalog shared by the menus
+Catalog &catalog();
+
+// Resolves what was typed at a selection prompt against a view: a 1-based
+// position, then a URI or ID, then a name compared case-insensitively.
+// Returns kNoCatalogEntry when nothing in the view matches.
+CatalogRef select_from_view(const CatalogView &view, const std::string &input);
+
+#endif // CATALOG_H
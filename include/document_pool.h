@@ -0,0 +1,88 @@
+// include/document_pool.h
+#ifndef DOCUMENT_POOL_H
+#define DOCUMENT_POOL_H
+
+#include "rapidjson/document.h"
+#include <cstdint>
+#include <memory>
+
+// A document whose parse stack, like its values, is carved out of a memory
+// pool rather than the heap. Its values are plain rapidjson::Value objects.
+typedef rapidjson::GenericDocument<rapidjson::UTF8<>,
+                                   rapidjson::MemoryPoolAllocator<>,
+                                   rapidjson::MemoryPoolAllocator<>>
+    PooledDocument;
+
+struct DocumentPoolStats {
+  uint64_t leases;         // documents handed out
+  uint64_t arenas_created; // documents built because none was idle
+  uint64_t arenas_grown;   // arenas enlarged after a document overflowed them
+  size_t idle;             // documents waiting to be reused
+  size_t idle_bytes;       // arena bytes held by those documents
+
+  DocumentPoolStats()
+      : leases(0), arenas_created(0), arenas_grown(0), idle(0),
+        idle_bytes(0) {}
+};
+
+// Keeps parsed-into documents alive between requests. Each document owns two
+// arenas, one for its values and one for the parse stack, backed by buffers
+// that are reset rather than freed when the document is returned. A document
+// that outgrew its arenas gets larger ones on return, so a loop fetching
+// similar pages stops touching the heap after the first few. Thread-safe;
+// leases may be returned from any thread.
+class DocumentPool {
+  struct Slot;
+  struct Shared;
+
+public:
+  // Exclusive use of one pooled document until the lease is destroyed or
+  // reset. Move-only.
+  class Lease {
+  public:
+    Lease() : slot_(NULL) {}
+    Lease(Lease &&other);
+    Lease &operator=(Lease &&other);
+    ~Lease() { reset(); }
+
+    PooledDocument &operator*() const;
+    PooledDocument *operator->() const { return &**this; }
+    explicit operator bool() const { return slot_ != NULL; }
+
+    // Returns the document to its pool
+    void reset();
+
+  private:
+    friend class DocumentPool;
+    Lease(const std::shared_ptr<Shared> &shared, Slot *slot)
+        : shared_(shared), slot_(slot) {}
+    Lease(const Lease &);
+    Lease &operator=(const Lease &);
+
+    std::shared_ptr<Shared> shared_;
+    Slot *slot_;
+  };
+
+  // At most max_idle returned documents are kept; the rest are freed
+  explicit DocumentPool(size_t max_idle = kDefaultMaxIdle);
+
+  // A null document ready to parse into
+  Lease acquire();
+
+  DocumentPoolStats stats();
+  // Frees the idle documents
+  void trim();
+
+  // Enough for the pages window of fetch_all_pages plus a few one-off GETs
+  static const size_t kDefaultMaxIdle = 8;
+
+private:
+  std::shared_ptr<Shared> shared_;
+};
+
+typedef DocumentPool::Lease DocumentLease;
+
+// Process-wide pool used by the paginated and background getters
+DocumentPool &document_pool();
+
+#endif // DOCUMENT_POOL_H
@@ -0,0 +1,163 @@
+// include/http_client.h
+#ifndef HTTP_CLIENT_H
+#define HTTP_CLIENT_H
+
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct curl_slist;
+
+// Order in which queued requests are started when the request budget is
+// short. Background requests also leave part of the budget unused so that an
+// interactive request arriving later does not have to wait for tokens.
+enum class RequestPriority { INTERACTIVE, NORMAL, BACKGROUND };
+const int kRequestPriorities = 3;
+
+// Priority given to requests created on this thread
+RequestPriority current_request_priority();
+
+// Sets the priority of requests created on this thread until destroyed
+class RequestPriorityScope {
+public:
+  explicit RequestPriorityScope(RequestPriority priority);
+  ~RequestPriorityScope();
+
+private:
+  RequestPriorityScope(const RequestPriorityScope &);
+  RequestPriorityScope &operator=(const RequestPriorityScope &);
+
+  RequestPriority previous_;
+};
+
+// Headers converted to a cURL list once and shared by many requests, such as
+// the Authorization header of a session. Immutable once built.
+class HttpHeaderList {
+public:
+  explicit HttpHeaderList(const std::vector<std::string> &lines);
+  ~HttpHeaderList();
+
+  const std::vector<std::string> &lines() const { return lines_; }
+  struct curl_slist *slist() const { return slist_; }
+
+private:
+  HttpHeaderList(const HttpHeaderList &);
+  HttpHeaderList &operator=(const HttpHeaderList &);
+
+  std::vector<std::string> lines_;
+  struct curl_slist *slist_;
+};
+
+// A single HTTP request. Non-GET methods always send a body (possibly empty)
+// so that a Content-Length header is present.
+struct HttpRequest {
+  std::string method;
+  std::string url;
+  // Sent before headers. When headers is empty the shared list is handed to
+  // cURL as it is, so no list is built for the transfer.
+  std::shared_ptr<const HttpHeaderList> shared_headers;
+  std::vector<std::string> headers;
+  std::string body;
+  RequestPriority priority;
+
+  HttpRequest() : method("GET"), priority(current_request_priority()) {}
+};
+
+// Where the time of a completed transfer went, from cURL's timers. Connection
+// setup is zero when an existing connection was reused.
+struct HttpTimings {
+  int64_t dns_us;
+  int64_t connect_us; // TCP handshake, after DNS
+  int64_t tls_us;     // TLS handshake, after connecting
+  // From the start of the transfer
+  int64_t first_byte_us;
+  int64_t total_us;
+  bool new_connection;
+
+  HttpTimings()
+      : dns_us(0), connect_us(0), tls_us(0), first_byte_us(0), total_us(0),
+        new_connection(false) {}
+};
+
+struct HttpResponse {
+  bool transport_ok;
+  long status;
+  std::map<std::string, std::string> headers; // names are lowercase
+  std::string body;
+  std::string error;
+  HttpTimings timings;
+
+  HttpResponse() : transport_ok(false), status(0) {}
+
+  // Value of a response header, or an empty string if absent
+  std::string header(const std::string &lowercase_name) const {
+    auto it = headers.find(lowercase_name);
+    return it == headers.end() ? std::string() : it->second;
+  }
+};
+
+// Performs a request and waits for it. It is scheduled like an asynchronous
+// request and runs on a pooled easy handle; all handles share one DNS cache,
+// TLS session cache and connection cache, so consecutive requests to the same
+// host reuse the established connection. Safe to call from any thread.
+// Returns true when the transfer completed, regardless of the HTTP status.
+bool http_perform(const HttpRequest &request, HttpResponse &response);
+
+typedef uint64_t HttpRequestId;
+typedef std::function<void(HttpResponse &response)> HttpCallback;
+
+// Queues a request on the event loop thread, which drives all asynchronous
+// transfers concurrently on one curl multi handle. Queued requests are started
+// in priority order as the rate limit allows; a 429 response pauses every
+// start for its Retry-After and puts the request back at the head of its
+// queue. The callback runs on the event loop thread when the transfer
+// finishes, so it must not block.
+HttpRequestId http_perform_async(const HttpRequest &request,
+                                 HttpCallback callback);
+
+// Aborts an asynchronous request, closing its connection if the transfer has
+// started. The callback still runs, with transport_ok false and the error
+// "cancelled". Does nothing if the request has already finished.
+void http_cancel(HttpRequestId id);
+
+// Moves a queued asynchronous request up to priority, such as a background
+// prefetch someone is now waiting for. Does nothing if it has started or
+// already has that priority or a higher one.
+void http_promote(HttpRequestId id, RequestPriority priority);
+
+// Future-based variant of http_perform_async
+std::future<HttpResponse> http_perform_async(const HttpRequest &request);
+
+// Number of easy handles created since startup (pooled handles are reused)
+size_t http_handles_created();
+
+// Token bucket applied to request starts: requests_per_second on average, up
+// to burst at once. A rate of 0 (the default) removes the limit.
+void http_set_rate_limit(double requests_per_second, double burst);
+
+struct HttpSchedulerStats {
+  // Indexed by RequestPriority
+  size_t queued[kRequestPriorities];     // waiting to start now
+  size_t max_queued[kRequestPriorities]; // deepest the queue has been
+  uint64_t started[kRequestPriorities];  // first starts, retries excluded
+  double total_wait_ms[kRequestPriorities];
+  double max_wait_ms[kRequestPriorities];
+  uint64_t throttled;      // 429 responses received
+  uint64_t retried;        // requests queued again after a 429
+  double backoff_left_ms;  // until the current Retry-After pause ends
+
+  HttpSchedulerStats();
+
+  double mean_wait_ms(RequestPriority priority) const {
+    int p = static_cast<int>(priority);
+    return started[p] ? total_wait_ms[p] / started[p] : 0.0;
+  }
+};
+
+HttpSchedulerStats http_scheduler_stats();
+
+#endif // HTTP_CLIENT_H
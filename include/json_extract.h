@@ -0,0 +1,42 @@
+// include/json_extract.h
+#ifndef JSON_EXTRACT_H
+#define JSON_EXTRACT_H
+
+#include <string>
+#include <vector>
+
+// The two fields every list view shows: a display name and the key used to
+// act on the item (a URI for tracks, an ID for playlists)
+struct NamedItem {
+  std::string name;
+  std::string key;
+  std::string version; // snapshot_id of a playlist; empty for other items
+};
+
+// One page of a list view
+struct ItemPage {
+  std::vector<NamedItem> items;
+  int total; // `total` of the paging object, or -1 if the response has none
+  size_t bytes; // of the response body the page was extracted from
+
+  ItemPage() : total(-1), bytes(0) {}
+};
+
+// Response shapes the list views are built from
+enum class ItemView {
+  PLAYLISTS,        // items[].name / items[].id, items[].snapshot_id
+  TRACK_ITEMS,      // items[].track.name / items[].track.uri
+  RECOMMENDATIONS,  // tracks[].name / tracks[].uri
+  SEARCH_TRACKS,    // tracks.items[].name / .uri
+  SEARCH_ARTISTS,   // artists.items[].name / .uri
+  SEARCH_ALBUMS,    // albums.items[].name / .uri
+  SEARCH_PLAYLISTS, // playlists.items[].name / .uri
+  ALBUM_TRACKS,     // items[].name / items[].uri
+};
+
+// Extracts the items of a view from a null-terminated JSON response with the
+// rapidjson SAX reader, copying only the two fields of each item instead of
+// building a DOM of the whole response. Appends to page.items.
+bool extract_items(const char *json, ItemView view, ItemPage &page);
+
+#endif // JSON_EXTRACT_H
@@ -0,0 +1,84 @@
+// include/library_store.h
+#ifndef LIBRARY_STORE_H
+#define LIBRARY_STORE_H
+
+#include "catalog.h"
+#include "rapidjson/document.h"
+#include <atomic>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct SavedTrack {
+  std::string added_at; // ISO 8601, compares chronologically as a string
+  std::string id;
+  std::string uri;
+  std::string name;
+  std::string artist;
+  std::string album;
+  int duration_ms;
+
+  SavedTrack() : duration_ms(0) {}
+};
+
+// Extracts the saved-track fields from one item of a me/tracks or
+// playlists/{id}/tracks page; returns false for items without a track
+bool saved_track_from_item(const rapidjson::Value &item, SavedTrack &track);
+
+// Local copy of the user's saved tracks, newest first, persisted as a tab
+// separated file in the cache directory. All methods are thread-safe.
+class LibraryStore {
+public:
+  explicit LibraryStore(const std::string &path);
+  ~LibraryStore();
+
+  bool load();
+  bool save();
+
+  // Pulls pages newest first and stops at the first track that is already
+  // stored with the same added_at. An empty store is filled with a full,
+  // concurrently prefetched listing.
+  bool sync(const std::string &access_token);
+
+  // Starts a background pass that lists the whole library at a gentle pace
+  // and drops tracks that are no longer saved. Does nothing if a pass is
+  // running or the last one finished less than min_interval_seconds ago.
+  void reconcile_in_background(const std::string &access_token,
+                               long min_interval_seconds = kReconcileInterval);
+
+  // Stops and joins the background pass; call before exiting
+  void stop();
+
+  void remove(const std::string &uri);
+  // Removes several tracks with a single rewrite of the file
+  void remove(const std::vector<std::string> &uris);
+  std::vector<SavedTrack> tracks();
+  // The saved tracks as entries of catalog(), newest first
+  CatalogView catalog_view();
+  size_t size();
+
+  static const long kReconcileInterval = 24 * 60 * 60;
+
+private:
+  void reconcile(const std::string &access_token, std::string newest_added_at);
+  void rebuild_index();
+  bool save_locked();
+
+  std::string path_;
+  std::mutex mutex_;
+  std::vector<SavedTrack> tracks_;
+  std::unordered_map<std::string, size_t> by_uri_;
+  CatalogView catalog_refs_;
+  std::time_t last_reconciled_;
+  std::thread reconcile_thread_;
+  std::atomic<bool> reconciling_;
+  std::atomic<bool> stopping_;
+};
+
+// Process-wide store backed by <cache_directory()>/saved_tracks.tsv
+LibraryStore &library_store();
+
+#endif // LIBRARY_STORE_H
@@ -0,0 +1,57 @@
+// include/list_view.h
+#ifndef LIST_VIEW_H
+#define LIST_VIEW_H
+
+#include "screen.h"
+#include <functional>
+#include <string>
+
+// Text of the row at index; only asked for rows that are on screen
+typedef std::function<std::string(size_t index)> RowText;
+
+// A numbered list with a highlighted selection, drawn between a title row and
+// a status row. Only the rows in view are formatted and drawn, so a frame
+// costs the same for ten rows as for a hundred thousand. Typing text moves
+// the selection to the next row containing it.
+class ListView {
+public:
+  ListView(const std::string &title, size_t count, const RowText &row_text);
+
+  size_t count() const { return count_; }
+  size_t selected() const { return selected_; }
+  size_t top() const { return top_; }
+  bool searching() const { return !search_.empty(); }
+
+  void set_count(size_t count);
+  // Moves the selection by delta rows, stopping at either end
+  void move(long delta);
+  void select(size_t index);
+
+  // Applies a navigation or search key; false for keys it does not use.
+  // Escape clears the search text.
+  bool handle_key(const KeyEvent &key);
+
+  // Draws the visible rows into the back buffer of screen
+  void draw(Screen &screen);
+
+private:
+  void find_next(size_t from);
+  size_t visible_rows() const { return rows_ > 2 ? rows_ - 2 : 1; }
+
+  std::string title_;
+  size_t count_;
+  RowText row_text_;
+  size_t selected_;
+  size_t top_;
+  // Visible height as of the last draw
+  size_t rows_;
+  std::string search_;
+};
+
+// Shows a list full screen until Enter, which returns the index of the
+// selected row, or Escape (or q with no search typed), which returns count.
+// Returns count at once if the terminal cannot be driven full screen.
+size_t pick_from_list(const std::string &title, size_t count,
+                      const RowText &row_text);
+
+#endif // LIST_VIEW_H
@@ -0,0 +1,55 @@
+// include/lru_cache.h
+#ifndef LRU_CACHE_H
+#define LRU_CACHE_H
+
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+// Fixed-capacity map that evicts the least recently used entry. Not
+// thread-safe; callers hold their own lock.
+template <typename Key, typename Value> class LruCache {
+public:
+  explicit LruCache(size_t capacity) : capacity_(capacity) {}
+
+  // Copies the value for key and marks it most recently used
+  bool get(const Key &key, Value &value) {
+    auto it = index_.find(key);
+    if (it == index_.end())
+      return false;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    value = it->second->second;
+    return true;
+  }
+
+  void put(const Key &key, const Value &value) {
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      it->second->second = value;
+      entries_.splice(entries_.begin(), entries_, it->second);
+      return;
+    }
+    entries_.emplace_front(key, value);
+    index_[key] = entries_.begin();
+    if (entries_.size() > capacity_) {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+  }
+
+  size_t size() const { return entries_.size(); }
+
+  void clear() {
+    entries_.clear();
+    index_.clear();
+  }
+
+private:
+  typedef std::pair<Key, Value> Entry;
+
+  size_t capacity_;
+  std::list<Entry> entries_; // most recently used first
+  std::unordered_map<Key, typename std::list<Entry>::iterator> index_;
+};
+
+#endif // LRU_CACHE_H
@@ -0,0 +1,63 @@
+// include/page_prefetch.h
+#ifndef PAGE_PREFETCH_H
+#define PAGE_PREFETCH_H
+
+#include "json_extract.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+struct PrefetchStats {
+  uint64_t started;      // pages requested ahead of time
+  uint64_t hits;         // first pages answered from a prefetched page
+  uint64_t misses;       // first pages fetched while others were prefetched
+  uint64_t wasted;       // prefetched pages dropped without being used
+  uint64_t promoted;     // pending pages moved up to the taker's priority
+  uint64_t bytes_used;   // response bytes of the pages that were used
+  uint64_t bytes_wasted; // response bytes downloaded for dropped pages
+
+  PrefetchStats()
+      : started(0), hits(0), misses(0), wasted(0), promoted(0),
+        bytes_used(0), bytes_wasted(0) {}
+
+  double hit_ratio() const {
+    return hits + misses ? static_cast<double>(hits) / (hits + misses) : 0.0;
+  }
+};
+
+// Pages fetched at background priority before the user asks for them, such
+// as the first page of tracks of the playlists a menu is likely to open.
+// fetch_all_item_pages takes its first page from here when one was
+// prefetched for the URL, waiting for it if it is still in flight. A page
+// still queued then moves up to the waiting caller's priority, so it is not
+// held back behind the budget background requests leave unused. Pages left
+// over when the menu is done are discarded and counted as wasted.
+// Thread-safe.
+class PagePrefetcher {
+public:
+  PagePrefetcher();
+
+  // Starts fetching url unless it is already held
+  void prefetch(const std::string &access_token, const std::string &url,
+                ItemView view);
+
+  // Moves the page prefetched for url into page. False when nothing was
+  // prefetched for url or the prefetch failed; only counted as a miss while
+  // other pages are held.
+  bool take(const std::string &url, ItemPage &page);
+
+  // Drops every page not taken and cancels the fetches still in flight
+  void discard();
+
+  PrefetchStats stats();
+
+private:
+  struct State;
+
+  std::shared_ptr<State> state_;
+};
+
+// Process-wide prefetcher consulted by fetch_all_item_pages
+PagePrefetcher &page_prefetcher();
+
+#endif // PAGE_PREFETCH_H
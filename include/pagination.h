@@ -0,0 +1,43 @@
+// include/pagination.h
+#ifndef PAGINATION_H
+#define PAGINATION_H
+
+#include "json_extract.h"
+#include "rapidjson/document.h"
+#include <functional>
+#include <string>
+
+// Number of pages requested ahead of the one being displayed
+const int kDefaultPageWindow = 4;
+
+// Builds the URL of the page starting at offset
+typedef std::function<std::string(int limit, int offset)> PageUrlBuilder;
+
+// Receives one page of a paging object. Pages arrive in offset order on the
+// calling thread; return false to stop fetching. The page lives in a pooled
+// document that is reused once the callback returns.
+typedef std::function<bool(const rapidjson::Value &page, int offset)>
+    PageCallback;
+
+// Receives one page of a list view, extracted without building a DOM
+typedef std::function<bool(const ItemPage &page, int offset)>
+    ItemPageCallback;
+
+// Fetches every page of a paging endpoint. The first page is fetched on its
+// own to learn `total`; the remaining pages are then requested concurrently,
+// keeping at most `window` pages outstanding (at least one), and handed to
+// on_page as soon as all earlier pages have been delivered. Returns false if
+// any page failed.
+bool fetch_all_pages(const std::string &access_token,
+                     const PageUrlBuilder &page_url, int page_size, int window,
+                     const PageCallback &on_page);
+
+// Same as fetch_all_pages, but each page is reduced to the items of a list
+// view by the SAX extractor. The first page comes from page_prefetcher() when
+// it was prefetched.
+bool fetch_all_item_pages(const std::string &access_token,
+                          const PageUrlBuilder &page_url, int page_size,
+                          int window, ItemView view,
+                          const ItemPageCallback &on_page);
+
+#endif // PAGINATION_H
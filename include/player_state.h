@@ -0,0 +1,113 @@
+// include/player_state.h
+#ifndef PLAYER_STATE_H
+#define PLAYER_STATE_H
+
+#include "rapidjson/document.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// What me/player reported, as of fetched_at
+struct PlayerState {
+  bool active; // false when no device is playing anything
+  bool playing;
+  std::string track_name;
+  std::string track_uri;
+  std::string artist;
+  int progress_ms;
+  int duration_ms;
+  std::string device_name;
+  int volume; // percent, or -1 when the device does not report it
+  bool shuffle;
+  std::string repeat; // "off", "track" or "context"
+  std::chrono::steady_clock::time_point fetched_at;
+
+  PlayerState()
+      : active(false), playing(false), progress_ms(0), duration_ms(0),
+        volume(-1), shuffle(false), repeat("off") {}
+
+  // Progress at now, counted on from progress_ms while playing and capped at
+  // the end of the track
+  int progress_at(std::chrono::steady_clock::time_point now) const;
+  int progress_now() const {
+    return progress_at(std::chrono::steady_clock::now());
+  }
+};
+
+// Fills state from a me/player response; a null document (204 No Content)
+// means nothing is playing
+void player_state_from_json(const rapidjson::Value &doc, PlayerState &state);
+
+// Fetches me/player; false when the request fails
+bool get_player_state(const std::string &access_token, PlayerState &state);
+
+// Formats the state as one line, e.g. "Song - Artist [1:05/3:20] on Device"
+std::string describe_player_state(const PlayerState &state);
+
+struct PlayerPollerStats {
+  uint64_t polls;    // me/player requests sent
+  uint64_t failures; // of which failed
+  uint64_t changes;  // polls that found something other than the cache
+  int interval_ms;   // wait before the next poll, as last chosen
+
+  PlayerPollerStats() : polls(0), failures(0), changes(0), interval_ms(0) {}
+};
+
+// Keeps a cached PlayerState fresh from a background thread. It polls soon
+// after poke(), which player commands call, and just after the current track
+// is due to end; otherwise it polls every few seconds while playing and backs
+// off while paused, idle or failing. Between polls the cache's progress is
+// interpolated, so a display can redraw as often as it likes without sending
+// requests. All methods are thread-safe.
+class PlayerPoller {
+public:
+  PlayerPoller();
+  ~PlayerPoller();
+  PlayerPoller(const PlayerPoller &) = delete;
+  PlayerPoller &operator=(const PlayerPoller &) = delete;
+
+  // Starts polling with access_token, or switches a running poller to it
+  void start(const std::string &access_token);
+  // Stops and joins the thread; call before exiting
+  void stop();
+
+  // Copies the cached state; false until the first poll succeeds
+  bool snapshot(PlayerState &state);
+  // Counts up whenever a poll or amend() changes the cache
+  uint64_t version();
+  // Polls shortly, to pick up the effect of a player command
+  void poke();
+  // Applies the confirmed effect of a command to the cache. Polls that were
+  // already in flight are then discarded, since they may predate it.
+  void amend(const std::function<void(PlayerState &)> &change);
+  PlayerPollerStats stats();
+
+private:
+  void run();
+  int next_interval_ms(bool ok, bool changed);
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::thread thread_;
+  std::string access_token_;
+  bool running_;
+  bool poked_;
+  PlayerState state_;
+  bool have_state_;
+  uint64_t version_;
+  std::chrono::steady_clock::time_point amended_at_;
+  PlayerPollerStats stats_;
+  // Polls left at the settling interval after a command
+  int settle_polls_;
+  // Interval while nothing changes, doubled up to a ceiling
+  int quiet_ms_;
+};
+
+// The poller shared by the menus
+PlayerPoller &player_poller();
+
+#endif // PLAYER_STATE_H
@@ -0,0 +1,57 @@
+// include/playlist_store.h
+#ifndef PLAYLIST_STORE_H
+#define PLAYLIST_STORE_H
+
+#include "json_extract.h"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct PlaylistStoreStats {
+  uint64_t hits;   // track lists read back at an unchanged snapshot
+  uint64_t misses; // lookups with no copy, or one of another snapshot
+  uint64_t saves;
+
+  PlaylistStoreStats() : hits(0), misses(0), saves(0) {}
+};
+
+// Local copies of playlist track lists (name and URI of each track), keyed
+// by playlist ID and tagged with the snapshot_id they were fetched at. The
+// snapshot_id changes whenever a playlist is edited, so a copy whose
+// snapshot matches the one in the latest me/playlists listing is current
+// and the tracks need not be fetched again. One tab separated file per
+// playlist in the store's directory. Thread-safe.
+class PlaylistStore {
+public:
+  explicit PlaylistStore(const std::string &directory);
+
+  // True when the copy of playlist_id is at snapshot_id
+  bool has(const std::string &playlist_id, const std::string &snapshot_id);
+
+  // Replaces tracks with the copy of playlist_id if it is at snapshot_id
+  bool load(const std::string &playlist_id, const std::string &snapshot_id,
+            std::vector<NamedItem> &tracks);
+
+  bool save(const std::string &playlist_id, const std::string &snapshot_id,
+            const std::vector<NamedItem> &tracks);
+
+  // Deletes the copies of playlists not in playlist_ids, such as ones the
+  // user has unfollowed
+  void retain(const std::vector<std::string> &playlist_ids);
+
+  PlaylistStoreStats stats();
+
+private:
+  // Empty for an ID that is not safe as a file name
+  std::string path_of(const std::string &playlist_id) const;
+
+  std::string directory_;
+  std::mutex mutex_;
+  PlaylistStoreStats stats_;
+};
+
+// Process-wide store in <cache_directory()>/playlists
+PlaylistStore &playlist_store();
+
+#endif // PLAYLIST_STORE_H
@@ -0,0 +1,86 @@
+// include/request_builder.h
+#ifndef REQUEST_BUILDER_H
+#define REQUEST_BUILDER_H
+
+#include <string>
+#include <vector>
+
+// Builds URLs that share a base, such as one endpoint with different query
+// parameters, in one buffer. reset() goes back to the base and keeps the
+// capacity, so building the next URL does not allocate. Parameter values are
+// URL encoded.
+class UrlBuilder {
+public:
+  explicit UrlBuilder(const std::string &base);
+
+  UrlBuilder &reset();
+  UrlBuilder &param(const char *name, const std::string &value);
+  UrlBuilder &param(const char *name, long long value);
+
+  const std::string &str() const { return url_; }
+
+private:
+  void separator();
+
+  std::string url_;
+  size_t base_length_;
+  bool base_has_query_;
+};
+
+// Appends len bytes as a quoted JSON string to out, escaping quotes,
+// backslashes and control characters
+void append_json_string(std::string &out, const char *data, size_t len);
+
+// Writes a JSON document into a buffer, escaping strings and placing commas,
+// so that a value containing a quote cannot change the shape of a request
+// body. clear() keeps the capacity for the next document. Nesting is limited
+// to kMaxDepth containers.
+class JsonBuilder {
+public:
+  static const int kMaxDepth = 8;
+
+  JsonBuilder();
+
+  JsonBuilder &reserve(size_t bytes);
+  JsonBuilder &clear();
+  JsonBuilder &begin_object();
+  JsonBuilder &end_object();
+  JsonBuilder &begin_array();
+  JsonBuilder &end_array();
+  JsonBuilder &key(const char *name);
+  JsonBuilder &value(const std::string &value);
+  JsonBuilder &value(const char *value);
+  JsonBuilder &value(long long value);
+  // An array of count strings
+  JsonBuilder &string_array(const std::string *values, size_t count);
+  JsonBuilder &string_array(const std::vector<std::string> &values) {
+    return string_array(values.data(), values.size());
+  }
+
+  const std::string &str() const { return json_; }
+
+  // Moves the document out, leaving the builder empty
+  std::string release();
+
+private:
+  JsonBuilder &open(char bracket);
+  JsonBuilder &close(char bracket);
+  // Writes the comma before a value unless it is the first in its container
+  // or follows a key
+  void separate();
+
+  std::string json_;
+  bool first_[kMaxDepth + 1];
+  int depth_;
+  bool after_key_;
+};
+
+// {"<name>":["<value>",...]}, the shape of most Web API bodies that list
+// URIs or IDs
+std::string json_string_array_body(const char *name,
+                                   const std::vector<std::string> &values);
+
+// {"<name>":["<value>"]}
+std::string json_string_array_body(const char *name, const std::string &value);
+
+#endif // REQUEST_BUILDER_H
@@ -0,0 +1,114 @@
+// include/request_stats.h
+#ifndef REQUEST_STATS_H
+#define REQUEST_STATS_H
+
+#include "http_client.h"
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Counts of microsecond values in log-linear buckets, as HdrHistogram keeps
+// them: values below 64 get a bucket each, and every power of two above is
+// split into 32 equal buckets, so a percentile is within about 3% of the
+// recorded value. Values beyond kMaxValueUs are counted as kMaxValueUs.
+class LatencyHistogram {
+public:
+  static const uint64_t kMaxValueUs = (uint64_t(1) << 27) - 1; // ~134s
+
+  LatencyHistogram();
+
+  void record(uint64_t value_us);
+  void merge(const LatencyHistogram &other);
+
+  uint64_t count() const { return count_; }
+  uint64_t min() const { return count_ ? min_ : 0; }
+  uint64_t max() const { return max_; }
+  double mean() const { return count_ ? double(total_) / count_ : 0.0; }
+  // Highest value in the bucket holding the given percentile (0 to 100)
+  uint64_t percentile(double percent) const;
+
+private:
+  static size_t bucket_of(uint64_t value);
+  static uint64_t highest_in(size_t bucket);
+
+  std::vector<uint32_t> buckets_;
+  uint64_t count_;
+  uint64_t total_;
+  uint64_t min_;
+  uint64_t max_;
+};
+
+// Parts of a request that are timed separately. DNS, connect and TLS are
+// only recorded for transfers that opened a new connection.
+enum class RequestPhase { DNS, CONNECT, TLS, FIRST_BYTE, TOTAL, PARSE };
+const int kRequestPhases = 6;
+
+// Label of a phase, e.g. "first byte"
+const char *request_phase_name(RequestPhase phase);
+
+struct EndpointStats {
+  std::string endpoint;              // "GET /v1/playlists/{id}/tracks"
+  uint64_t requests;                 // transfers, each retry counted
+  uint64_t transport_errors;         // transfers that got no response
+  uint64_t new_connections;          // transfers that opened a connection
+  uint64_t response_bytes;           // body bytes received
+  std::map<long, uint64_t> statuses; // responses by HTTP status
+  LatencyHistogram phases[kRequestPhases];
+
+  EndpointStats()
+      : requests(0), transport_errors(0), new_connections(0),
+        response_bytes(0) {}
+};
+
+// Per-endpoint timings of every request the HTTP client completes and of
+// parsing their responses. URLs are grouped by method and path, with IDs in
+// the path replaced by {id} and the query dropped, so all pages of one
+// playlist share an entry. Recording takes one short lock. Thread-safe.
+class RequestStats {
+public:
+  // Endpoints tracked separately; later ones are counted under "other"
+  static const size_t kMaxEndpoints = 64;
+
+  RequestStats();
+
+  void record_transfer(const HttpRequest &request,
+                       const HttpResponse &response);
+  void record_parse(const std::string &method, const std::string &url,
+                    uint64_t elapsed_us);
+
+  // Copies every endpoint's figures, busiest first
+  std::vector<EndpointStats> snapshot();
+  void clear();
+
+private:
+  EndpointStats &entry(const std::string &endpoint);
+
+  std::mutex mutex_;
+  std::map<std::string, std::unique_ptr<EndpointStats>> endpoints_;
+};
+
+// Groups a URL the way RequestStats does: "GET /v1/playlists/{id}/tracks"
+std::string request_endpoint(const std::string &method,
+                             const std::string &url);
+
+// Process-wide statistics fed by the HTTP client and the Web API helpers
+RequestStats &request_stats();
+
+// Writes one block per endpoint: counts, statuses, bytes, and the 50th, 90th,
+// 99th percentile and maximum of every phase
+void write_request_stats(std::ostream &out,
+                         const std::vector<EndpointStats> &endpoints);
+
+// Writes the current statistics to path; false if it cannot be written
+bool dump_request_stats(const std::string &path);
+
+// Dumps the statistics to path whenever the process receives SIGUSR1. Call
+// from main before any other thread starts, so that every thread inherits
+// the blocked signal and only the dumping thread receives it.
+void dump_request_stats_on_signal(const std::string &path);
+
+#endif // REQUEST_STATS_H
@@ -0,0 +1,85 @@
+// include/response_cache.h
+#ifndef RESPONSE_CACHE_H
+#define RESPONSE_CACHE_H
+
+#include "json_extract.h"
+#include "rapidjson/document.h"
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+struct ResponseCacheStats {
+  uint64_t lookups;     // GETs that consulted the cache
+  uint64_t hits;        // answered 304 and served from the cache
+  uint64_t stores;      // 200 responses with an ETag that were cached
+  uint64_t bytes_saved; // body bytes not downloaded thanks to hits
+
+  ResponseCacheStats() : lookups(0), hits(0), stores(0), bytes_saved(0) {}
+
+  double hit_ratio() const {
+    return lookups ? static_cast<double>(hits) / lookups : 0.0;
+  }
+};
+
+// In-memory cache of parsed GET responses keyed by URL. Each entry keeps the
+// ETag the server sent so the next GET can be made conditional with
+// If-None-Match; a 304 is then answered from the cached document, or from the
+// items extracted for a list view, without downloading or parsing the body
+// again. Least recently used entries are evicted beyond max_entries.
+// Thread-safe.
+class ResponseCache {
+public:
+  explicit ResponseCache(size_t max_entries = kDefaultMaxEntries);
+
+  // Returns the cached document for url and its ETag, or null
+  std::shared_ptr<const rapidjson::Document> find(const std::string &url,
+                                                  std::string &etag);
+
+  // Returns the items cached for url in view and their ETag, or null
+  std::shared_ptr<const ItemPage> find_items(const std::string &url,
+                                             ItemView view, std::string &etag);
+
+  // Both store a copy; a response with the ETag already cached for url adds
+  // to that entry, so the document and the items of one URL can share it
+  void store(const std::string &url, const std::string &etag,
+             const rapidjson::Value &doc, size_t body_bytes);
+  void store_items(const std::string &url, const std::string &etag,
+                   ItemView view, const ItemPage &page, size_t body_bytes);
+
+  // Records a 304 answered from the entry for url
+  void record_hit(const std::string &url);
+
+  ResponseCacheStats stats();
+  void clear();
+
+  static const size_t kDefaultMaxEntries = 256;
+
+private:
+  struct Entry {
+    std::string url;
+    std::string etag;
+    std::shared_ptr<const rapidjson::Document> doc; // or null
+    std::shared_ptr<const ItemPage> items;          // or null
+    ItemView view;                                  // of items
+    size_t body_bytes;
+  };
+
+  // Returns the entry for url with etag, replacing one with another ETag.
+  // Called with mutex_ held.
+  Entry &entry_for(const std::string &url, const std::string &etag,
+                   size_t body_bytes);
+
+  std::mutex mutex_;
+  size_t max_entries_;
+  std::list<Entry> lru_; // most recently used first
+  std::unordered_map<std::string, std::list<Entry>::iterator> by_url_;
+  ResponseCacheStats stats_;
+};
+
+// Process-wide cache used by spotify_get_json and spotify_get_items
+ResponseCache &response_cache();
+
+#endif // RESPONSE_CACHE_H
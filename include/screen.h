@@ -0,0 +1,133 @@
+// include/screen.h
+#ifndef SCREEN_H
+#define SCREEN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Cell attributes, combined with |
+const uint8_t kStyleBold = 1;
+const uint8_t kStyleDim = 2;
+const uint8_t kStyleReverse = 4;
+
+// Frames taking longer than this to diff and write count as over budget
+const double kFrameBudgetMs = 16.0;
+
+enum class Key {
+  NONE, // nothing arrived before the timeout
+  CHAR,
+  ENTER,
+  ESCAPE,
+  BACKSPACE,
+  UP,
+  DOWN,
+  PAGE_UP,
+  PAGE_DOWN,
+  HOME,
+  END,
+  RESIZE, // the terminal changed size
+};
+
+struct KeyEvent {
+  Key key;
+  uint32_t ch; // code point of a CHAR
+
+  KeyEvent(Key key = Key::NONE, uint32_t ch = 0) : key(key), ch(ch) {}
+};
+
+struct FrameStats {
+  double last_ms;       // diffing and writing the last frame
+  double max_ms;        // slowest frame so far
+  uint64_t frames;      // frames presented
+  uint64_t over_budget; // frames slower than kFrameBudgetMs
+  size_t cells_changed; // cells the last frame rewrote
+  size_t bytes_written; // bytes the last frame sent to the terminal
+
+  FrameStats()
+      : last_ms(0), max_ms(0), frames(0), over_budget(0), cells_changed(0),
+        bytes_written(0) {}
+};
+
+// Full-screen terminal output through a back buffer. Drawing only changes
+// the back buffer; present() compares it with what the terminal shows and
+// sends escape sequences for the cells that differ, so an unchanged screen
+// costs nothing to redraw and scrolling a list rewrites only the rows whose
+// text moved. Input is read without blocking from the same terminal. Not
+// thread-safe.
+class Screen {
+public:
+  Screen();
+  ~Screen();
+
+  // True when stdin and stdout are a terminal that can be driven full screen
+  static bool available();
+
+  // Switches to the alternate screen with echo and line buffering off and
+  // sizes the buffers to the terminal. False when the terminal is not
+  // available.
+  bool start();
+  // Restores the terminal; also done on destruction
+  void stop();
+
+  int rows() const { return rows_; }
+  int cols() const { return cols_; }
+  // Sizes the buffers without a terminal, for rendering off screen. The next
+  // frame redraws every cell.
+  void resize(int rows, int cols);
+
+  // Blanks the back buffer
+  void clear();
+  // Draws text from column col, clipped to width columns (the rest of the row
+  // when negative). Returns the number of columns used.
+  int draw_text(int row, int col, const std::string &utf8, uint8_t style = 0,
+                int width = -1);
+  // Blanks width columns from col in style
+  void fill(int row, int col, int width, uint8_t style);
+
+  // Writes the differences to the terminal and makes them the current screen
+  void present();
+  // Appends the escape sequences present() would write to out instead, and
+  // makes the back buffer current
+  void diff(std::string &out);
+  const FrameStats &frame_stats() const { return stats_; }
+
+  // Waits up to timeout_ms (forever when negative) for a key
+  KeyEvent read_key(int timeout_ms);
+
+private:
+  struct Cell {
+    uint32_t ch; // code point; 0 for the right half of a wide glyph
+    uint8_t style;
+
+    bool operator!=(const Cell &other) const {
+      return ch != other.ch || style != other.style;
+    }
+  };
+
+  Screen(const Screen &);
+  Screen &operator=(const Screen &);
+
+  void write_out(const std::string &out);
+  bool terminal_size(int &rows, int &cols) const;
+  bool fill_input(int timeout_ms);
+  KeyEvent parse_escape();
+
+  int rows_;
+  int cols_;
+  std::vector<Cell> back_;
+  std::vector<Cell> front_;
+  // Reused between frames so that presenting does not allocate
+  std::string out_;
+  // Bytes read from the terminal but not yet turned into keys
+  std::string input_;
+  FrameStats stats_;
+  bool started_;
+  // Terminal settings to restore on stop()
+  struct Terminal;
+  std::unique_ptr<Terminal> terminal_;
+};
+
+#endif // SCREEN_H
@@ -0,0 +1,75 @@
+// include/search_index.h
+#ifndef SEARCH_INDEX_H
+#define SEARCH_INDEX_H
+
+#include "json_extract.h"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class LocalKind { TRACK, ARTIST, ALBUM, PLAYLIST };
+
+struct LocalHit {
+  std::string name;
+  std::string uri; // empty for artists and albums known only by name
+  LocalKind kind;
+  int score;
+};
+
+// In-memory full-text index over every name the client has seen. Names are
+// folded to lowercase alphanumeric words and indexed by their character
+// trigrams, so a query matches case-insensitively, as a prefix of a word
+// and with a typo or two: a candidate needs half of the query's trigrams.
+// Exact and word-prefix matches rank first. Thread-safe.
+class SearchIndex {
+public:
+  // Adds an entry unless one with the same kind and URI (or name, when the
+  // URI is empty) already exists
+  void add(LocalKind kind, const std::string &name, const std::string &uri);
+
+  std::vector<LocalHit> search(const std::string &query,
+                               size_t limit = kDefaultLimit);
+  std::vector<LocalHit> search(const std::string &query, LocalKind kind,
+                               size_t limit = kDefaultLimit);
+
+  size_t size();
+  void clear();
+
+  static const size_t kDefaultLimit = 20;
+
+private:
+  struct Entry {
+    std::string name;
+    std::string uri;
+    std::string folded; // normalized words, space separated
+    LocalKind kind;
+  };
+
+  std::vector<LocalHit> search_locked(const std::string &query,
+                                      const LocalKind *kind, size_t limit);
+
+  std::mutex mutex_;
+  std::vector<Entry> entries_;
+  std::unordered_map<std::string, uint32_t> by_key_;
+  // Trigram -> ids of the entries containing it, in ascending order
+  std::unordered_map<uint32_t, std::vector<uint32_t>> postings_;
+  // Per-query scratch: shared-trigram count per entry and the entries
+  // counted, so that only those need resetting
+  std::vector<uint16_t> counts_;
+  std::vector<uint32_t> touched_;
+};
+
+// Folds a name to lowercase ASCII alphanumeric words separated by single
+// spaces; bytes of multibyte UTF-8 characters are kept as they are
+std::string fold_for_search(const std::string &text);
+
+// Process-wide index, filled as playlists, tracks, search results and the
+// saved-tracks store are loaded
+SearchIndex &search_index();
+
+// Adds every item of a fetched list view to search_index()
+void index_item_page(ItemView view, const ItemPage &page);
+
+#endif // SEARCH_INDEX_H
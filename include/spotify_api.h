@@ -0,0 +1,132 @@
+// include/spotify_api.h
+#ifndef SPOTIFY_API_H
+#define SPOTIFY_API_H
+
+#include "document_pool.h"
+#include "http_client.h"
+#include "json_extract.h"
+#include "rapidjson/document.h"
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Builds a Web API URL from a path such as "/me/playlists?limit=20"
+std::string spotify_api_url(const std::string &path);
+
+// Builds an accounts service URL from a path such as "/api/token"
+std::string spotify_accounts_url(const std::string &path);
+
+// The Authorization header for an access token, with the JSON Content-Type
+// when json is set. The lists of the most recent token are kept and shared
+// by every request until the token changes.
+std::shared_ptr<const HttpHeaderList>
+spotify_auth_headers(const std::string &access_token, bool json);
+
+// Strips the "spotify:<type>:" prefix from a URI; bare IDs pass through
+std::string spotify_id_from_uri(const std::string &uri);
+
+// Points both services at one root, e.g. "http://127.0.0.1:8080" for a local
+// stand-in: the Web API is then served under <root>/v1 and the accounts
+// service at <root>. An empty root restores the real Spotify hosts. The
+// SPOTIFY_TUI_ENDPOINT environment variable sets the initial root. Call this
+// before any requests are in flight.
+void set_spotify_endpoint_root(const std::string &root);
+
+// Performs an authorized GET and parses the JSON response into doc. Fails on
+// any status other than 2xx, or a 304 answered from the response cache. A 204
+// leaves doc null.
+bool spotify_get_json(const std::string &access_token, const std::string &url,
+                      rapidjson::Document &doc);
+
+typedef std::function<void(bool ok, rapidjson::Document &doc)> JsonCallback;
+
+// Asynchronous GET; the response is parsed and the callback invoked on the
+// HTTP event loop thread
+void spotify_get_json_async(const std::string &access_token,
+                            const std::string &url, JsonCallback callback);
+
+// Asynchronous GET into doc, which must stay alive until the future is ready
+std::future<bool> spotify_get_json_async(const std::string &access_token,
+                                         const std::string &url,
+                                         rapidjson::Document &doc);
+
+// Performs an authorized GET into a document from document_pool(), leasing
+// one first if doc is empty
+bool spotify_get_pooled_json(const std::string &access_token,
+                             const std::string &url, DocumentLease &doc);
+
+typedef std::function<void(bool ok, DocumentLease &doc)> PooledJsonCallback;
+
+// Asynchronous GET into a pooled document; the callback may keep the lease by
+// moving it out
+void spotify_get_pooled_json_async(const std::string &access_token,
+                                   const std::string &url,
+                                   PooledJsonCallback callback);
+
+typedef std::function<void(bool ok, ItemPage &page)> ItemsCallback;
+
+// Performs an authorized GET and extracts the items of a list view straight
+// from the response buffer, without building a DOM. A 304 is answered from
+// the items in the response cache.
+bool spotify_get_items(const std::string &access_token, const std::string &url,
+                       ItemView view, ItemPage &page);
+
+// Asynchronous variant of spotify_get_items; the callback runs on the HTTP
+// event loop thread. The returned id can be passed to http_cancel.
+HttpRequestId spotify_get_items_async(const std::string &access_token,
+                                      const std::string &url, ItemView view,
+                                      ItemsCallback callback);
+
+// Asynchronous GET into page, which must stay alive until the future is ready
+std::future<bool> spotify_get_items_async(const std::string &access_token,
+                                          const std::string &url,
+                                          ItemView view, ItemPage &page);
+
+// Sends an authorized request without a JSON body; true on a 2xx status
+bool spotify_send(const std::string &access_token, const std::string &method,
+                  const std::string &url);
+
+// Sends an authorized request with a JSON body; true on a 2xx status. On
+// failure error receives the transport error, or the HTTP status and the
+// message the Web API returned.
+bool spotify_send_json(const std::string &access_token,
+                       const std::string &method, const std::string &url,
+                       const std::string &json_body,
+                       std::string *error = nullptr);
+
+// Why a request did not succeed: the transport error, or the status and the
+// message of the Web API's error object
+std::string spotify_failure_message(const HttpResponse &response);
+
+typedef std::function<void(bool ok, HttpResponse &response)> SendCallback;
+
+// Asynchronous variant of spotify_send; ok means a 2xx status
+void spotify_send_async(const std::string &access_token,
+                        const std::string &method, const std::string &url,
+                        SendCallback callback);
+
+// Asynchronous variant of spotify_send_json; ok means a 2xx status
+void spotify_send_json_async(const std::string &access_token,
+                             const std::string &method,
+                             const std::string &url,
+                             const std::string &json_body,
+                             SendCallback callback);
+
+// Sends each body to the same endpoint as its own request, with at most
+// concurrency requests in flight; a concurrency of 1 keeps them in order.
+// Returns whether each request got a 2xx status, indexed like bodies.
+std::vector<bool>
+spotify_send_json_batch(const std::string &access_token,
+                        const std::string &method, const std::string &url,
+                        const std::vector<std::string> &bodies,
+                        int concurrency);
+
+// Same as spotify_send_json_batch for requests without a body, one per URL
+std::vector<bool> spotify_send_batch(const std::string &access_token,
+                                     const std::string &method,
+                                     const std::vector<std::string> &urls,
+                                     int concurrency);
+
+#endif // SPOTIFY_API_H
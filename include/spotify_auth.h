@@ -1,8 +1,45 @@
 #ifndef SPOTIFY_AUTH_H
 #define SPOTIFY_AUTH_H
 
+#include <ctime>
 #include <string>
 
+// Everything needed to obtain new access tokens without user interaction
+struct SpotifySession {
+  std::string client_id;
+  std::string client_secret;
+  std::string access_token;
+  std::string refresh_token;
+  std::time_t expires_at; // 0 when unknown
+
+  SpotifySession() : expires_at(0) {}
+};
+
+// Default session file, kept in config_directory()
+std::string session_path();
+
+// The session file is written with owner-only permissions; a file readable
+// by anyone else is ignored on load
+bool load_session(const std::string &path, SpotifySession &session);
+bool save_session(const std::string &path, const SpotifySession &session);
+
+// Exchanges the refresh token for a new access token at the accounts
+// service; keeps the old refresh token unless a new one is issued
+bool refresh_session(SpotifySession &session);
+
+// Restores the session at path, refreshing the access token with a single
+// request if it has expired, and saves the result. Never prompts.
+bool resume_session(const std::string &path, SpotifySession &session);
+
+// Resumes the saved session, falling back to the interactive authorization
+// code flow when there is none or it can no longer be refreshed
 bool authenticate(std::string &access_token);
 
+// Same as authenticate() without the interactive fallback, for scripts
+bool resume_saved_session(std::string &access_token);
+
+// Refreshes the session authenticate() established when its access token is
+// about to expire; returns false if it expired and could not be refreshed
+bool refresh_if_expiring(std::string &access_token);
+
 #endif // SPOTIFY_AUTH_H
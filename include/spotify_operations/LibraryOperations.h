@@ -1,19 +1,50 @@
 #ifndef LIBRARY_OPERATIONS_H
 #define LIBRARY_OPERATIONS_H
 
+#include "catalog.h"
+#include "document_pool.h"
+#include "library_store.h"
+#include "pagination.h"
 #include "rapidjson/document.h"
+#include <future>
 #include <string>
 #include <vector>
 
+// Most track IDs the Web API accepts in one save or remove request
+const int kLibraryBatchSize = 50;
+// Save/remove requests kept in flight by the batch operations
+const int kDefaultLibraryConcurrency = 4;
+
 void library_menu(const std::string &access_token);
 bool get_saved_tracks(const std::string &access_token,
                       rapidjson::Document &saved_tracks, int limit = 20,
                       int offset = 0);
-std::vector<std::pair<std::string, std::string>>
+// Into a pooled document, leased first if saved_tracks is empty
+bool get_saved_tracks(const std::string &access_token,
+                      DocumentLease &saved_tracks, int limit = 20,
+                      int offset = 0);
+std::future<bool> get_saved_tracks_async(const std::string &access_token,
+                                         rapidjson::Document &saved_tracks,
+                                         int limit = 20, int offset = 0);
+bool get_all_saved_tracks(const std::string &access_token,
+                          const PageCallback &on_page,
+                          int window = kDefaultPageWindow);
+CatalogView
 display_saved_tracks_and_select(const rapidjson::Document &saved_tracks);
+CatalogView display_saved_tracks_and_select(LibraryStore &store);
 bool add_track_to_library(const std::string &access_token,
                           const std::string &track_uri);
 bool remove_track_from_library(const std::string &access_token,
                                const std::string &track_uri);
+size_t save_tracks_to_library(const std::string &access_token,
+                              const std::vector<std::string> &track_uris,
+                              int concurrency = kDefaultLibraryConcurrency);
+size_t remove_tracks_from_library(const std::string &access_token,
+                                  const std::vector<std::string> &track_uris,
+                                  int concurrency = kDefaultLibraryConcurrency);
+bool get_all_album_track_items(const std::string &access_token,
+                               const std::string &album_id,
+                               const ItemPageCallback &on_page,
+                               int window = kDefaultPageWindow);
 
 #endif // LIBRARY_OPERATIONS_H
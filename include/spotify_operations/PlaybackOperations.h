@@ -1,9 +1,86 @@
 #ifndef PLAYBACK_OPERATIONS_H
 #define PLAYBACK_OPERATIONS_H
 
+#include "player_state.h"
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <thread>
+
+// Player settings of which only the latest value matters
+enum class PlayerSetting { PLAYBACK, VOLUME, SHUFFLE, REPEAT };
+const int kPlayerSettings = 4;
+
+struct PlayerCommandStats {
+  uint64_t requested; // commands asked for, counting each skip
+  uint64_t sent;      // requests started
+  uint64_t coalesced; // values replaced by a later one before being sent
+  uint64_t failed;    // requests that failed and were rolled back
+
+  PlayerCommandStats() : requested(0), sent(0), coalesced(0), failed(0) {}
+};
+
+// Sends player commands without waiting for them. A change shows in
+// snapshot() at once. A setting is sent once it has not changed for the
+// settle interval, and each setting has at most one request in flight;
+// values set meanwhile replace each other, so a burst of volume changes
+// sends only the last. Skips are sent one after another. A confirmed change is
+// written to the poller's cache; a failed one is dropped, so snapshot() falls
+// back to the state last read from the player, and take_error() says why.
+// All methods are thread-safe.
+class PlayerCommands {
+public:
+  static const int kDefaultSettleMs = 150;
+
+  explicit PlayerCommands(int settle_ms = kDefaultSettleMs);
+  ~PlayerCommands();
+  PlayerCommands(const PlayerCommands &) = delete;
+  PlayerCommands &operator=(const PlayerCommands &) = delete;
+
+  void set_playing(const std::string &access_token, bool playing);
+  // Plays when paused and pauses when playing; false when the state is
+  // unknown
+  bool toggle_playing(const std::string &access_token);
+  // False for a volume outside 0-100
+  bool set_volume(const std::string &access_token, int volume);
+  // Changes the volume by delta, clamped to 0-100; false when the device
+  // does not report a volume
+  bool nudge_volume(const std::string &access_token, int delta);
+  void set_shuffle(const std::string &access_token, bool enable);
+  // False for a state other than "track", "context" or "off"
+  bool set_repeat(const std::string &access_token, const std::string &state);
+  void skip(const std::string &access_token);
+
+  // The poller's cached state with the unconfirmed commands applied, and
+  // the number of skips not yet confirmed; false when nothing is cached
+  bool snapshot(PlayerState &state, int *pending_skips = nullptr);
+  // Waits until every command has been sent and answered
+  void wait();
+  // Stops the thread that sends settled values; a value still settling is
+  // not sent. Call wait() first to keep it.
+  void stop();
+  // Returns and clears the message of the last rolled back command
+  std::string take_error();
+  PlayerCommandStats stats();
+
+private:
+  struct State;
+
+  void change(const std::string &access_token, PlayerSetting setting,
+              const std::string &value);
+  static void run(const std::shared_ptr<State> &state);
+  static void send_setting(const std::shared_ptr<State> &state, int index);
+  static void send_skip(const std::shared_ptr<State> &state);
+
+  std::shared_ptr<State> state_;
+  std::thread settler_;
+};
+
+// The command queue shared by the menus
+PlayerCommands &player_commands();
 
 void playback_menu(const std::string &access_token);
+void now_playing_view(const std::string &access_token);
 bool play_music(const std::string &access_token);
 bool pause_music(const std::string &access_token);
 bool skip_track(const std::string &access_token);
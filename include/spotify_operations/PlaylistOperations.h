@@ -1,22 +1,115 @@
 #ifndef PLAYLIST_OPERATIONS_H
 #define PLAYLIST_OPERATIONS_H
 
+#include "catalog.h"
+#include "pagination.h"
 #include "rapidjson/document.h"
+#include <future>
+#include <memory>
 #include <string>
 #include <vector>
 
+// Most URIs the Web API accepts in one add-to-playlist request
+const int kPlaylistAddBatchSize = 100;
+
+// Collects track URIs for one playlist and adds them in JSON-body POSTs of
+// up to kPlaylistAddBatchSize URIs. Full batches are sent in the background
+// while add() keeps collecting, one request at a time so that the tracks
+// land in the order they were added, starting at position (appended when
+// position is negative). Each batch is placed after the tracks that were
+// actually added, so a failed batch does not shift the ones after it.
+class PlaylistTrackBatch {
+public:
+  PlaylistTrackBatch(const std::string &access_token,
+                     const std::string &playlist_id, int position = -1);
+  ~PlaylistTrackBatch();
+  PlaylistTrackBatch(const PlaylistTrackBatch &) = delete;
+  PlaylistTrackBatch &operator=(const PlaylistTrackBatch &) = delete;
+
+  void add(const std::string &track_uri);
+
+  // Sends the remaining URIs, waits for every request and returns the
+  // number of tracks added so far
+  size_t flush();
+  size_t failed();
+
+private:
+  struct State;
+
+  void submit_pending();
+  static void send_next(const std::shared_ptr<State> &state);
+
+  std::vector<std::string> pending_;
+  std::shared_ptr<State> state_;
+};
+
 void playlist_menu(const std::string &access_token);
 bool get_user_playlists(const std::string &access_token,
                         rapidjson::Document &playlists, int limit = 20,
                         int offset = 0);
-std::vector<std::pair<std::string, std::string>>
-display_playlists_and_select(const rapidjson::Document &playlists);
+std::future<bool> get_user_playlists_async(const std::string &access_token,
+                                           rapidjson::Document &playlists,
+                                           int limit = 20, int offset = 0);
+bool get_all_user_playlists(const std::string &access_token,
+                            const PageCallback &on_page,
+                            int window = kDefaultPageWindow);
+bool get_all_user_playlist_items(const std::string &access_token,
+                                 const ItemPageCallback &on_page,
+                                 int window = kDefaultPageWindow);
+CatalogView display_playlists_and_select(const rapidjson::Document &playlists);
+void display_playlist_page(const rapidjson::Value &page,
+                           CatalogView &playlists);
 bool get_playlist_tracks(const std::string &access_token,
                          const std::string &playlist_id,
                          rapidjson::Document &tracks, int limit = 20,
                          int offset = 0);
-std::vector<std::pair<std::string, std::string>>
-display_tracks_and_select(const rapidjson::Document &tracks);
+std::future<bool> get_playlist_tracks_async(const std::string &access_token,
+                                            const std::string &playlist_id,
+                                            rapidjson::Document &tracks,
+                                            int limit = 20, int offset = 0);
+bool get_all_playlist_tracks(const std::string &access_token,
+                             const std::string &playlist_id,
+                             const PageCallback &on_page,
+                             int window = kDefaultPageWindow);
+bool get_all_playlist_track_items(const std::string &access_token,
+                                  const std::string &playlist_id,
+                                  const ItemPageCallback &on_page,
+                                  int window = kDefaultPageWindow);
+bool get_playlist_track_items_cached(const std::string &access_token,
+                                     const std::string &playlist_id,
+                                     const std::string &snapshot_id,
+                                     const ItemPageCallback &on_page,
+                                     int window = kDefaultPageWindow);
+
+// Playlists whose tracks refresh_playlists fetches at once
+const int kDefaultRefreshConcurrency = 4;
+
+struct PlaylistRefresh {
+  size_t playlists; // in the listing
+  size_t unchanged; // stored copy already at the listed snapshot_id
+  size_t fetched;   // track lists downloaded and stored
+  size_t failed;
+
+  PlaylistRefresh() : playlists(0), unchanged(0), fetched(0), failed(0) {}
+};
+
+bool refresh_playlists(const std::string &access_token,
+                       PlaylistRefresh &result,
+                       int concurrency = kDefaultRefreshConcurrency);
+CatalogView display_tracks_and_select(const rapidjson::Document &tracks);
+void display_track_page(const rapidjson::Value &page, CatalogView &tracks);
+void display_item_page(const ItemPage &page, CatalogKind kind,
+                       CatalogView &items);
+void list_item_page(const ItemPage &page, CatalogKind kind,
+                    CatalogView &items);
+CatalogRef choose_from_view(const CatalogView &view, const std::string &title,
+                            const std::string &prompt);
+std::string catalog_entry_text(CatalogRef ref);
+void display_catalog_entry(size_t number, CatalogRef ref);
+size_t add_tracks_to_playlist(const std::string &access_token,
+                              const std::string &playlist_id,
+                              const std::vector<std::string> &track_uris,
+                              int position = -1);
 void play_selected_track(const std::string &access_token,
                          const std::string &track_uri);
 
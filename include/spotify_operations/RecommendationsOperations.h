@@ -1,7 +1,10 @@
 #ifndef RECOMMENDATIONS_OPERATIONS_H
 #define RECOMMENDATIONS_OPERATIONS_H
 
+#include "catalog.h"
+#include "json_extract.h"
 #include "rapidjson/document.h"
+#include <future>
 #include <string>
 #include <vector>
 
@@ -14,8 +17,16 @@ display_available_genres_and_select(const rapidjson::Document &available_genres,
 bool get_recommendations(const std::string &access_token,
                          const std::vector<std::string> &seed_genres,
                          rapidjson::Document &recommendations, int limit = 20);
-std::vector<std::pair<std::string, std::string>>
+std::future<bool>
+get_recommendations_async(const std::string &access_token,
+                          const std::vector<std::string> &seed_genres,
+                          rapidjson::Document &recommendations, int limit = 20);
+bool get_recommendation_items(const std::string &access_token,
+                              const std::vector<std::string> &seed_genres,
+                              ItemPage &recommendations, int limit = 20);
+CatalogRef
 display_recommendations_and_select(const rapidjson::Document &recommendations);
+CatalogRef display_recommendations_and_select(const ItemPage &recommendations);
 void play_recommended_track(const std::string &access_token,
                             const std::string &track_uri);
 
@@ -1,24 +1,60 @@
 #ifndef SEARCH_OPERATIONS_H
 #define SEARCH_OPERATIONS_H
 
+#include "catalog.h"
+#include "json_extract.h"
+#include "spotify_api.h"
 #include "rapidjson/document.h"
+#include <future>
 #include <string>
 #include <vector>
 
 enum class SearchType { TRACK, ARTIST, ALBUM, PLAYLIST };
 
+// Queue additions kept in flight by add_tracks_to_queue. The queue endpoint
+// takes one URI per request and overlapping requests may be applied out of
+// order, so the default keeps them strictly ordered.
+const int kDefaultQueueWindow = 1;
+
 void search_menu(const std::string &access_token);
 bool search_spotify(const std::string &access_token, const std::string &query,
                     SearchType type, rapidjson::Document &results,
                     int limit = 10);
+std::future<bool> search_spotify_async(const std::string &access_token,
+                                       const std::string &query,
+                                       SearchType type,
+                                       rapidjson::Document &results,
+                                       int limit = 10);
+bool search_spotify_items(const std::string &access_token,
+                          const std::string &query, SearchType type,
+                          ItemPage &results, int limit = 10);
+std::future<bool> search_spotify_items_async(const std::string &access_token,
+                                             const std::string &query,
+                                             SearchType type,
+                                             ItemPage &results,
+                                             int limit = 10);
+HttpRequestId search_spotify_items_async(const std::string &access_token,
+                                         const std::string &query,
+                                         SearchType type,
+                                         ItemsCallback callback,
+                                         int limit = 10);
+bool search_local_first(const std::string &access_token,
+                        const std::string &query, SearchType type,
+                        ItemPage &results, int limit = 10);
 void display_search_results(const rapidjson::Document &results,
                             SearchType type);
-std::vector<std::pair<std::string, std::string>>
-select_from_search_results(const rapidjson::Document &results, SearchType type);
+void display_search_results(const ItemPage &results);
+CatalogRef select_from_search_results(const rapidjson::Document &results,
+                                      SearchType type);
+CatalogRef select_from_search_results(const ItemPage &results,
+                                      SearchType type = SearchType::TRACK);
 bool add_track_to_playlist(const std::string &access_token,
                            const std::string &playlist_id,
                            const std::string &track_uri);
 bool add_track_to_queue(const std::string &access_token,
                         const std::string &track_uri);
+size_t add_tracks_to_queue(const std::string &access_token,
+                           const std::vector<std::string> &track_uris,
+                           int window = kDefaultQueueWindow);
 
 #endif // SEARCH_OPERATIONS_H
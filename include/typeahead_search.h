@@ -0,0 +1,70 @@
+// include/typeahead_search.h
+#ifndef TYPEAHEAD_SEARCH_H
+#define TYPEAHEAD_SEARCH_H
+
+#include "json_extract.h"
+#include "spotify_operations/SearchOperations.h"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+typedef std::chrono::steady_clock TypeAheadClock;
+
+struct TypeAheadResult {
+  std::string query;
+  ItemPage page;
+  bool ok;
+  bool from_cache;
+  TypeAheadClock::time_point keystroke_at; // keystroke that produced query
+};
+
+struct TypeAheadStats {
+  uint64_t keystrokes;
+  uint64_t requests;  // searches sent to the Web API
+  uint64_t cancelled; // superseded while in flight
+  uint64_t cache_hits;
+
+  TypeAheadStats() : keystrokes(0), requests(0), cancelled(0), cache_hits(0) {}
+};
+
+// Search-as-you-type against the Web API. A search starts only once no key
+// has been pressed for the debounce interval; starting one aborts the
+// previous request at the transport level. Results are kept in an LRU keyed
+// by (query, type), so revisiting a query, for example by deleting back to a
+// prefix, is answered at the keystroke without a request.
+class TypeAheadSearch {
+public:
+  static const int kDefaultDebounceMs = 150;
+  static const size_t kCacheEntries = 128;
+
+  TypeAheadSearch(const std::string &access_token, SearchType type,
+                  int limit = 10, int debounce_ms = kDefaultDebounceMs);
+  ~TypeAheadSearch();
+  TypeAheadSearch(const TypeAheadSearch &) = delete;
+  TypeAheadSearch &operator=(const TypeAheadSearch &) = delete;
+
+  // Records a keystroke that changed the query
+  void set_query(const std::string &query);
+
+  // Starts the search for the current query once it is due. Returns the
+  // milliseconds until it will be due, or -1 when nothing is waiting.
+  int poll();
+
+  // Moves out the newest result if one arrived since the last call
+  bool take_result(TypeAheadResult &result);
+
+  // Becomes readable when a result arrives, to wait on it alongside input
+  int wake_fd() const;
+
+  TypeAheadStats stats();
+
+private:
+  struct State;
+
+  void start_search();
+
+  std::shared_ptr<State> state_;
+};
+
+#endif // TYPEAHEAD_SEARCH_H
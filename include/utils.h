@@ -8,16 +8,36 @@
 // Callback function for cURL to write response data
 size_t WriteCallback(void *contents, size_t size, size_t nmemb, void *userp);
 
-// Encodes a string for use in URLs
+// Encodes a string for use in URLs: everything but letters, digits and
+// "-._~" is percent-encoded
 std::string url_encode(const std::string &value);
 
+// Appends the URL encoding of len bytes to out; does not allocate when out
+// already has the capacity
+void append_url_encoded(std::string &out, const char *data, size_t len);
+
 // Trims whitespace from both ends of a string
 std::string trim(const std::string &s);
 
 // Splits a string by a delimiter and returns a vector of tokens
 std::vector<std::string> split(const std::string &s, char delimiter);
 
+// Escapes backslashes, tabs and newlines so that a value fits in one field
+// of a tab separated line
+std::string escape_tsv_field(const std::string &value);
+
+// Reverses escape_tsv_field
+std::string unescape_tsv_field(const std::string &value);
+
 // Gets input from the user with a prompt
 std::string get_input(const std::string &prompt);
 
+// Returns the per-user cache directory ($XDG_CACHE_HOME/spotify-tui or
+// ~/.cache/spotify-tui), creating it if needed
+std::string cache_directory();
+
+// Returns the per-user configuration directory ($XDG_CONFIG_HOME/spotify-tui
+// or ~/.config/spotify-tui), creating it with owner-only permissions
+std::string config_directory();
+
 #endif // UTILS_H
@@ -0,0 +1,518 @@
+// src/batch_mode.cpp
+#include "batch_mode.h"
+#include "request_builder.h"
+#include "spotify_api.h"
+#include "spotify_auth.h"
+#include "spotify_operations/LibraryOperations.h"
+#include "spotify_operations/PlaylistOperations.h"
+#include "spotify_operations/SearchOperations.h"
+#include "utils.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <istream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+const int kSearchLimit = 10;
+
+enum class CommandKind {
+  PLAY,
+  PAUSE,
+  NEXT,
+  PREVIOUS,
+  VOLUME,
+  SHUFFLE,
+  REPEAT,
+  QUEUE,
+  SEARCH,
+  SAVE,
+  REMOVE,
+  PLAYLIST_ADD,
+  WAIT,
+};
+
+struct CommandSpec {
+  const char *name;
+  CommandKind kind;
+  size_t min_args;
+  size_t max_args;
+  const char *usage;
+};
+
+const CommandSpec kCommands[] = {
+    {"play", CommandKind::PLAY, 0, kPlaylistAddBatchSize,
+     "play [uri...]                 resume, or play the given tracks"},
+    {"pause", CommandKind::PAUSE, 0, 0, "pause"},
+    {"next", CommandKind::NEXT, 0, 0, "next"},
+    {"previous", CommandKind::PREVIOUS, 0, 0, "previous"},
+    {"volume", CommandKind::VOLUME, 1, 1, "volume <0-100>"},
+    {"shuffle", CommandKind::SHUFFLE, 1, 1, "shuffle on|off"},
+    {"repeat", CommandKind::REPEAT, 1, 1, "repeat track|context|off"},
+    {"queue", CommandKind::QUEUE, 1, 1, "queue <uri>"},
+    {"search", CommandKind::SEARCH, 2, SIZE_MAX,
+     "search track|artist|album|playlist <query>"},
+    {"save", CommandKind::SAVE, 1, kLibraryBatchSize,
+     "save <track-uri...>           save tracks to the library"},
+    {"remove", CommandKind::REMOVE, 1, kLibraryBatchSize,
+     "remove <track-uri...>         remove tracks from the library"},
+    {"playlist-add", CommandKind::PLAYLIST_ADD, 2, kPlaylistAddBatchSize + 1,
+     "playlist-add <playlist-id> <uri...>"},
+    {"wait", CommandKind::WAIT, 0, 0,
+     "wait                          finish every earlier command first"},
+};
+
+struct Command {
+  size_t line;
+  std::string text;
+  CommandKind kind;
+  std::vector<std::string> args;
+  // Commands in one lane start in order; the empty lane has no order
+  std::string lane;
+  // Commands after the n-th wait
+  size_t segment;
+  bool finished;
+  bool ok;
+  int status;
+  std::string error;
+  ItemPage results;
+
+  Command()
+      : line(0), kind(CommandKind::WAIT), segment(0), finished(false),
+        ok(false), status(0) {}
+};
+
+struct Lane {
+  std::deque<size_t> queued;
+  int in_flight = 0;
+  CommandKind kind = CommandKind::WAIT; // of the requests in flight
+};
+
+struct BatchRun {
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::string access_token;
+  std::vector<Command> commands;
+  std::map<std::string, Lane> lanes;
+  // Unfinished commands per segment
+  std::vector<size_t> remaining;
+  int in_flight = 0;
+  size_t requests = 0;
+  bool input_done = false;
+};
+
+std::string validate(const Command &command) {
+  const std::vector<std::string> &args = command.args;
+  switch (command.kind) {
+  case CommandKind::VOLUME: {
+    char *end = nullptr;
+    long volume = std::strtol(args[0].c_str(), &end, 10);
+    if (*end || volume < 0 || volume > 100)
+      return "volume must be 0-100";
+    break;
+  }
+  case CommandKind::SHUFFLE:
+    if (args[0] != "on" && args[0] != "off")
+      return "shuffle takes on or off";
+    break;
+  case CommandKind::REPEAT:
+    if (args[0] != "track" && args[0] != "context" && args[0] != "off")
+      return "repeat takes track, context or off";
+    break;
+  case CommandKind::SEARCH:
+    if (args[0] != "track" && args[0] != "artist" && args[0] != "album" &&
+        args[0] != "playlist")
+      return "search type must be track, artist, album or playlist";
+    break;
+  default:
+    break;
+  }
+  return "";
+}
+
+std::string lane_of(const Command &command) {
+  switch (command.kind) {
+  case CommandKind::SEARCH:
+    return "";
+  case CommandKind::SAVE:
+  case CommandKind::REMOVE:
+    return "library";
+  case CommandKind::PLAYLIST_ADD:
+    return "playlist:" + command.args[0];
+  default:
+    return "player";
+  }
+}
+
+// Fills command from one line; sets error for a line that is not a command
+void parse_command(const std::string &line, Command &command) {
+  std::istringstream words(line);
+  std::string name;
+  words >> name;
+  command.text = trim(line);
+  std::string word;
+  while (words >> word)
+    command.args.push_back(word);
+
+  const CommandSpec *spec = nullptr;
+  for (const CommandSpec &candidate : kCommands) {
+    if (name == candidate.name)
+      spec = &candidate;
+  }
+  if (!spec) {
+    command.error = "unknown command " + name;
+    return;
+  }
+  command.kind = spec->kind;
+  if (command.args.size() < spec->min_args ||
+      command.args.size() > spec->max_args) {
+    command.error = std::string("usage: ") + spec->usage;
+    return;
+  }
+  command.error = validate(command);
+  if (command.kind == CommandKind::SEARCH) {
+    // The query is everything after the type
+    std::string query;
+    for (size_t i = 1; i < command.args.size(); ++i)
+      query += (i > 1 ? " " : "") + command.args[i];
+    command.args.resize(1);
+    command.args.push_back(query);
+  }
+  command.lane = lane_of(command);
+}
+
+void write_json_string(std::ostream &out, const std::string &value) {
+  out << '"';
+  for (char c : value) {
+    if (c == '"' || c == '\\') {
+      out << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char escaped[8];
+      std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      out << escaped;
+    } else {
+      out << c;
+    }
+  }
+  out << '"';
+}
+
+void write_result(std::ostream &out, const Command &command) {
+  out << "{\"line\":" << command.line << ",\"command\":";
+  write_json_string(out, command.text);
+  out << ",\"ok\":" << (command.ok ? "true" : "false");
+  if (command.status)
+    out << ",\"status\":" << command.status;
+  if (!command.error.empty()) {
+    out << ",\"error\":";
+    write_json_string(out, command.error);
+  }
+  if (command.kind == CommandKind::SEARCH && command.ok) {
+    out << ",\"results\":[";
+    for (size_t i = 0; i < command.results.items.size(); ++i) {
+      const NamedItem &item = command.results.items[i];
+      out << (i ? ",{\"name\":" : "{\"name\":");
+      write_json_string(out, item.name);
+      out << ",\"uri\":";
+      write_json_string(out, item.key);
+      out << '}';
+    }
+    out << ']';
+  }
+  out << "}\n";
+}
+
+// Called with the mutex held
+void finish(BatchRun &run, Command &command, bool ok, int status,
+            const std::string &error) {
+  command.finished = true;
+  command.ok = ok;
+  command.status = status;
+  if (!ok)
+    command.error = error;
+  --run.remaining[command.segment];
+}
+
+// Takes the lane's first command and, when coalescing, the commands of the
+// same kind queued right behind it that fit in the same request
+std::vector<size_t> take_batch(BatchRun &run, Lane &lane, bool coalesce) {
+  std::vector<size_t> batch(1, lane.queued.front());
+  lane.queued.pop_front();
+  const Command &head = run.commands[batch[0]];
+  size_t limit = 0;
+  size_t uris = head.args.size();
+  if (head.kind == CommandKind::SAVE || head.kind == CommandKind::REMOVE) {
+    limit = kLibraryBatchSize;
+  } else if (head.kind == CommandKind::PLAYLIST_ADD) {
+    limit = kPlaylistAddBatchSize;
+    uris -= 1; // the playlist ID
+  }
+  if (!coalesce || limit == 0)
+    return batch;
+  while (!lane.queued.empty()) {
+    const Command &next = run.commands[lane.queued.front()];
+    size_t next_uris = next.args.size() -
+                       (next.kind == CommandKind::PLAYLIST_ADD ? 1 : 0);
+    if (next.kind != head.kind || next.segment != head.segment ||
+        uris + next_uris > limit)
+      break;
+    uris += next_uris;
+    batch.push_back(lane.queued.front());
+    lane.queued.pop_front();
+  }
+  return batch;
+}
+
+// Called with the mutex held; sends one request for the commands in batch
+void start_request(const std::shared_ptr<BatchRun> &run,
+                   const std::string &lane_name,
+                   const std::vector<size_t> &batch) {
+  Lane &lane = run->lanes[lane_name];
+  const Command &head = run->commands[batch[0]];
+  ++run->in_flight;
+  ++run->requests;
+  ++lane.in_flight;
+  lane.kind = head.kind;
+
+  std::shared_ptr<BatchRun> shared = run;
+  Lane *lane_ptr = &lane;
+  auto done = [shared, lane_ptr, batch](bool ok, HttpResponse &response) {
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    std::string error = ok ? "" : spotify_failure_message(response);
+    for (size_t index : batch)
+      finish(*shared, shared->commands[index], ok, response.status, error);
+    --shared->in_flight;
+    --lane_ptr->in_flight;
+    shared->changed.notify_all();
+  };
+
+  const std::string &token = run->access_token;
+  const std::vector<std::string> &args = head.args;
+  switch (head.kind) {
+  case CommandKind::PLAY: {
+    std::string body = "{}";
+    if (!args.empty())
+      body = json_string_array_body("uris", args);
+    spotify_send_json_async(token, "PUT", spotify_api_url("/me/player/play"),
+                            body, done);
+    break;
+  }
+  case CommandKind::PAUSE:
+    spotify_send_async(token, "PUT", spotify_api_url("/me/player/pause"),
+                       done);
+    break;
+  case CommandKind::NEXT:
+    spotify_send_async(token, "POST", spotify_api_url("/me/player/next"),
+                       done);
+    break;
+  case CommandKind::PREVIOUS:
+    spotify_send_async(token, "POST", spotify_api_url("/me/player/previous"),
+                       done);
+    break;
+  case CommandKind::VOLUME:
+    spotify_send_async(
+        token, "PUT",
+        spotify_api_url("/me/player/volume?volume_percent=") + args[0], done);
+    break;
+  case CommandKind::SHUFFLE:
+    spotify_send_async(token, "PUT",
+                       spotify_api_url("/me/player/shuffle?state=") +
+                           (args[0] == "on" ? "true" : "false"),
+                       done);
+    break;
+  case CommandKind::REPEAT:
+    spotify_send_async(
+        token, "PUT", spotify_api_url("/me/player/repeat?state=") + args[0],
+        done);
+    break;
+  case CommandKind::QUEUE:
+    spotify_send_async(token, "POST",
+                       UrlBuilder(spotify_api_url("/me/player/queue"))
+                           .param("uri", args[0])
+                           .str(),
+                       done);
+    break;
+  case CommandKind::SEARCH: {
+    SearchType type = args[0] == "artist"     ? SearchType::ARTIST
+                      : args[0] == "album"    ? SearchType::ALBUM
+                      : args[0] == "playlist" ? SearchType::PLAYLIST
+                                              : SearchType::TRACK;
+    size_t index = batch[0];
+    search_spotify_items_async(
+        token, args[1], type,
+        [shared, lane_ptr, index](bool ok, ItemPage &page) {
+          std::lock_guard<std::mutex> lock(shared->mutex);
+          Command &command = shared->commands[index];
+          command.results.items.swap(page.items);
+          finish(*shared, command, ok, 0, ok ? "" : "search failed");
+          --shared->in_flight;
+          --lane_ptr->in_flight;
+          shared->changed.notify_all();
+        },
+        kSearchLimit);
+    break;
+  }
+  case CommandKind::SAVE:
+  case CommandKind::REMOVE: {
+    std::vector<std::string> ids;
+    for (size_t index : batch) {
+      for (const std::string &uri : run->commands[index].args)
+        ids.push_back(spotify_id_from_uri(uri));
+    }
+    spotify_send_json_async(token,
+                            head.kind == CommandKind::SAVE ? "PUT" : "DELETE",
+                            spotify_api_url("/me/tracks"),
+                            json_string_array_body("ids", ids), done);
+    break;
+  }
+  case CommandKind::PLAYLIST_ADD: {
+    std::vector<std::string> uris;
+    for (size_t index : batch) {
+      const std::vector<std::string> &added = run->commands[index].args;
+      uris.insert(uris.end(), added.begin() + 1, added.end());
+    }
+    spotify_send_json_async(
+        token, "POST",
+        spotify_api_url("/playlists/") + args[0] + "/tracks",
+        json_string_array_body("uris", uris), done);
+    break;
+  }
+  case CommandKind::WAIT:
+    break;
+  }
+}
+
+// Called with the mutex held. Starts requests for the segment's commands
+// until concurrency are in flight or every lane is waiting on one.
+void dispatch(const std::shared_ptr<BatchRun> &run,
+              const BatchOptions &options, size_t segment) {
+  bool progress = true;
+  while (progress && run->in_flight < options.concurrency) {
+    progress = false;
+    for (auto &entry : run->lanes) {
+      if (run->in_flight >= options.concurrency)
+        break;
+      Lane &lane = entry.second;
+      if (lane.queued.empty())
+        continue;
+      const Command &head = run->commands[lane.queued.front()];
+      if (head.segment != segment)
+        continue;
+      // Saves may overlap other saves and removes other removes, since
+      // neither depends on the order they are applied in
+      bool overlaps = entry.first.empty() ||
+                      ((head.kind == CommandKind::SAVE ||
+                        head.kind == CommandKind::REMOVE) &&
+                       lane.kind == head.kind);
+      if (lane.in_flight > 0 && !overlaps)
+        continue;
+      start_request(run, entry.first, take_batch(*run, lane, options.coalesce));
+      progress = true;
+    }
+  }
+}
+
+// Reads commands from in until end of input, queueing each one on its lane
+// as soon as its line is complete
+void read_commands(const std::shared_ptr<BatchRun> &run, std::istream &in) {
+  std::string line;
+  size_t line_number = 0;
+  size_t segment = 0;
+  while (std::getline(in, line)) {
+    ++line_number;
+    std::string text = trim(line);
+    if (text.empty() || text[0] == '#')
+      continue;
+    Command command;
+    command.line = line_number;
+    parse_command(text, command);
+    command.segment = segment;
+
+    std::lock_guard<std::mutex> lock(run->mutex);
+    if (!command.error.empty()) {
+      command.finished = true;
+    } else if (command.kind == CommandKind::WAIT) {
+      command.finished = true;
+      command.ok = true;
+      run->remaining.push_back(0);
+      ++segment;
+    } else {
+      ++run->remaining[command.segment];
+      run->lanes[command.lane].queued.push_back(run->commands.size());
+    }
+    run->commands.push_back(command);
+    run->changed.notify_all();
+  }
+  std::lock_guard<std::mutex> lock(run->mutex);
+  run->input_done = true;
+  run->changed.notify_all();
+}
+
+} // namespace
+
+BatchStats run_batch(const std::string &access_token, std::istream &in,
+                     std::ostream &out, const BatchOptions &options) {
+  std::shared_ptr<BatchRun> run = std::make_shared<BatchRun>();
+  run->access_token = access_token;
+  run->remaining.push_back(0);
+  BatchStats stats;
+
+  auto start = std::chrono::steady_clock::now();
+  std::thread reader(read_commands, run, std::ref(in));
+  size_t written = 0;
+  size_t current = 0;
+  std::unique_lock<std::mutex> lock(run->mutex);
+  while (true) {
+    // A long script may outlast the access token. Only this thread starts
+    // requests, so the token cannot change under one being built.
+    std::string token = run->access_token;
+    lock.unlock();
+    refresh_if_expiring(token);
+    lock.lock();
+    run->access_token = token;
+
+    dispatch(run, options, current);
+    // Results go out in input order as soon as everything before them is
+    // done
+    while (written < run->commands.size() &&
+           run->commands[written].finished) {
+      const Command &command = run->commands[written++];
+      write_result(out, command);
+      if (!command.ok)
+        ++stats.failed;
+    }
+    out.flush();
+    // Once a wait has been read, nothing more joins the current segment
+    if (run->remaining[current] == 0 && current + 1 < run->remaining.size()) {
+      ++current;
+      continue;
+    }
+    if (run->input_done && written == run->commands.size())
+      break;
+    run->changed.wait(lock);
+  }
+  stats.commands = run->commands.size();
+  lock.unlock();
+  reader.join();
+
+  stats.requests = run->requests;
+  stats.elapsed_ms = std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+  return stats;
+}
+
+void print_batch_usage(std::ostream &out) {
+  out << "Commands, one per line:\n";
+  for (const CommandSpec &spec : kCommands)
+    out << "  " << spec.usage << "\n";
+}
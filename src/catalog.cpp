@@ -0,0 +1,452 @@
+// src/catalog.cpp
+#include "catalog.h"
+#include "search_index.h"
+#include "utils.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace {
+
+// FNV-1a
+uint32_t hash_bytes(const char *data, size_t length) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < length; ++i) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+// Spreads small consecutive integers across a power-of-two table
+uint32_t mix(uint32_t value) {
+  value *= 2654435761u;
+  return value ^ (value >> 16);
+}
+
+const char *kind_name(CatalogKind kind) {
+  switch (kind) {
+  case CatalogKind::ARTIST:
+    return "artist";
+  case CatalogKind::ALBUM:
+    return "album";
+  case CatalogKind::PLAYLIST:
+    return "playlist";
+  default:
+    return "track";
+  }
+}
+
+uint32_t hash_name(const std::string &name) {
+  std::string folded = fold_for_search(name);
+  return hash_bytes(folded.data(), folded.size());
+}
+
+template <typename T> size_t vector_bytes(const std::vector<T> &v) {
+  return v.capacity() * sizeof(T);
+}
+
+} // namespace
+
+StringPool::StringPool() : offsets_(1, 0), interned_(0) {}
+
+size_t StringPool::slot_of(const char *data, size_t length,
+                           uint32_t hash) const {
+  size_t mask = slots_.size() - 1;
+  size_t slot = hash & mask;
+  while (slots_[slot] != 0) {
+    Ref ref = slots_[slot] - 1;
+    if (this->length(ref) == length &&
+        std::memcmp(c_str(ref), data, length) == 0)
+      return slot;
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+void StringPool::grow() {
+  std::vector<uint32_t> old;
+  old.swap(slots_);
+  slots_.assign(std::max<size_t>(16, old.size() * 2), 0);
+  size_t mask = slots_.size() - 1;
+  for (uint32_t entry : old) {
+    if (entry == 0)
+      continue;
+    Ref ref = entry - 1;
+    size_t slot = hash_bytes(c_str(ref), length(ref)) & mask;
+    while (slots_[slot] != 0)
+      slot = (slot + 1) & mask;
+    slots_[slot] = entry;
+  }
+}
+
+StringPool::Ref StringPool::intern(const std::string &text) {
+  if ((interned_ + 1) * 2 > slots_.size())
+    grow();
+  size_t slot =
+      slot_of(text.data(), text.size(), hash_bytes(text.data(), text.size()));
+  if (slots_[slot] != 0)
+    return slots_[slot] - 1;
+  Ref ref = add(text);
+  slots_[slot] = ref + 1;
+  ++interned_;
+  return ref;
+}
+
+StringPool::Ref StringPool::add(const std::string &text) {
+  Ref ref = static_cast<Ref>(size());
+  bytes_.insert(bytes_.end(), text.begin(), text.end());
+  bytes_.push_back('\0');
+  offsets_.push_back(static_cast<uint32_t>(bytes_.size()));
+  return ref;
+}
+
+StringPool::Ref StringPool::find(const std::string &text) const {
+  if (slots_.empty())
+    return kNone;
+  size_t slot =
+      slot_of(text.data(), text.size(), hash_bytes(text.data(), text.size()));
+  return slots_[slot] != 0 ? slots_[slot] - 1 : kNone;
+}
+
+std::string StringPool::str(Ref ref) const {
+  return std::string(c_str(ref), length(ref));
+}
+
+size_t StringPool::memory_bytes() const {
+  return vector_bytes(bytes_) + vector_bytes(offsets_) + vector_bytes(slots_);
+}
+
+void StringPool::clear() {
+  bytes_.clear();
+  offsets_.assign(1, 0);
+  slots_.clear();
+  interned_ = 0;
+}
+
+// The empty string is always interned first, as ref 0, to stand for
+// missing artists and albums
+Catalog::Catalog() { strings_.intern(""); }
+
+size_t Catalog::id_slot(const std::string &id, uint8_t tag) const {
+  size_t mask = by_id_.size() - 1;
+  size_t slot = mix(hash_bytes(id.data(), id.size()) + tag) & mask;
+  while (by_id_[slot] != 0) {
+    CatalogRef ref = by_id_[slot] - 1;
+    if (tag_[ref] == tag && strings_.length(id_[ref]) == id.size() &&
+        std::memcmp(strings_.c_str(id_[ref]), id.data(), id.size()) == 0)
+      return slot;
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+size_t Catalog::name_slot(uint32_t name_hash) const {
+  size_t mask = by_name_.size() - 1;
+  size_t slot = mix(name_hash) & mask;
+  while (by_name_[slot] != 0 && name_hash_[by_name_[slot] - 1] != name_hash)
+    slot = (slot + 1) & mask;
+  return slot;
+}
+
+// Empties a slot of the name table and shifts later entries of the same
+// probe run back, so that lookups need no tombstones
+void Catalog::erase_name_slot(size_t slot) {
+  size_t mask = by_name_.size() - 1;
+  size_t next = (slot + 1) & mask;
+  while (by_name_[next] != 0) {
+    size_t home = mix(name_hash_[by_name_[next] - 1]) & mask;
+    // Move the entry back unless its home lies cyclically in (slot, next]
+    bool stays = slot <= next ? (slot < home && home <= next)
+                              : (slot < home || home <= next);
+    if (!stays) {
+      by_name_[slot] = by_name_[next];
+      slot = next;
+    }
+    next = (next + 1) & mask;
+  }
+  by_name_[slot] = 0;
+}
+
+void Catalog::link_name(CatalogRef ref) {
+  size_t slot = name_slot(name_hash_[ref]);
+  next_same_name_[ref] =
+      by_name_[slot] != 0 ? by_name_[slot] - 1 : kNoCatalogEntry;
+  by_name_[slot] = ref + 1;
+}
+
+void Catalog::unlink_name(CatalogRef ref) {
+  size_t slot = name_slot(name_hash_[ref]);
+  CatalogRef head = by_name_[slot] - 1;
+  if (head == ref) {
+    if (next_same_name_[ref] == kNoCatalogEntry)
+      erase_name_slot(slot);
+    else
+      by_name_[slot] = next_same_name_[ref] + 1;
+    return;
+  }
+  for (CatalogRef at = head; next_same_name_[at] != kNoCatalogEntry;
+       at = next_same_name_[at]) {
+    if (next_same_name_[at] == ref) {
+      next_same_name_[at] = next_same_name_[ref];
+      return;
+    }
+  }
+}
+
+// Keeps both tables at most half full
+void Catalog::grow_indexes() {
+  size_t entries = id_.size() + 1;
+  if (entries * 2 <= by_id_.size())
+    return;
+  size_t capacity = std::max<size_t>(16, by_id_.size() * 2);
+  by_id_.assign(capacity, 0);
+  by_name_.assign(capacity, 0);
+  // Chain heads are the entries no other entry points to
+  std::vector<bool> has_newer(id_.size(), false);
+  for (CatalogRef ref = 0; ref < id_.size(); ++ref) {
+    if (next_same_name_[ref] != kNoCatalogEntry)
+      has_newer[next_same_name_[ref]] = true;
+  }
+  for (CatalogRef ref = 0; ref < id_.size(); ++ref) {
+    if (id_[ref] != 0)
+      by_id_[id_slot(strings_.str(id_[ref]), tag_[ref])] = ref + 1;
+    if (!has_newer[ref])
+      by_name_[name_slot(name_hash_[ref])] = ref + 1;
+  }
+}
+
+uint8_t Catalog::tag_of(CatalogKind kind, const std::string &key,
+                        std::string &id) const {
+  bool whole_uri = false;
+  id = key;
+  if (key.compare(0, 8, "spotify:") == 0) {
+    std::string prefix = std::string("spotify:") + kind_name(kind) + ":";
+    if (key.compare(0, prefix.size(), prefix) == 0 &&
+        key.find(':', prefix.size()) == std::string::npos)
+      id = key.substr(prefix.size());
+    else
+      whole_uri = true;
+  }
+  return static_cast<uint8_t>(static_cast<uint8_t>(kind) |
+                              (whole_uri ? kWholeUri : 0));
+}
+
+CatalogRef Catalog::find_id(const std::string &id, uint8_t tag) const {
+  if (id.empty() || by_id_.empty())
+    return kNoCatalogEntry;
+  uint32_t entry = by_id_[id_slot(id, tag)];
+  return entry != 0 ? entry - 1 : kNoCatalogEntry;
+}
+
+CatalogRef Catalog::add_locked(CatalogKind kind, const std::string &name,
+                               const std::string &key) {
+  std::string id;
+  uint8_t tag = tag_of(kind, key, id);
+  uint32_t name_hash = hash_name(name);
+
+  CatalogRef existing = kNoCatalogEntry;
+  if (!id.empty()) {
+    existing = find_id(id, tag);
+  } else if (!by_name_.empty()) {
+    // Keyless entries are the same when kind and name match exactly
+    uint32_t head = by_name_[name_slot(name_hash)];
+    for (CatalogRef at = head - 1; head != 0 && at != kNoCatalogEntry;
+         at = next_same_name_[at]) {
+      if (id_[at] == 0 && tag_[at] == tag && strings_.str(name_[at]) == name)
+        return at;
+    }
+  }
+
+  if (existing != kNoCatalogEntry) {
+    if (!name.empty() && strings_.str(name_[existing]) != name) {
+      if (name_hash != name_hash_[existing]) {
+        unlink_name(existing);
+        name_hash_[existing] = name_hash;
+        link_name(existing);
+      }
+      name_[existing] = strings_.intern(name);
+    }
+    return existing;
+  }
+
+  grow_indexes();
+  CatalogRef ref = static_cast<CatalogRef>(id_.size());
+  // IDs are unique, so they skip the pool's table; ref 0 is ""
+  id_.push_back(id.empty() ? 0 : strings_.add(id));
+  name_.push_back(strings_.intern(name));
+  name_hash_.push_back(name_hash);
+  artist_.push_back(0);
+  album_.push_back(0);
+  duration_ms_.push_back(0);
+  tag_.push_back(tag);
+  next_same_name_.push_back(kNoCatalogEntry);
+  if (!id.empty())
+    by_id_[id_slot(id, tag)] = ref + 1;
+  link_name(ref);
+  return ref;
+}
+
+CatalogRef Catalog::add(CatalogKind kind, const std::string &name,
+                        const std::string &key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return add_locked(kind, name, key);
+}
+
+CatalogRef Catalog::add_track(const std::string &name, const std::string &key,
+                              const std::string &artist,
+                              const std::string &album, int duration_ms) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  CatalogRef ref = add_locked(CatalogKind::TRACK, name, key);
+  if (!artist.empty())
+    artist_[ref] = strings_.intern(artist);
+  if (!album.empty())
+    album_[ref] = strings_.intern(album);
+  if (duration_ms > 0)
+    duration_ms_[ref] = static_cast<uint32_t>(duration_ms);
+  return ref;
+}
+
+void Catalog::add_page(CatalogKind kind, const ItemPage &page,
+                       CatalogView &view) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto &item : page.items)
+    view.push_back(add_locked(kind, item.name, item.key));
+}
+
+CatalogRef Catalog::find(CatalogKind kind, const std::string &key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::string id;
+  uint8_t tag = tag_of(kind, key, id);
+  return find_id(id, tag);
+}
+
+CatalogView Catalog::find_name(const std::string &name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  CatalogView found;
+  if (by_name_.empty())
+    return found;
+  std::string folded = fold_for_search(name);
+  uint32_t head = by_name_[name_slot(hash_bytes(folded.data(), folded.size()))];
+  // Names share a chain by hash, so confirm that they really match
+  for (CatalogRef at = head - 1; head != 0 && at != kNoCatalogEntry;
+       at = next_same_name_[at]) {
+    if (fold_for_search(strings_.str(name_[at])) == folded)
+      found.push_back(at);
+  }
+  return found;
+}
+
+CatalogKind Catalog::kind(CatalogRef ref) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return static_cast<CatalogKind>(tag_[ref] & ~kWholeUri);
+}
+
+std::string Catalog::name(CatalogRef ref) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return strings_.str(name_[ref]);
+}
+
+std::string Catalog::id(CatalogRef ref) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return strings_.str(id_[ref]);
+}
+
+std::string Catalog::uri_locked(CatalogRef ref) const {
+  std::string id = strings_.str(id_[ref]);
+  if (id.empty() || (tag_[ref] & kWholeUri))
+    return id;
+  CatalogKind kind = static_cast<CatalogKind>(tag_[ref]);
+  return std::string("spotify:") + kind_name(kind) + ":" + id;
+}
+
+std::string Catalog::uri(CatalogRef ref) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return uri_locked(ref);
+}
+
+std::string Catalog::key(CatalogRef ref) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (tag_[ref] == static_cast<uint8_t>(CatalogKind::PLAYLIST))
+    return strings_.str(id_[ref]);
+  return uri_locked(ref);
+}
+
+std::string Catalog::artist(CatalogRef ref) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return strings_.str(artist_[ref]);
+}
+
+std::string Catalog::album(CatalogRef ref) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return strings_.str(album_[ref]);
+}
+
+int Catalog::duration_ms(CatalogRef ref) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return static_cast<int>(duration_ms_[ref]);
+}
+
+size_t Catalog::size() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return id_.size();
+}
+
+size_t Catalog::memory_bytes() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return strings_.memory_bytes() + vector_bytes(id_) + vector_bytes(name_) +
+         vector_bytes(name_hash_) + vector_bytes(artist_) +
+         vector_bytes(album_) + vector_bytes(duration_ms_) +
+         vector_bytes(tag_) + vector_bytes(next_same_name_) +
+         vector_bytes(by_id_) + vector_bytes(by_name_);
+}
+
+void Catalog::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  strings_.clear();
+  strings_.intern("");
+  id_.clear();
+  name_.clear();
+  name_hash_.clear();
+  artist_.clear();
+  album_.clear();
+  duration_ms_.clear();
+  tag_.clear();
+  next_same_name_.clear();
+  by_id_.clear();
+  by_name_.clear();
+}
+
+Catalog &catalog() {
+  static Catalog instance;
+  return instance;
+}
+
+CatalogRef select_from_view(const CatalogView &view,
+                            const std::string &input) {
+  std::string choice = trim(input);
+  if (choice.empty() || view.empty())
+    return kNoCatalogEntry;
+
+  bool number = choice.size() < 10 &&
+                std::all_of(choice.begin(), choice.end(), [](char c) {
+                  return std::isdigit(static_cast<unsigned char>(c)) != 0;
+                });
+  if (number) {
+    size_t position = std::stoul(choice);
+    if (position >= 1 && position <= view.size())
+      return view[position - 1];
+  }
+
+  Catalog &c = catalog();
+  CatalogRef by_key = c.find(c.kind(view.front()), choice);
+  if (by_key != kNoCatalogEntry &&
+      std::find(view.begin(), view.end(), by_key) != view.end())
+    return by_key;
+
+  // Of the entries with that name, the one shown first
+  auto first = view.end();
+  for (CatalogRef candidate : c.find_name(choice))
+    first = std::min(first, std::find(view.begin(), first, candidate));
+  return first == view.end() ? kNoCatalogEntry : *first;
+}
@@ -0,0 +1,171 @@
+// src/document_pool.cpp
+#include "document_pool.h"
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// Arena sizes of a new document: enough for a 50-item list page
+const size_t kInitialValueBytes = 256 * 1024;
+const size_t kInitialStackBytes = 32 * 1024;
+// Arenas are not grown past this; larger documents spill into heap chunks
+const size_t kMaxArenaBytes = 8 * 1024 * 1024;
+// rapidjson's default initial parse stack
+const size_t kParseStackCapacity = 1024;
+
+// Buffer size for an arena that had to spill into heap chunks: room for all
+// it held plus a quarter, rounded up to a power of two times the old size
+size_t arena_bytes(const rapidjson::MemoryPoolAllocator<> &arena,
+                   size_t bytes) {
+  if (arena.Capacity() <= bytes || bytes >= kMaxArenaBytes)
+    return bytes;
+  size_t wanted = arena.Size() + arena.Size() / 4;
+  do {
+    bytes *= 2;
+  } while (bytes < wanted && bytes < kMaxArenaBytes);
+  return bytes < kMaxArenaBytes ? bytes : kMaxArenaBytes;
+}
+
+} // namespace
+
+struct DocumentPool::Slot {
+  Slot(size_t value_bytes, size_t stack_bytes)
+      : value_bytes(value_bytes), stack_bytes(stack_bytes),
+        value_buffer(new char[value_bytes]),
+        stack_buffer(new char[stack_bytes]),
+        values(value_buffer.get(), value_bytes),
+        stack(stack_buffer.get(), stack_bytes),
+        doc(&values, kParseStackCapacity, &stack) {}
+
+  size_t value_bytes;
+  size_t stack_bytes;
+  std::unique_ptr<char[]> value_buffer;
+  std::unique_ptr<char[]> stack_buffer;
+  rapidjson::MemoryPoolAllocator<> values;
+  rapidjson::MemoryPoolAllocator<> stack;
+  PooledDocument doc;
+};
+
+// Outlives the pool while leases are out, so a lease returned during
+// shutdown still has somewhere to go
+struct DocumentPool::Shared {
+  explicit Shared(size_t max_idle) : max_idle(max_idle) {
+    idle.reserve(max_idle);
+  }
+
+  ~Shared() {
+    for (Slot *slot : idle)
+      delete slot;
+  }
+
+  // Resets the document's arenas, enlarging them first if it spilled, and
+  // keeps it for the next acquire
+  void release(Slot *slot) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (idle.size() >= max_idle) {
+        delete slot;
+        return;
+      }
+    }
+
+    // Nothing may point into the arenas once they are reset
+    slot->doc.SetNull();
+    size_t value_bytes = arena_bytes(slot->values, slot->value_bytes);
+    size_t stack_bytes = arena_bytes(slot->stack, slot->stack_bytes);
+    bool grown =
+        value_bytes != slot->value_bytes || stack_bytes != slot->stack_bytes;
+    if (grown) {
+      delete slot;
+      slot = new Slot(value_bytes, stack_bytes);
+    } else {
+      slot->values.Clear();
+      slot->stack.Clear();
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (grown)
+      ++stats.arenas_grown;
+    if (idle.size() < max_idle) {
+      idle.push_back(slot);
+      return;
+    }
+    lock.unlock();
+    delete slot;
+  }
+
+  std::mutex mutex;
+  size_t max_idle;
+  std::vector<Slot *> idle;
+  DocumentPoolStats stats;
+};
+
+DocumentPool::Lease::Lease(Lease &&other)
+    : shared_(std::move(other.shared_)), slot_(other.slot_) {
+  other.slot_ = NULL;
+}
+
+DocumentPool::Lease &DocumentPool::Lease::operator=(Lease &&other) {
+  if (this != &other) {
+    reset();
+    shared_ = std::move(other.shared_);
+    slot_ = other.slot_;
+    other.slot_ = NULL;
+  }
+  return *this;
+}
+
+PooledDocument &DocumentPool::Lease::operator*() const { return slot_->doc; }
+
+void DocumentPool::Lease::reset() {
+  if (!slot_)
+    return;
+  shared_->release(slot_);
+  slot_ = NULL;
+  shared_.reset();
+}
+
+DocumentPool::DocumentPool(size_t max_idle)
+    : shared_(std::make_shared<Shared>(max_idle)) {}
+
+DocumentLease DocumentPool::acquire() {
+  Slot *slot = NULL;
+  {
+    std::lock_guard<std::mutex> lock(shared_->mutex);
+    ++shared_->stats.leases;
+    if (!shared_->idle.empty()) {
+      slot = shared_->idle.back();
+      shared_->idle.pop_back();
+    } else {
+      ++shared_->stats.arenas_created;
+    }
+  }
+  if (!slot)
+    slot = new Slot(kInitialValueBytes, kInitialStackBytes);
+  return Lease(shared_, slot);
+}
+
+DocumentPoolStats DocumentPool::stats() {
+  std::lock_guard<std::mutex> lock(shared_->mutex);
+  DocumentPoolStats stats = shared_->stats;
+  stats.idle = shared_->idle.size();
+  for (Slot *slot : shared_->idle)
+    stats.idle_bytes += slot->value_bytes + slot->stack_bytes;
+  return stats;
+}
+
+void DocumentPool::trim() {
+  std::vector<Slot *> freed;
+  {
+    std::lock_guard<std::mutex> lock(shared_->mutex);
+    freed.swap(shared_->idle);
+    shared_->idle.reserve(shared_->max_idle);
+  }
+  for (Slot *slot : freed)
+    delete slot;
+}
+
+DocumentPool &document_pool() {
+  static DocumentPool pool;
+  return pool;
+}
@@ -0,0 +1,689 @@
+// src/http_client.cpp
+#include "http_client.h"
+#include "request_stats.h"
+#include "utils.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <curl/curl.h>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+// Upper bound on parallel connections per host for asynchronous transfers
+const long kMaxHostConnections = 8;
+// Times a request is queued again after a 429 before the 429 is returned
+const int kMaxRetries = 3;
+// Pause after a 429 without a usable Retry-After header
+const long kDefaultRetryAfterSeconds = 1;
+// Longer pauses are not waited out; the 429 goes back to the caller instead
+const long kMaxRetryAfterSeconds = 60;
+// Share of the burst that background requests leave to the other priorities
+const double kBackgroundReserve = 0.2;
+// Poll timeout of the event loop when nothing is waiting for the budget
+const long kIdlePollMs = 1000;
+
+typedef std::chrono::steady_clock Clock;
+
+thread_local RequestPriority thread_priority = RequestPriority::NORMAL;
+
+// Allows rate() starts per second on average and up to burst() at once
+class TokenBucket {
+public:
+  TokenBucket() : rate_(0), burst_(0), tokens_(0) {}
+
+  void configure(double rate, double burst, Clock::time_point now) {
+    rate_ = rate;
+    burst_ = std::max(burst, 1.0);
+    tokens_ = burst_;
+    refilled_ = now;
+  }
+
+  // Takes a token if at least reserve tokens are left afterwards
+  bool take(double reserve, Clock::time_point now) {
+    if (rate_ <= 0)
+      return true;
+    refill(now);
+    if (tokens_ < 1 + reserve)
+      return false;
+    tokens_ -= 1;
+    return true;
+  }
+
+  // Time until take(reserve) succeeds
+  Clock::duration wait(double reserve, Clock::time_point now) {
+    if (rate_ <= 0)
+      return Clock::duration::zero();
+    refill(now);
+    double missing = 1 + reserve - tokens_;
+    if (missing <= 0)
+      return Clock::duration::zero();
+    return std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(missing / rate_));
+  }
+
+  // Tokens to leave untouched for a share of the burst, never the whole of it
+  double reserve(double share) const {
+    return rate_ <= 0 ? 0 : std::min(burst_ * share, burst_ - 1);
+  }
+
+private:
+  void refill(Clock::time_point now) {
+    double elapsed = std::chrono::duration<double>(now - refilled_).count();
+    tokens_ = std::min(burst_, tokens_ + elapsed * rate_);
+    refilled_ = now;
+  }
+
+  double rate_;
+  double burst_;
+  double tokens_;
+  Clock::time_point refilled_;
+};
+
+// Owns the curl share object and the pool of idle easy handles. Constructed
+// on first use and torn down at exit.
+class HttpClientState {
+public:
+  HttpClientState() : handles_created_(0) {
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    share_ = curl_share_init();
+    curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, lock_share);
+    curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, unlock_share);
+    curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+  }
+
+  ~HttpClientState() {
+    for (CURL *curl : idle_)
+      curl_easy_cleanup(curl);
+    curl_share_cleanup(share_);
+    curl_global_cleanup();
+  }
+
+  CURL *acquire() {
+    CURL *curl = NULL;
+    {
+      std::lock_guard<std::mutex> lock(pool_mutex_);
+      if (!idle_.empty()) {
+        curl = idle_.back();
+        idle_.pop_back();
+      } else {
+        ++handles_created_;
+      }
+    }
+    if (!curl)
+      curl = curl_easy_init();
+    if (curl)
+      apply_defaults(curl);
+    return curl;
+  }
+
+  // Resetting clears per-request options but keeps the handle's live
+  // connections and caches, which is the point of pooling it.
+  void release(CURL *curl) {
+    curl_easy_reset(curl);
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    idle_.push_back(curl);
+  }
+
+  size_t handles_created() {
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    return handles_created_;
+  }
+
+private:
+  void apply_defaults(CURL *curl) {
+    curl_easy_setopt(curl, CURLOPT_SHARE, share_);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
+  }
+
+  static void lock_share(CURL *, curl_lock_data data, curl_lock_access,
+                         void *userp) {
+    static_cast<HttpClientState *>(userp)->share_mutexes_[data].lock();
+  }
+
+  static void unlock_share(CURL *, curl_lock_data data, void *userp) {
+    static_cast<HttpClientState *>(userp)->share_mutexes_[data].unlock();
+  }
+
+  CURLSH *share_;
+  std::mutex share_mutexes_[CURL_LOCK_DATA_LAST];
+  std::mutex pool_mutex_;
+  std::vector<CURL *> idle_;
+  size_t handles_created_;
+};
+
+HttpClientState &client_state() {
+  static HttpClientState state;
+  return state;
+}
+
+// Collects response headers; a new status line (after a redirect or an
+// interim 100 response) starts a fresh set
+size_t header_callback(char *buffer, size_t size, size_t nitems, void *userp) {
+  size_t total = size * nitems;
+  HttpResponse *response = static_cast<HttpResponse *>(userp);
+  std::string line(buffer, total);
+  if (line.compare(0, 5, "HTTP/") == 0) {
+    response->headers.clear();
+    return total;
+  }
+  size_t colon = line.find(':');
+  if (colon != std::string::npos) {
+    std::string name = trim(line.substr(0, colon));
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    response->headers[name] = trim(line.substr(colon + 1));
+  }
+  return total;
+}
+
+// Applies the request to a pooled handle. Returns the header list built for
+// the transfer, to be freed after it, or NULL when the request's shared list
+// is used as it is
+struct curl_slist *prepare_handle(CURL *curl, const HttpRequest &request,
+                                  HttpResponse &response) {
+  struct curl_slist *headers = NULL;
+  if (!request.headers.empty()) {
+    if (request.shared_headers) {
+      for (auto &header : request.shared_headers->lines())
+        headers = curl_slist_append(headers, header.c_str());
+    }
+    for (auto &header : request.headers)
+      headers = curl_slist_append(headers, header.c_str());
+  }
+
+  curl_easy_setopt(curl, CURLOPT_URL, request.url.c_str());
+  curl_easy_setopt(curl, CURLOPT_HTTPHEADER,
+                   headers || !request.shared_headers
+                       ? headers
+                       : request.shared_headers->slist());
+  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
+  curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response.body);
+  curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, header_callback);
+  curl_easy_setopt(curl, CURLOPT_HEADERDATA, &response);
+  if (request.method != "GET") {
+    if (request.method != "POST")
+      curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, request.method.c_str());
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE,
+                     static_cast<long>(request.body.size()));
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request.body.c_str());
+  }
+  return headers;
+}
+
+// cURL's timers count from the start of the transfer; the phases are the
+// differences between consecutive ones
+void read_timings(CURL *curl, HttpTimings &timings) {
+  curl_off_t dns = 0, connect = 0, tls = 0, first_byte = 0, total = 0;
+  long connects = 0;
+  curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME_T, &dns);
+  curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connect);
+  curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &tls);
+  curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &first_byte);
+  curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &total);
+  curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+  timings.new_connection = connects > 0;
+  if (timings.new_connection) {
+    timings.dns_us = dns;
+    timings.connect_us = std::max<curl_off_t>(connect - dns, 0);
+    // Zero for plain HTTP
+    timings.tls_us = tls ? std::max<curl_off_t>(tls - connect, 0) : 0;
+  }
+  timings.first_byte_us = first_byte;
+  timings.total_us = total;
+}
+
+void finish_transfer(CURL *curl, CURLcode res, const HttpRequest &request,
+                     HttpResponse &response) {
+  curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response.status);
+  response.transport_ok = (res == CURLE_OK);
+  if (!response.transport_ok)
+    response.error = curl_easy_strerror(res);
+  read_timings(curl, response.timings);
+  request_stats().record_transfer(request, response);
+}
+
+// One in-flight asynchronous request
+struct Transfer {
+  HttpRequestId id;
+  HttpRequest request;
+  HttpResponse response;
+  HttpCallback callback;
+  CURL *curl;
+  struct curl_slist *headers;
+  Clock::time_point queued_at;
+  int attempts; // 429s answered so far
+};
+
+// Drives asynchronous transfers on a curl multi handle from a dedicated event
+// loop thread. Submissions are handed over under a mutex and the loop is woken
+// with curl_multi_wakeup; completion callbacks run on the loop thread. The
+// loop also schedules starts: transfers wait in one queue per priority until
+// the token bucket and any Retry-After pause allow them to go.
+class AsyncEngine {
+public:
+  AsyncEngine()
+      : next_id_(1), running_(true), rate_(0), burst_(0),
+        rate_changed_(false) {
+    // Make sure the shared client and the statistics the loop records into
+    // outlive the engine at exit
+    client_state();
+    request_stats();
+    multi_ = curl_multi_init();
+    curl_multi_setopt(multi_, CURLMOPT_MAX_HOST_CONNECTIONS,
+                      kMaxHostConnections);
+    loop_ = std::thread(&AsyncEngine::run, this);
+  }
+
+  ~AsyncEngine() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      running_ = false;
+    }
+    curl_multi_wakeup(multi_);
+    loop_.join();
+    curl_multi_cleanup(multi_);
+  }
+
+  HttpRequestId submit(const HttpRequest &request, HttpCallback callback) {
+    std::unique_ptr<Transfer> transfer(new Transfer());
+    transfer->request = request;
+    transfer->callback = callback;
+    transfer->curl = NULL;
+    transfer->headers = NULL;
+    transfer->queued_at = Clock::now();
+    transfer->attempts = 0;
+    HttpRequestId id;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      id = transfer->id = next_id_++;
+      pending_.push_back(std::move(transfer));
+    }
+    curl_multi_wakeup(multi_);
+    return id;
+  }
+
+  void cancel(HttpRequestId id) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      cancelled_.push_back(id);
+    }
+    curl_multi_wakeup(multi_);
+  }
+
+  void promote(HttpRequestId id, RequestPriority priority) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      promoted_.emplace_back(id, priority);
+    }
+    curl_multi_wakeup(multi_);
+  }
+
+  void set_rate_limit(double requests_per_second, double burst) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      rate_ = requests_per_second;
+      burst_ = burst;
+      rate_changed_ = true;
+    }
+    curl_multi_wakeup(multi_);
+  }
+
+  HttpSchedulerStats stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    HttpSchedulerStats stats = stats_;
+    Clock::duration left = published_pause_ - Clock::now();
+    if (left > Clock::duration::zero())
+      stats.backoff_left_ms =
+          std::chrono::duration<double, std::milli>(left).count();
+    return stats;
+  }
+
+  bool on_loop_thread() const {
+    return std::this_thread::get_id() == loop_.get_id();
+  }
+
+private:
+  void run() {
+    while (true) {
+      std::vector<std::unique_ptr<Transfer>> submitted;
+      std::vector<HttpRequestId> cancelled;
+      std::vector<std::pair<HttpRequestId, RequestPriority>> promoted;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_)
+          break;
+        submitted.swap(pending_);
+        cancelled.swap(cancelled_);
+        promoted.swap(promoted_);
+        if (rate_changed_) {
+          bucket_.configure(rate_, burst_, Clock::now());
+          rate_changed_ = false;
+        }
+      }
+      for (auto &transfer : submitted) {
+        if (std::find(cancelled.begin(), cancelled.end(), transfer->id) !=
+            cancelled.end()) {
+          fail(std::move(transfer), "cancelled");
+        } else {
+          int priority = static_cast<int>(transfer->request.priority);
+          queued_[priority].push_back(std::move(transfer));
+        }
+      }
+      for (auto &entry : promoted)
+        requeue(entry.first, entry.second);
+      for (HttpRequestId id : cancelled)
+        abort(id);
+      dispatch();
+
+      int still_running = 0;
+      curl_multi_perform(multi_, &still_running);
+      int queued = 0;
+      while (CURLMsg *msg = curl_multi_info_read(multi_, &queued)) {
+        if (msg->msg == CURLMSG_DONE)
+          complete(msg->easy_handle, msg->data.result);
+      }
+      publish();
+      curl_multi_poll(multi_, NULL, 0, poll_timeout_ms(), NULL);
+    }
+
+    // Fail whatever is left so that no caller waits forever
+    std::vector<std::unique_ptr<Transfer>> leftovers;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      leftovers.swap(pending_);
+    }
+    for (auto &queue : queued_) {
+      for (auto &transfer : queue)
+        leftovers.push_back(std::move(transfer));
+      queue.clear();
+    }
+    for (auto &entry : active_) {
+      curl_multi_remove_handle(multi_, entry.first);
+      leftovers.push_back(std::unique_ptr<Transfer>(entry.second));
+    }
+    active_.clear();
+    for (auto &transfer : leftovers)
+      fail(std::move(transfer), "HTTP client shut down");
+  }
+
+  double reserve(int priority) const {
+    return priority == static_cast<int>(RequestPriority::BACKGROUND)
+               ? bucket_.reserve(kBackgroundReserve)
+               : 0;
+  }
+
+  // Starts queued transfers, highest priority first, while the budget lasts.
+  // A priority that cannot get a token blocks the ones below it, which need
+  // at least as many.
+  void dispatch() {
+    Clock::time_point now = Clock::now();
+    if (now < paused_until_)
+      return;
+    for (int p = 0; p < kRequestPriorities; ++p) {
+      while (!queued_[p].empty()) {
+        if (!bucket_.take(reserve(p), now))
+          return;
+        std::unique_ptr<Transfer> transfer = std::move(queued_[p].front());
+        queued_[p].pop_front();
+        if (transfer->attempts == 0)
+          record_wait(p, now - transfer->queued_at);
+        start(std::move(transfer));
+      }
+    }
+  }
+
+  // Time until the first queued transfer may start, or kIdlePollMs
+  long poll_timeout_ms() {
+    for (int p = 0; p < kRequestPriorities; ++p) {
+      if (queued_[p].empty())
+        continue;
+      Clock::time_point now = Clock::now();
+      Clock::duration wait =
+          std::max(paused_until_ - now, bucket_.wait(reserve(p), now));
+      long ms =
+          std::chrono::duration_cast<std::chrono::milliseconds>(wait).count() +
+          1;
+      return std::min(ms, kIdlePollMs);
+    }
+    return kIdlePollMs;
+  }
+
+  void record_wait(int priority, Clock::duration wait) {
+    double ms = std::chrono::duration<double, std::milli>(wait).count();
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.started[priority];
+    stats_.total_wait_ms[priority] += ms;
+    stats_.max_wait_ms[priority] = std::max(stats_.max_wait_ms[priority], ms);
+  }
+
+  // Makes the queue depths and pause visible to stats()
+  void publish() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int p = 0; p < kRequestPriorities; ++p) {
+      stats_.queued[p] = queued_[p].size();
+      stats_.max_queued[p] = std::max(stats_.max_queued[p], queued_[p].size());
+    }
+    published_pause_ = paused_until_;
+  }
+
+  // Pauses every start for the response's Retry-After and queues the
+  // transfer again at the head of its queue. Returns false when it has been
+  // retried enough or the pause is too long to wait out.
+  bool retry_later(std::unique_ptr<Transfer> &transfer) {
+    long seconds =
+        std::atol(transfer->response.header("retry-after").c_str());
+    if (seconds <= 0)
+      seconds = kDefaultRetryAfterSeconds;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++stats_.throttled;
+      if (transfer->attempts >= kMaxRetries ||
+          seconds > kMaxRetryAfterSeconds)
+        return false;
+      ++stats_.retried;
+    }
+    paused_until_ =
+        std::max(paused_until_, Clock::now() + std::chrono::seconds(seconds));
+    ++transfer->attempts;
+    transfer->curl = NULL;
+    transfer->headers = NULL;
+    transfer->response = HttpResponse();
+    int priority = static_cast<int>(transfer->request.priority);
+    queued_[priority].push_front(std::move(transfer));
+    return true;
+  }
+
+  void start(std::unique_ptr<Transfer> transfer) {
+    transfer->curl = client_state().acquire();
+    if (!transfer->curl) {
+      fail(std::move(transfer), "failed to create cURL handle");
+      return;
+    }
+    transfer->headers =
+        prepare_handle(transfer->curl, transfer->request, transfer->response);
+    curl_multi_add_handle(multi_, transfer->curl);
+    active_[transfer->curl] = transfer.release();
+  }
+
+  // Runs the callback of a transfer that never completed
+  void fail(std::unique_ptr<Transfer> transfer, const char *error) {
+    if (transfer->curl) {
+      curl_slist_free_all(transfer->headers);
+      client_state().release(transfer->curl);
+    }
+    transfer->response.error = error;
+    if (transfer->callback)
+      transfer->callback(transfer->response);
+  }
+
+  void abort(HttpRequestId id) {
+    for (auto it = active_.begin(); it != active_.end(); ++it) {
+      if (it->second->id != id)
+        continue;
+      std::unique_ptr<Transfer> transfer(it->second);
+      active_.erase(it);
+      curl_multi_remove_handle(multi_, transfer->curl);
+      fail(std::move(transfer), "cancelled");
+      return;
+    }
+    for (auto &queue : queued_) {
+      for (auto it = queue.begin(); it != queue.end(); ++it) {
+        if ((*it)->id != id)
+          continue;
+        std::unique_ptr<Transfer> transfer = std::move(*it);
+        queue.erase(it);
+        fail(std::move(transfer), "cancelled");
+        return;
+      }
+    }
+  }
+
+  // Moves a queued transfer to the back of a higher priority's queue
+  void requeue(HttpRequestId id, RequestPriority priority) {
+    int to = static_cast<int>(priority);
+    for (int p = to + 1; p < kRequestPriorities; ++p) {
+      for (auto it = queued_[p].begin(); it != queued_[p].end(); ++it) {
+        if ((*it)->id != id)
+          continue;
+        std::unique_ptr<Transfer> transfer = std::move(*it);
+        queued_[p].erase(it);
+        transfer->request.priority = priority;
+        queued_[to].push_back(std::move(transfer));
+        return;
+      }
+    }
+  }
+
+  void complete(CURL *curl, CURLcode res) {
+    auto it = active_.find(curl);
+    if (it == active_.end())
+      return;
+    std::unique_ptr<Transfer> transfer(it->second);
+    active_.erase(it);
+    curl_multi_remove_handle(multi_, curl);
+    finish_transfer(curl, res, transfer->request, transfer->response);
+    curl_slist_free_all(transfer->headers);
+    client_state().release(curl);
+    if (transfer->response.status == 429 && retry_later(transfer))
+      return;
+    if (transfer->callback)
+      transfer->callback(transfer->response);
+  }
+
+  CURLM *multi_;
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<Transfer>> pending_;
+  std::vector<HttpRequestId> cancelled_;
+  std::vector<std::pair<HttpRequestId, RequestPriority>> promoted_;
+  HttpRequestId next_id_;
+  bool running_;
+  double rate_;
+  double burst_;
+  bool rate_changed_;
+  HttpSchedulerStats stats_;
+  Clock::time_point published_pause_;
+  std::map<CURL *, Transfer *> active_;
+  // Owned by the loop thread
+  std::deque<std::unique_ptr<Transfer>> queued_[kRequestPriorities];
+  TokenBucket bucket_;
+  Clock::time_point paused_until_;
+  std::thread loop_;
+};
+
+AsyncEngine &async_engine() {
+  static AsyncEngine engine;
+  return engine;
+}
+
+// Performs a request on the calling thread, outside the scheduler
+bool perform_now(const HttpRequest &request, HttpResponse &response) {
+  response = HttpResponse();
+  HttpClientState &state = client_state();
+  CURL *curl = state.acquire();
+  if (!curl) {
+    response.error = "failed to create cURL handle";
+    return false;
+  }
+
+  struct curl_slist *headers = prepare_handle(curl, request, response);
+  CURLcode res = curl_easy_perform(curl);
+  finish_transfer(curl, res, request, response);
+  curl_slist_free_all(headers);
+  state.release(curl);
+  return response.transport_ok;
+}
+
+} // namespace
+
+RequestPriority current_request_priority() { return thread_priority; }
+
+RequestPriorityScope::RequestPriorityScope(RequestPriority priority)
+    : previous_(thread_priority) {
+  thread_priority = priority;
+}
+
+RequestPriorityScope::~RequestPriorityScope() { thread_priority = previous_; }
+
+HttpHeaderList::HttpHeaderList(const std::vector<std::string> &lines)
+    : lines_(lines), slist_(NULL) {
+  for (auto &line : lines_)
+    slist_ = curl_slist_append(slist_, line.c_str());
+}
+
+HttpHeaderList::~HttpHeaderList() { curl_slist_free_all(slist_); }
+
+HttpSchedulerStats::HttpSchedulerStats()
+    : throttled(0), retried(0), backoff_left_ms(0) {
+  for (int p = 0; p < kRequestPriorities; ++p) {
+    queued[p] = max_queued[p] = 0;
+    started[p] = 0;
+    total_wait_ms[p] = max_wait_ms[p] = 0;
+  }
+}
+
+bool http_perform(const HttpRequest &request, HttpResponse &response) {
+  AsyncEngine &engine = async_engine();
+  // A completion callback waiting on the loop thread would wait for itself
+  if (engine.on_loop_thread())
+    return perform_now(request, response);
+  response = http_perform_async(request).get();
+  return response.transport_ok;
+}
+
+HttpRequestId http_perform_async(const HttpRequest &request,
+                                 HttpCallback callback) {
+  return async_engine().submit(request, callback);
+}
+
+void http_cancel(HttpRequestId id) { async_engine().cancel(id); }
+
+void http_promote(HttpRequestId id, RequestPriority priority) {
+  async_engine().promote(id, priority);
+}
+
+std::future<HttpResponse> http_perform_async(const HttpRequest &request) {
+  std::shared_ptr<std::promise<HttpResponse>> promise =
+      std::make_shared<std::promise<HttpResponse>>();
+  async_engine().submit(request, [promise](HttpResponse &response) {
+    promise->set_value(std::move(response));
+  });
+  return promise->get_future();
+}
+
+size_t http_handles_created() { return client_state().handles_created(); }
+
+void http_set_rate_limit(double requests_per_second, double burst) {
+  async_engine().set_rate_limit(requests_per_second, burst);
+}
+
+HttpSchedulerStats http_scheduler_stats() { return async_engine().stats(); }
@@ -0,0 +1,150 @@
+// src/json_extract.cpp
+#include "json_extract.h"
+#include "rapidjson/reader.h"
+#include <cstring>
+
+namespace {
+
+// Key path from the document root to the array of items, and from an item to
+// its fields; the version is optional. "[]" stands for "any element of an
+// array".
+struct ViewSpec {
+  std::vector<std::string> items_path;
+  std::vector<std::string> name_path;
+  std::vector<std::string> key_path;
+  std::vector<std::string> version_path;
+};
+
+const ViewSpec &view_spec(ItemView view) {
+  static const ViewSpec playlists = {
+      {"items", "[]"}, {"name"}, {"id"}, {"snapshot_id"}};
+  static const ViewSpec track_items = {
+      {"items", "[]"}, {"track", "name"}, {"track", "uri"}, {}};
+  static const ViewSpec recommendations = {
+      {"tracks", "[]"}, {"name"}, {"uri"}, {}};
+  static const ViewSpec search_tracks = {
+      {"tracks", "items", "[]"}, {"name"}, {"uri"}, {}};
+  static const ViewSpec search_artists = {
+      {"artists", "items", "[]"}, {"name"}, {"uri"}, {}};
+  static const ViewSpec search_albums = {
+      {"albums", "items", "[]"}, {"name"}, {"uri"}, {}};
+  static const ViewSpec search_playlists = {
+      {"playlists", "items", "[]"}, {"name"}, {"uri"}, {}};
+  static const ViewSpec album_tracks = {
+      {"items", "[]"}, {"name"}, {"uri"}, {}};
+  switch (view) {
+  case ItemView::PLAYLISTS:
+    return playlists;
+  case ItemView::TRACK_ITEMS:
+    return track_items;
+  case ItemView::RECOMMENDATIONS:
+    return recommendations;
+  case ItemView::SEARCH_TRACKS:
+    return search_tracks;
+  case ItemView::SEARCH_ARTISTS:
+    return search_artists;
+  case ItemView::SEARCH_ALBUMS:
+    return search_albums;
+  case ItemView::ALBUM_TRACKS:
+    return album_tracks;
+  case ItemView::SEARCH_PLAYLISTS:
+  default:
+    return search_playlists;
+  }
+}
+
+// SAX handler that tracks the key path of the current value and copies the
+// name and key fields of every item. Items missing either field (such as a
+// playlist entry whose track is null) are skipped.
+class ItemHandler
+    : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, ItemHandler> {
+public:
+  ItemHandler(const ViewSpec &spec, ItemPage &page)
+      : spec_(spec), page_(page), item_depth_(0) {}
+
+  bool StartObject() {
+    if (item_depth_ == 0 && at(spec_.items_path, 0)) {
+      item_depth_ = path_.size();
+      item_ = NamedItem();
+    }
+    path_.push_back(std::string());
+    return true;
+  }
+
+  bool EndObject(rapidjson::SizeType) {
+    path_.pop_back();
+    if (item_depth_ != 0 && path_.size() == item_depth_) {
+      if (!item_.name.empty() && !item_.key.empty())
+        page_.items.push_back(std::move(item_));
+      item_depth_ = 0;
+    }
+    return true;
+  }
+
+  bool StartArray() {
+    path_.push_back("[]");
+    return true;
+  }
+
+  bool EndArray(rapidjson::SizeType) {
+    path_.pop_back();
+    return true;
+  }
+
+  bool Key(const char *str, rapidjson::SizeType length, bool) {
+    path_.back().assign(str, length);
+    return true;
+  }
+
+  bool String(const char *str, rapidjson::SizeType length, bool) {
+    if (item_depth_ != 0) {
+      if (at(spec_.name_path, item_depth_))
+        item_.name.assign(str, length);
+      else if (at(spec_.key_path, item_depth_))
+        item_.key.assign(str, length);
+      else if (!spec_.version_path.empty() &&
+               at(spec_.version_path, item_depth_))
+        item_.version.assign(str, length);
+    }
+    return true;
+  }
+
+  bool Int(int value) { return total(value); }
+  bool Uint(unsigned value) { return total(static_cast<int>(value)); }
+  bool Default() { return true; }
+
+private:
+  // True when the current path, starting at depth `from`, equals expected
+  bool at(const std::vector<std::string> &expected, size_t from) const {
+    if (path_.size() != from + expected.size())
+      return false;
+    for (size_t i = 0; i < expected.size(); ++i) {
+      if (path_[from + i] != expected[i])
+        return false;
+    }
+    return true;
+  }
+
+  bool total(int value) {
+    if (path_.size() == 1 && path_[0] == "total")
+      page_.total = value;
+    return true;
+  }
+
+  const ViewSpec &spec_;
+  ItemPage &page_;
+  std::vector<std::string> path_;
+  size_t item_depth_; // path index of the current item, 0 outside items
+  NamedItem item_;
+};
+
+} // namespace
+
+bool extract_items(const char *json, ItemView view, ItemPage &page) {
+  ItemHandler handler(view_spec(view), page);
+  // Parsing clears the reader's stack without freeing it, so one reader per
+  // thread stops allocating once its stack has grown to fit
+  thread_local rapidjson::Reader reader;
+  rapidjson::StringStream stream(json);
+  return !reader.Parse(stream, handler).IsError();
+}
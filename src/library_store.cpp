@@ -0,0 +1,319 @@
+// src/library_store.cpp
+#include "library_store.h"
+#include "http_client.h"
+#include "search_index.h"
+#include "spotify_operations/LibraryOperations.h"
+#include "utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <unordered_set>
+
+namespace {
+
+const char *const kHeader = "#spotify-tui saved-tracks 1";
+const int kSyncPageSize = 50;
+
+// Pause between pages of the background pass so that it never competes with
+// interactive requests for connections or rate limit budget
+const int kReconcilePagePauseMs = 250;
+
+std::string string_member(const rapidjson::Value &object, const char *name) {
+  if (object.IsObject() && object.HasMember(name) &&
+      object[name].IsString())
+    return object[name].GetString();
+  return "";
+}
+
+} // namespace
+
+bool saved_track_from_item(const rapidjson::Value &item, SavedTrack &track) {
+  if (!item.IsObject() || !item.HasMember("track") ||
+      !item["track"].IsObject())
+    return false;
+  const rapidjson::Value &t = item["track"];
+  track.added_at = string_member(item, "added_at");
+  track.id = string_member(t, "id");
+  track.uri = string_member(t, "uri");
+  track.name = string_member(t, "name");
+  track.artist.clear();
+  if (t.HasMember("artists") && t["artists"].IsArray() &&
+      t["artists"].Size() > 0)
+    track.artist = string_member(t["artists"][0u], "name");
+  track.album = t.HasMember("album") ? string_member(t["album"], "name") : "";
+  track.duration_ms = t.HasMember("duration_ms") && t["duration_ms"].IsInt()
+                          ? t["duration_ms"].GetInt()
+                          : 0;
+  return !track.uri.empty();
+}
+
+LibraryStore::LibraryStore(const std::string &path)
+    : path_(path), last_reconciled_(0), reconciling_(false),
+      stopping_(false) {}
+
+LibraryStore::~LibraryStore() { stop(); }
+
+void LibraryStore::stop() {
+  stopping_ = true;
+  if (reconcile_thread_.joinable())
+    reconcile_thread_.join();
+}
+
+bool LibraryStore::load() {
+  std::ifstream in(path_);
+  if (!in)
+    return false;
+  std::string line;
+  size_t header_length = std::strlen(kHeader);
+  if (!std::getline(in, line) || line.compare(0, header_length, kHeader) != 0)
+    return false;
+  std::time_t reconciled =
+      static_cast<std::time_t>(std::atoll(line.c_str() + header_length));
+
+  std::vector<SavedTrack> loaded;
+  while (std::getline(in, line)) {
+    std::vector<std::string> fields = split(line, '\t');
+    if (fields.size() != 7)
+      continue;
+    SavedTrack track;
+    track.added_at = fields[0];
+    track.id = fields[1];
+    track.uri = fields[2];
+    track.name = unescape_tsv_field(fields[3]);
+    track.artist = unescape_tsv_field(fields[4]);
+    track.album = unescape_tsv_field(fields[5]);
+    track.duration_ms = std::atoi(fields[6].c_str());
+    loaded.push_back(track);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  tracks_.swap(loaded);
+  last_reconciled_ = reconciled;
+  rebuild_index();
+  return true;
+}
+
+bool LibraryStore::save() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return save_locked();
+}
+
+// Writes to a temporary file and renames it so a crash never leaves a
+// truncated store behind
+bool LibraryStore::save_locked() {
+  std::string tmp_path = path_ + ".tmp";
+  {
+    std::ofstream out(tmp_path, std::ios::trunc);
+    if (!out)
+      return false;
+    out << kHeader << " " << static_cast<long long>(last_reconciled_) << "\n";
+    for (auto &track : tracks_) {
+      out << track.added_at << '\t' << track.id << '\t' << track.uri << '\t'
+          << escape_tsv_field(track.name) << '\t'
+          << escape_tsv_field(track.artist) << '\t'
+          << escape_tsv_field(track.album) << '\t' << track.duration_ms
+          << '\n';
+    }
+    if (!out)
+      return false;
+  }
+  return std::rename(tmp_path.c_str(), path_.c_str()) == 0;
+}
+
+bool LibraryStore::sync(const std::string &access_token) {
+  bool empty;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    empty = tracks_.empty();
+  }
+
+  if (empty) {
+    std::vector<SavedTrack> fetched;
+    bool ok = get_all_saved_tracks(
+        access_token, [&fetched](const rapidjson::Value &page, int) {
+          SavedTrack track;
+          for (auto &item : page["items"].GetArray()) {
+            if (saved_track_from_item(item, track))
+              fetched.push_back(track);
+          }
+          return true;
+        });
+    if (!ok)
+      return false;
+    std::lock_guard<std::mutex> lock(mutex_);
+    tracks_.swap(fetched);
+    last_reconciled_ = std::time(NULL);
+    rebuild_index();
+    save_locked();
+    return true;
+  }
+
+  std::vector<SavedTrack> fresh;
+  bool reached_known = false;
+  DocumentLease page;
+  for (int offset = 0; !reached_known; offset += kSyncPageSize) {
+    // Hand the previous page back so its arenas are reset for this one
+    page.reset();
+    if (!get_saved_tracks(access_token, page, kSyncPageSize, offset) ||
+        !page->HasMember("items") || !(*page)["items"].IsArray())
+      return false;
+    const rapidjson::Value &items = (*page)["items"];
+    std::lock_guard<std::mutex> lock(mutex_);
+    SavedTrack track;
+    for (auto &item : items.GetArray()) {
+      if (!saved_track_from_item(item, track))
+        continue;
+      auto known = by_uri_.find(track.uri);
+      if (known != by_uri_.end() &&
+          tracks_[known->second].added_at == track.added_at) {
+        reached_known = true;
+        break;
+      }
+      fresh.push_back(track);
+    }
+    if (items.Size() < static_cast<rapidjson::SizeType>(kSyncPageSize))
+      break;
+  }
+  if (fresh.empty())
+    return true;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::unordered_set<std::string> fresh_uris;
+  for (auto &track : fresh)
+    fresh_uris.insert(track.uri);
+  for (auto &track : tracks_) {
+    if (!fresh_uris.count(track.uri))
+      fresh.push_back(track);
+  }
+  tracks_.swap(fresh);
+  rebuild_index();
+  save_locked();
+  return true;
+}
+
+void LibraryStore::reconcile_in_background(const std::string &access_token,
+                                           long min_interval_seconds) {
+  std::string newest_added_at;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (reconciling_ || stopping_ ||
+        std::time(NULL) - last_reconciled_ < min_interval_seconds)
+      return;
+    if (!tracks_.empty())
+      newest_added_at = tracks_.front().added_at;
+    reconciling_ = true;
+  }
+  if (reconcile_thread_.joinable())
+    reconcile_thread_.join();
+  reconcile_thread_ = std::thread(&LibraryStore::reconcile, this,
+                                  access_token, newest_added_at);
+}
+
+// Tracks saved after the pass started are newer than newest_added_at and are
+// kept even though the listing may not have included them
+void LibraryStore::reconcile(const std::string &access_token,
+                             std::string newest_added_at) {
+  RequestPriorityScope background(RequestPriority::BACKGROUND);
+  std::unordered_set<std::string> listed;
+  bool ok = get_all_saved_tracks(
+      access_token,
+      [this, &listed](const rapidjson::Value &page, int) {
+        if (stopping_)
+          return false;
+        SavedTrack track;
+        for (auto &item : page["items"].GetArray()) {
+          if (saved_track_from_item(item, track))
+            listed.insert(track.uri);
+        }
+        std::this_thread::sleep_for(
+            std::chrono::milliseconds(kReconcilePagePauseMs));
+        return true;
+      },
+      1);
+
+  if (ok && !stopping_) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<SavedTrack> kept;
+    kept.reserve(tracks_.size());
+    for (auto &track : tracks_) {
+      if (track.added_at > newest_added_at || listed.count(track.uri))
+        kept.push_back(track);
+    }
+    tracks_.swap(kept);
+    last_reconciled_ = std::time(NULL);
+    rebuild_index();
+    save_locked();
+  }
+  reconciling_ = false;
+}
+
+void LibraryStore::remove(const std::string &uri) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = by_uri_.find(uri);
+  if (it == by_uri_.end())
+    return;
+  tracks_.erase(tracks_.begin() + static_cast<long>(it->second));
+  rebuild_index();
+  save_locked();
+}
+
+void LibraryStore::remove(const std::vector<std::string> &uris) {
+  std::unordered_set<std::string> removed(uris.begin(), uris.end());
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t before = tracks_.size();
+  tracks_.erase(std::remove_if(tracks_.begin(), tracks_.end(),
+                               [&removed](const SavedTrack &track) {
+                                 return removed.count(track.uri) > 0;
+                               }),
+                tracks_.end());
+  if (tracks_.size() == before)
+    return;
+  rebuild_index();
+  save_locked();
+}
+
+std::vector<SavedTrack> LibraryStore::tracks() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return tracks_;
+}
+
+CatalogView LibraryStore::catalog_view() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return catalog_refs_;
+}
+
+size_t LibraryStore::size() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return tracks_.size();
+}
+
+// Also feeds the local search index and the catalog, which both skip
+// entries they already have
+void LibraryStore::rebuild_index() {
+  by_uri_.clear();
+  by_uri_.reserve(tracks_.size());
+  catalog_refs_.clear();
+  catalog_refs_.reserve(tracks_.size());
+  SearchIndex &index = search_index();
+  Catalog &entries = catalog();
+  for (size_t i = 0; i < tracks_.size(); ++i) {
+    const SavedTrack &track = tracks_[i];
+    by_uri_[track.uri] = i;
+    catalog_refs_.push_back(entries.add_track(track.name, track.uri,
+                                              track.artist, track.album,
+                                              track.duration_ms));
+    index.add(LocalKind::TRACK, track.name, track.uri);
+    index.add(LocalKind::ARTIST, track.artist, "");
+    index.add(LocalKind::ALBUM, track.album, "");
+  }
+}
+
+LibraryStore &library_store() {
+  static LibraryStore store(cache_directory() + "/saved_tracks.tsv");
+  static bool loaded = store.load();
+  (void)loaded;
+  return store;
+}
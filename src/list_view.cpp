@@ -0,0 +1,208 @@
+// src/list_view.cpp
+#include "list_view.h"
+#include "search_index.h"
+#include <cstdio>
+
+namespace {
+
+void append_utf8(std::string &out, uint32_t cp) {
+  if (cp < 0x80) {
+    out += static_cast<char>(cp);
+  } else if (cp < 0x800) {
+    out += static_cast<char>(0xC0 | (cp >> 6));
+    out += static_cast<char>(0x80 | (cp & 0x3F));
+  } else if (cp < 0x10000) {
+    out += static_cast<char>(0xE0 | (cp >> 12));
+    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (cp & 0x3F));
+  } else {
+    out += static_cast<char>(0xF0 | (cp >> 18));
+    out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (cp & 0x3F));
+  }
+}
+
+// Removes the last UTF-8 character of text
+void pop_utf8(std::string &text) {
+  while (!text.empty()) {
+    unsigned char last = text.back();
+    text.pop_back();
+    if ((last & 0xC0) != 0x80)
+      break;
+  }
+}
+
+int digits(size_t value) {
+  int count = 1;
+  while (value >= 10) {
+    value /= 10;
+    ++count;
+  }
+  return count;
+}
+
+} // namespace
+
+ListView::ListView(const std::string &title, size_t count,
+                   const RowText &row_text)
+    : title_(title), count_(count), row_text_(row_text), selected_(0),
+      top_(0), rows_(24) {}
+
+void ListView::set_count(size_t count) {
+  count_ = count;
+  select(selected_ < count ? selected_ : (count ? count - 1 : 0));
+}
+
+void ListView::move(long delta) {
+  if (count_ == 0)
+    return;
+  long target = static_cast<long>(selected_) + delta;
+  if (target < 0)
+    target = 0;
+  if (target >= static_cast<long>(count_))
+    target = static_cast<long>(count_) - 1;
+  select(static_cast<size_t>(target));
+}
+
+void ListView::select(size_t index) {
+  if (index >= count_) {
+    selected_ = top_ = 0;
+    return;
+  }
+  selected_ = index;
+  size_t page = visible_rows();
+  if (selected_ < top_)
+    top_ = selected_;
+  else if (selected_ >= top_ + page)
+    top_ = selected_ - page + 1;
+}
+
+bool ListView::handle_key(const KeyEvent &key) {
+  long page = static_cast<long>(visible_rows());
+  switch (key.key) {
+  case Key::UP:
+    move(-1);
+    break;
+  case Key::DOWN:
+    move(1);
+    break;
+  case Key::PAGE_UP:
+    move(-page);
+    break;
+  case Key::PAGE_DOWN:
+    move(page);
+    break;
+  case Key::HOME:
+    select(0);
+    break;
+  case Key::END:
+    if (count_)
+      select(count_ - 1);
+    break;
+  case Key::CHAR:
+    append_utf8(search_, key.ch);
+    find_next(selected_);
+    break;
+  case Key::BACKSPACE:
+    pop_utf8(search_);
+    if (!search_.empty())
+      find_next(selected_);
+    break;
+  case Key::ESCAPE:
+    if (search_.empty())
+      return false;
+    search_.clear();
+    break;
+  default:
+    return false;
+  }
+  return true;
+}
+
+// Scans from the selection, wrapping around; this is the one place that
+// formats rows outside the view
+void ListView::find_next(size_t from) {
+  std::string needle = fold_for_search(search_);
+  if (needle.empty())
+    return;
+  for (size_t k = 0; k < count_; ++k) {
+    size_t index = (from + k) % count_;
+    if (fold_for_search(row_text_(index)).find(needle) != std::string::npos) {
+      select(index);
+      return;
+    }
+  }
+}
+
+void ListView::draw(Screen &screen) {
+  int cols = screen.cols();
+  rows_ = screen.rows();
+  // The height may have changed since the last frame
+  select(selected_);
+
+  screen.clear();
+  const uint8_t title_style = kStyleBold | kStyleReverse;
+  screen.fill(0, 0, cols, title_style);
+  screen.draw_text(0, 1, title_, title_style, cols - 2);
+
+  char number[32];
+  int width = digits(count_);
+  size_t page = visible_rows();
+  for (size_t i = 0; i < page && top_ + i < count_; ++i) {
+    size_t index = top_ + i;
+    int row = static_cast<int>(i) + 1;
+    uint8_t style = index == selected_ ? kStyleReverse : 0;
+    if (style)
+      screen.fill(row, 0, cols, style);
+    std::snprintf(number, sizeof(number), "%*zu. ", width, index + 1);
+    int used = screen.draw_text(row, 0, number, style ? style : kStyleDim);
+    screen.draw_text(row, used, row_text_(index), style);
+  }
+
+  char status[64];
+  std::snprintf(status, sizeof(status), "%zu/%zu",
+                count_ ? selected_ + 1 : 0, count_);
+  std::string left = status;
+  left += search_.empty() ? "  Enter: select  Esc: back  type to find"
+                          : "  find: " + search_;
+  int last = screen.rows() - 1;
+  screen.fill(last, 0, cols, kStyleReverse);
+  screen.draw_text(last, 1, left, kStyleReverse, cols - 2);
+  std::snprintf(status, sizeof(status), " frame %.2fms ",
+                screen.frame_stats().last_ms);
+  int right = static_cast<int>(std::string(status).size());
+  if (right < cols)
+    screen.draw_text(last, cols - right, status, kStyleReverse);
+}
+
+size_t pick_from_list(const std::string &title, size_t count,
+                      const RowText &row_text) {
+  Screen screen;
+  if (count == 0 || !screen.start())
+    return count;
+  ListView view(title, count, row_text);
+  size_t picked = count;
+  bool done = false;
+  while (!done) {
+    view.draw(screen);
+    screen.present();
+    // Everything typed while the last frame was drawn is applied before the
+    // next one, so a held key never leaves frames queued behind it
+    KeyEvent key = screen.read_key(-1);
+    while (key.key != Key::NONE && !done) {
+      if (key.key == Key::ENTER) {
+        picked = view.selected();
+        done = true;
+      } else if (key.key == Key::CHAR && key.ch == 'q' && !view.searching()) {
+        done = true;
+      } else if (!view.handle_key(key) && key.key == Key::ESCAPE) {
+        done = true;
+      }
+      if (!done)
+        key = screen.read_key(0);
+    }
+  }
+  screen.stop();
+  return picked;
+}
@@ -1,5 +1,11 @@
 
 // src/main.cpp
+#include "batch_mode.h"
+#include "http_client.h"
+#include "library_store.h"
+#include "page_prefetch.h"
+#include "player_state.h"
+#include "request_stats.h"
 #include "spotify_auth.h"
 #include "spotify_operations/LibraryOperations.h"
 #include "spotify_operations/PlaybackOperations.h"
@@ -7,6 +13,11 @@
 #include "spotify_operations/RecommendationsOperations.h"
 #include "spotify_operations/SearchOperations.h"
 #include "utils.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <string>
 
@@ -45,10 +56,58 @@ void display_main_menu() {
   std::cout << "3. Recommendations" << std::endl;
   std::cout << "4. Search" << std::endl;
   std::cout << "5. Library Management" << std::endl;
+  std::cout << "s. Request Stats" << std::endl;
   std::cout << "q. Quit" << std::endl;
   std::cout << FG_YELLOW << "Select an option: " << RESET;
 }
 
+// Function to display the request queues and rate limiting so far
+void display_request_stats() {
+  const char *const names[kRequestPriorities] = {"Interactive", "Normal",
+                                                 "Background"};
+  HttpSchedulerStats stats = http_scheduler_stats();
+  std::cout << FG_GREEN << BOLD << "\n=== Request Stats ===" << RESET
+            << std::endl;
+  std::ios::fmtflags flags = std::cout.flags();
+  std::streamsize precision = std::cout.precision();
+  std::cout << std::fixed << std::setprecision(1);
+  for (int p = 0; p < kRequestPriorities; ++p) {
+    RequestPriority priority = static_cast<RequestPriority>(p);
+    std::cout << names[p] << ": " << stats.started[p] << " started, "
+              << stats.queued[p] << " queued (max " << stats.max_queued[p]
+              << "), wait mean " << stats.mean_wait_ms(priority)
+              << "ms max " << stats.max_wait_ms[p] << "ms" << std::endl;
+  }
+  std::cout << "Rate limited: " << stats.throttled << " responses, "
+            << stats.retried << " retried";
+  if (stats.backoff_left_ms > 0)
+    std::cout << ", paused for " << stats.backoff_left_ms << "ms more";
+  std::cout << std::endl;
+
+  PrefetchStats prefetch = page_prefetcher().stats();
+  std::cout << "Prefetched pages: " << prefetch.started << " started, "
+            << prefetch.hits << " used, " << prefetch.misses << " missed (hit "
+            << prefetch.hit_ratio() * 100 << "%), " << prefetch.wasted
+            << " wasted, " << prefetch.bytes_used / 1024.0 << " KiB used, "
+            << prefetch.bytes_wasted / 1024.0 << " KiB wasted" << std::endl;
+  std::cout.flags(flags);
+  std::cout.precision(precision);
+
+  std::cout << FG_GREEN << BOLD << "\n=== Endpoints ===" << RESET << std::endl;
+  write_request_stats(std::cout, request_stats().snapshot());
+  const char *path = std::getenv("SPOTIFY_TUI_STATS_FILE");
+  if (path)
+    std::cout << "Written to " << path << " on exit and on SIGUSR1."
+              << std::endl;
+}
+
+// Writes the request statistics to $SPOTIFY_TUI_STATS_FILE, if set
+void dump_stats_file() {
+  const char *path = std::getenv("SPOTIFY_TUI_STATS_FILE");
+  if (path && !dump_request_stats(path))
+    std::cerr << "Cannot write request statistics to " << path << std::endl;
+}
+
 // Function to authenticate and retrieve access token
 bool authenticate_user(std::string &access_token) {
   return authenticate(access_token);
@@ -60,7 +119,71 @@ void handle_invalid_input() {
             << std::endl;
 }
 
-int main() {
+void print_usage(const char *program) {
+  std::cerr << "Usage: " << program << "\n"
+            << "       " << program
+            << " --batch [--concurrency N] [--no-coalesce] [FILE]\n"
+            << "Batch mode runs the commands in FILE (standard input when "
+               "absent or -)\n"
+               "with a saved session and prints one JSON result per "
+               "command.\n";
+  print_batch_usage(std::cerr);
+}
+
+// Runs a command script without prompting; the exit status is 0 only if
+// every command succeeded
+int run_batch_mode(int argc, char **argv) {
+  BatchOptions options;
+  std::string path = "-";
+  for (int i = 2; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--concurrency") == 0 && i + 1 < argc) {
+      options.concurrency = std::max(1, std::atoi(argv[++i]));
+    } else if (std::strcmp(argv[i], "--no-coalesce") == 0) {
+      options.coalesce = false;
+    } else if (argv[i][0] == '-' && std::strcmp(argv[i], "-") != 0) {
+      print_usage(argv[0]);
+      return 2;
+    } else {
+      path = argv[i];
+    }
+  }
+
+  std::ifstream file;
+  if (path != "-") {
+    file.open(path);
+    if (!file) {
+      std::cerr << "Cannot open " << path << "\n";
+      return 2;
+    }
+  }
+  std::string access_token;
+  if (!resume_saved_session(access_token)) {
+    std::cerr << "No saved session; run the application interactively once "
+                 "to sign in.\n";
+    return 2;
+  }
+  BatchStats stats = run_batch(access_token, path == "-" ? std::cin : file,
+                               std::cout, options);
+  std::cerr << stats.commands << " commands, " << stats.failed
+            << " failed, " << stats.requests << " requests in "
+            << static_cast<long>(stats.elapsed_ms) << "ms\n";
+  dump_stats_file();
+  return stats.failed ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+  // Before any thread starts, so that only the dumping thread takes SIGUSR1
+  const char *stats_file = std::getenv("SPOTIFY_TUI_STATS_FILE");
+  if (stats_file)
+    dump_request_stats_on_signal(stats_file);
+
+  if (argc > 1 && std::strcmp(argv[1], "--batch") == 0)
+    return run_batch_mode(argc, argv);
+  if (argc > 1) {
+    print_usage(argv[0]);
+    return std::strcmp(argv[1], "--help") == 0 ? 0 : 2;
+  }
+
   std::string access_token;
   clear_screen();
   display_header();
@@ -77,9 +200,13 @@ int main() {
     return 1;
   }
   std::cout << FG_GREEN << " Success!" << RESET << std::endl;
+  player_poller().start(access_token);
 
   while (true) {
     display_header();
+    PlayerState player;
+    if (player_commands().snapshot(player))
+      std::cout << describe_player_state(player) << std::endl;
     display_main_menu();
 
     std::string choice;
@@ -91,6 +218,15 @@ int main() {
       continue;
     }
 
+    if (!refresh_if_expiring(access_token)) {
+      std::cerr << FG_RED << "Your session has expired. Please sign in again."
+                << RESET << std::endl;
+      if (!authenticate_user(access_token))
+        return 1;
+    }
+    // Picks up a refreshed token
+    player_poller().start(access_token);
+
     if (choice == "1") {
       playlist_menu(access_token);
     } else if (choice == "2") {
@@ -101,9 +237,17 @@ int main() {
       search_menu(access_token);
     } else if (choice == "5") {
       library_menu(access_token);
+    } else if (choice == "s" || choice == "S") {
+      display_request_stats();
     } else if (choice == "q" || choice == "Q") {
       std::cout << FG_BLUE << "Exiting application. Goodbye!" << RESET
                 << std::endl;
+      // A setting changed just before quitting is still settling
+      player_commands().wait();
+      player_commands().stop();
+      library_store().stop();
+      player_poller().stop();
+      dump_stats_file();
       break;
     } else {
       handle_invalid_input();
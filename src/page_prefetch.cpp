@@ -0,0 +1,130 @@
+// src/page_prefetch.cpp
+#include "page_prefetch.h"
+#include "spotify_api.h"
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+enum PrefetchState { PREFETCH_PENDING, PREFETCH_ARRIVED, PREFETCH_FAILED };
+
+struct Prefetch {
+  PrefetchState state;
+  // Tells a fetch apart from a later one of the same URL after a discard
+  uint64_t serial;
+  HttpRequestId id;
+  ItemPage page;
+
+  Prefetch() : state(PREFETCH_PENDING), serial(0), id(0) {}
+};
+
+} // namespace
+
+// Shared with the completion callbacks, which may run after a discard
+struct PagePrefetcher::State {
+  std::mutex mutex;
+  std::condition_variable arrived;
+  std::map<std::string, Prefetch> pages;
+  uint64_t next_serial = 0;
+  PrefetchStats stats;
+};
+
+PagePrefetcher::PagePrefetcher() : state_(std::make_shared<State>()) {}
+
+void PagePrefetcher::prefetch(const std::string &access_token,
+                              const std::string &url, ItemView view) {
+  uint64_t serial;
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    if (state_->pages.count(url))
+      return;
+    serial = ++state_->next_serial;
+    state_->pages[url].serial = serial;
+    ++state_->stats.started;
+  }
+
+  std::shared_ptr<State> state = state_;
+  HttpRequestId id;
+  {
+    RequestPriorityScope background(RequestPriority::BACKGROUND);
+    id = spotify_get_items_async(
+        access_token, url, view,
+        [state, url, serial](bool ok, ItemPage &page) {
+          std::lock_guard<std::mutex> lock(state->mutex);
+          auto it = state->pages.find(url);
+          if (it == state->pages.end() || it->second.serial != serial) {
+            // Discarded while in flight, and already counted as wasted
+            state->stats.bytes_wasted += page.bytes;
+            return;
+          }
+          it->second.state = ok ? PREFETCH_ARRIVED : PREFETCH_FAILED;
+          std::swap(it->second.page, page);
+          state->arrived.notify_all();
+        });
+  }
+
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  auto it = state_->pages.find(url);
+  if (it != state_->pages.end() && it->second.serial == serial)
+    it->second.id = id;
+}
+
+bool PagePrefetcher::take(const std::string &url, ItemPage &page) {
+  std::unique_lock<std::mutex> lock(state_->mutex);
+  if (state_->pages.empty())
+    return false;
+  std::map<std::string, Prefetch> &pages = state_->pages;
+  auto pending = pages.find(url);
+  if (pending != pages.end() && pending->second.state == PREFETCH_PENDING &&
+      pending->second.id) {
+    ++state_->stats.promoted;
+    http_promote(pending->second.id, current_request_priority());
+  }
+  state_->arrived.wait(lock, [&pages, &url] {
+    auto it = pages.find(url);
+    return it == pages.end() || it->second.state != PREFETCH_PENDING;
+  });
+  auto it = pages.find(url);
+  if (it == pages.end() || it->second.state == PREFETCH_FAILED) {
+    if (it != pages.end())
+      pages.erase(it);
+    ++state_->stats.misses;
+    return false;
+  }
+  std::swap(page, it->second.page);
+  pages.erase(it);
+  ++state_->stats.hits;
+  state_->stats.bytes_used += page.bytes;
+  return true;
+}
+
+void PagePrefetcher::discard() {
+  std::vector<HttpRequestId> in_flight;
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    for (auto &entry : state_->pages) {
+      const Prefetch &prefetch = entry.second;
+      ++state_->stats.wasted;
+      if (prefetch.state == PREFETCH_PENDING && prefetch.id)
+        in_flight.push_back(prefetch.id);
+      state_->stats.bytes_wasted += prefetch.page.bytes;
+    }
+    state_->pages.clear();
+    state_->arrived.notify_all();
+  }
+  // Outside the lock: a cancelled request's callback takes it
+  for (HttpRequestId id : in_flight)
+    http_cancel(id);
+}
+
+PrefetchStats PagePrefetcher::stats() {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->stats;
+}
+
+PagePrefetcher &page_prefetcher() {
+  static PagePrefetcher instance;
+  return instance;
+}
@@ -0,0 +1,133 @@
+// src/pagination.cpp
+#include "pagination.h"
+#include "page_prefetch.h"
+#include "spotify_api.h"
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+enum PageState { PAGE_PENDING, PAGE_ARRIVED, PAGE_FAILED };
+
+// Pages that have arrived but not been delivered yet, in a ring of one slot
+// per page of the window. Shared with the completion callbacks, which may
+// outlive the fetch if it stops early.
+template <typename Page> struct PageBuffer {
+  explicit PageBuffer(int window) : pages(window), states(window) {}
+
+  std::mutex mutex;
+  std::condition_variable arrived;
+  std::vector<Page> pages;
+  std::vector<PageState> states;
+};
+
+int page_total(const rapidjson::Value &page) {
+  if (page.IsObject() && page.HasMember("total") && page["total"].IsInt())
+    return page["total"].GetInt();
+  return 0;
+}
+
+int page_total(const DocumentLease &page) { return page_total(*page); }
+
+int page_total(const ItemPage &page) { return page.total; }
+
+void take_page(DocumentLease &to, DocumentLease &from) {
+  to = std::move(from);
+}
+
+void take_page(ItemPage &to, ItemPage &from) { std::swap(to, from); }
+
+// Windowed, in-order page fetching shared by the DOM and item variants.
+// fetch_first(page) fetches offset 0 synchronously; fetch_async(offset, done)
+// starts the fetch of a later page and calls done(ok, page) on completion.
+// A page taken out of the ring hands its storage back to the slot, so pages
+// are recycled rather than allocated once the window has filled.
+template <typename Page, typename FetchFirst, typename FetchAsync,
+          typename Deliver>
+bool fetch_pages(int page_size, int window, FetchFirst fetch_first,
+                 FetchAsync fetch_async, const Deliver &on_page) {
+  // A window below one would never request a page, or divide by zero
+  window = std::max(1, window);
+  Page page;
+  if (!fetch_first(page))
+    return false;
+  int total = page_total(page);
+  if (!on_page(page, 0))
+    return true;
+
+  std::shared_ptr<PageBuffer<Page>> buffer =
+      std::make_shared<PageBuffer<Page>>(window);
+  int next_request = page_size;
+  int next_delivery = page_size;
+  while (next_delivery < total) {
+    while (next_request < total &&
+           next_request - next_delivery < window * page_size) {
+      size_t slot = next_request / page_size % window;
+      fetch_async(next_request, [buffer, slot](bool ok, Page &fetched) {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+        if (ok)
+          take_page(buffer->pages[slot], fetched);
+        buffer->states[slot] = ok ? PAGE_ARRIVED : PAGE_FAILED;
+        buffer->arrived.notify_all();
+      });
+      next_request += page_size;
+    }
+
+    size_t slot = next_delivery / page_size % window;
+    {
+      std::unique_lock<std::mutex> lock(buffer->mutex);
+      buffer->arrived.wait(lock, [&buffer, slot] {
+        return buffer->states[slot] != PAGE_PENDING;
+      });
+      if (buffer->states[slot] == PAGE_FAILED)
+        return false;
+      buffer->states[slot] = PAGE_PENDING;
+      take_page(page, buffer->pages[slot]);
+    }
+    if (!on_page(page, next_delivery))
+      return true;
+    next_delivery += page_size;
+  }
+  return true;
+}
+
+} // namespace
+
+bool fetch_all_pages(const std::string &access_token,
+                     const PageUrlBuilder &page_url, int page_size, int window,
+                     const PageCallback &on_page) {
+  return fetch_pages<DocumentLease>(
+      page_size, window,
+      [&](DocumentLease &page) {
+        return spotify_get_pooled_json(access_token, page_url(page_size, 0),
+                                       page);
+      },
+      [&](int offset, const PooledJsonCallback &done) {
+        spotify_get_pooled_json_async(access_token,
+                                      page_url(page_size, offset), done);
+      },
+      [&](const DocumentLease &page, int offset) {
+        return on_page(*page, offset);
+      });
+}
+
+bool fetch_all_item_pages(const std::string &access_token,
+                          const PageUrlBuilder &page_url, int page_size,
+                          int window, ItemView view,
+                          const ItemPageCallback &on_page) {
+  return fetch_pages<ItemPage>(
+      page_size, window,
+      [&](ItemPage &page) {
+        std::string url = page_url(page_size, 0);
+        return page_prefetcher().take(url, page) ||
+               spotify_get_items(access_token, url, view, page);
+      },
+      [&](int offset, const ItemsCallback &done) {
+        spotify_get_items_async(access_token, page_url(page_size, offset),
+                                view, done);
+      },
+      on_page);
+}
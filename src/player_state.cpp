@@ -0,0 +1,274 @@
+// src/player_state.cpp
+#include "player_state.h"
+#include "spotify_api.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+// First poll after a player command, long enough for the command to land
+const int kCommandDelayMs = 300;
+// Polls after that one, while a command may still be taking effect
+const int kSettleIntervalMs = 1000;
+const int kSettlePolls = 2;
+// While playing, progress is interpolated; the poll only catches changes
+// made elsewhere, such as from a phone
+const int kPlayingIntervalMs = 5000;
+// Where the next poll lands after the current track is due to end
+const int kBoundarySlackMs = 250;
+// Starting intervals while paused, with no device, and after a failure; each
+// poll that finds nothing new doubles them up to kMaxIntervalMs
+const int kPausedIntervalMs = 10000;
+const int kIdleIntervalMs = 30000;
+const int kFailureIntervalMs = 5000;
+const int kMaxIntervalMs = 60000;
+// Progress further than this from the interpolated value means a seek
+const int kSeekToleranceMs = 1500;
+
+std::string string_member(const rapidjson::Value &object, const char *name) {
+  if (object.IsObject() && object.HasMember(name) &&
+      object[name].IsString())
+    return object[name].GetString();
+  return "";
+}
+
+int int_member(const rapidjson::Value &object, const char *name,
+               int fallback) {
+  if (object.IsObject() && object.HasMember(name) && object[name].IsInt())
+    return object[name].GetInt();
+  return fallback;
+}
+
+bool bool_member(const rapidjson::Value &object, const char *name) {
+  return object.IsObject() && object.HasMember(name) &&
+         object[name].IsBool() && object[name].GetBool();
+}
+
+std::string format_time(int ms) {
+  int seconds = std::max(ms, 0) / 1000;
+  char buffer[16];
+  std::snprintf(buffer, sizeof(buffer), "%d:%02d", seconds / 60, seconds % 60);
+  return buffer;
+}
+
+// Whether fresh differs from cached in anything a display shows, other than
+// progress moving on as expected
+bool player_state_changed(const PlayerState &cached,
+                          const PlayerState &fresh) {
+  if (cached.active != fresh.active || cached.playing != fresh.playing ||
+      cached.track_uri != fresh.track_uri ||
+      cached.device_name != fresh.device_name ||
+      cached.volume != fresh.volume || cached.shuffle != fresh.shuffle ||
+      cached.repeat != fresh.repeat)
+    return true;
+  int expected = cached.progress_at(fresh.fetched_at);
+  return std::abs(expected - fresh.progress_ms) > kSeekToleranceMs;
+}
+
+} // namespace
+
+int PlayerState::progress_at(std::chrono::steady_clock::time_point now) const {
+  if (!playing || now <= fetched_at)
+    return progress_ms;
+  long long elapsed =
+      std::chrono::duration_cast<std::chrono::milliseconds>(now - fetched_at)
+          .count();
+  long long progress = progress_ms + elapsed;
+  if (duration_ms > 0 && progress > duration_ms)
+    progress = duration_ms;
+  return static_cast<int>(progress);
+}
+
+void player_state_from_json(const rapidjson::Value &doc, PlayerState &state) {
+  state = PlayerState();
+  if (!doc.IsObject())
+    return;
+  state.active = true;
+  state.playing = bool_member(doc, "is_playing");
+  state.progress_ms = int_member(doc, "progress_ms", 0);
+  state.shuffle = bool_member(doc, "shuffle_state");
+  std::string repeat = string_member(doc, "repeat_state");
+  if (!repeat.empty())
+    state.repeat = repeat;
+  if (doc.HasMember("device")) {
+    const rapidjson::Value &device = doc["device"];
+    state.device_name = string_member(device, "name");
+    state.volume = int_member(device, "volume_percent", -1);
+  }
+  // null between tracks and during ads
+  if (doc.HasMember("item") && doc["item"].IsObject()) {
+    const rapidjson::Value &item = doc["item"];
+    state.track_name = string_member(item, "name");
+    state.track_uri = string_member(item, "uri");
+    state.duration_ms = int_member(item, "duration_ms", 0);
+    if (item.HasMember("artists") && item["artists"].IsArray() &&
+        item["artists"].Size() > 0)
+      state.artist = string_member(item["artists"][0u], "name");
+    else if (item.HasMember("show"))
+      state.artist = string_member(item["show"], "name");
+  }
+}
+
+bool get_player_state(const std::string &access_token, PlayerState &state) {
+  DocumentLease doc;
+  if (!spotify_get_pooled_json(access_token, spotify_api_url("/me/player"),
+                               doc))
+    return false;
+  player_state_from_json(*doc, state);
+  state.fetched_at = std::chrono::steady_clock::now();
+  return true;
+}
+
+std::string describe_player_state(const PlayerState &state) {
+  if (!state.active)
+    return "Nothing playing";
+  std::string out = state.playing ? "Playing: " : "Paused: ";
+  out += state.track_name.empty() ? "(unknown)" : state.track_name;
+  if (!state.artist.empty())
+    out += " - " + state.artist;
+  out += " [" + format_time(state.progress_now()) + "/" +
+         format_time(state.duration_ms) + "]";
+  if (!state.device_name.empty())
+    out += " on " + state.device_name;
+  if (state.volume >= 0)
+    out += ", volume " + std::to_string(state.volume) + "%";
+  out += state.shuffle ? ", shuffle on" : ", shuffle off";
+  out += ", repeat " + state.repeat;
+  return out;
+}
+
+PlayerPoller::PlayerPoller()
+    : running_(false), poked_(false), have_state_(false), version_(0),
+      settle_polls_(0), quiet_ms_(0) {}
+
+PlayerPoller::~PlayerPoller() { stop(); }
+
+void PlayerPoller::start(const std::string &access_token) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  access_token_ = access_token;
+  if (running_)
+    return;
+  running_ = true;
+  thread_ = std::thread(&PlayerPoller::run, this);
+}
+
+void PlayerPoller::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+  }
+  wake_.notify_all();
+  if (thread_.joinable())
+    thread_.join();
+}
+
+bool PlayerPoller::snapshot(PlayerState &state) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (have_state_)
+    state = state_;
+  return have_state_;
+}
+
+uint64_t PlayerPoller::version() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return version_;
+}
+
+void PlayerPoller::poke() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    poked_ = true;
+    settle_polls_ = kSettlePolls;
+  }
+  wake_.notify_all();
+}
+
+void PlayerPoller::amend(const std::function<void(PlayerState &)> &change) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!have_state_)
+    return;
+  change(state_);
+  amended_at_ = std::chrono::steady_clock::now();
+  ++version_;
+}
+
+PlayerPollerStats PlayerPoller::stats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void PlayerPoller::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto next = std::chrono::steady_clock::now();
+  while (running_) {
+    auto now = std::chrono::steady_clock::now();
+    if (poked_) {
+      poked_ = false;
+      next = std::min(next, now + std::chrono::milliseconds(kCommandDelayMs));
+    }
+    if (now < next) {
+      wake_.wait_until(lock, next);
+      continue;
+    }
+
+    std::string access_token = access_token_;
+    lock.unlock();
+    PlayerState fresh;
+    bool ok = get_player_state(access_token, fresh);
+    lock.lock();
+
+    ++stats_.polls;
+    bool changed = false;
+    if (ok && now < amended_at_) {
+      // The cache already has a newer command's effect; the poke that came
+      // with it schedules the next poll
+    } else if (ok) {
+      changed = !have_state_ || player_state_changed(state_, fresh);
+      state_ = fresh;
+      have_state_ = true;
+      if (changed) {
+        ++version_;
+        ++stats_.changes;
+      }
+    } else {
+      ++stats_.failures;
+    }
+    stats_.interval_ms = next_interval_ms(ok, changed);
+    next = std::chrono::steady_clock::now() +
+           std::chrono::milliseconds(stats_.interval_ms);
+  }
+}
+
+// Called with mutex_ held after each poll
+int PlayerPoller::next_interval_ms(bool ok, bool changed) {
+  if (!ok) {
+    quiet_ms_ = std::min(std::max(quiet_ms_ * 2, kFailureIntervalMs),
+                         kMaxIntervalMs);
+    return quiet_ms_;
+  }
+  if (settle_polls_ > 0) {
+    --settle_polls_;
+    return kSettleIntervalMs;
+  }
+  if (state_.playing) {
+    quiet_ms_ = kPlayingIntervalMs;
+    int interval = kPlayingIntervalMs;
+    if (state_.duration_ms > 0) {
+      int remaining = state_.duration_ms - state_.progress_ms;
+      interval = std::min(interval, remaining + kBoundarySlackMs);
+    }
+    return std::max(interval, kCommandDelayMs);
+  }
+  int base = state_.active ? kPausedIntervalMs : kIdleIntervalMs;
+  if (changed || quiet_ms_ < base)
+    quiet_ms_ = base;
+  else
+    quiet_ms_ = std::min(quiet_ms_ * 2, kMaxIntervalMs);
+  return quiet_ms_;
+}
+
+PlayerPoller &player_poller() {
+  static PlayerPoller poller;
+  return poller;
+}
@@ -0,0 +1,144 @@
+// src/playlist_store.cpp
+#include "playlist_store.h"
+#include "utils.h"
+#include <cctype>
+#include <cstdio>
+#include <dirent.h>
+#include <fstream>
+#include <sys/stat.h>
+#include <unordered_set>
+
+namespace {
+
+const char *const kHeader = "#spotify-tui playlist 1\t";
+const char *const kExtension = ".tsv";
+
+// Reads the snapshot_id from the header of a stored copy
+bool read_snapshot(std::istream &in, std::string &snapshot_id) {
+  std::string line;
+  std::string header = kHeader;
+  if (!std::getline(in, line) || line.compare(0, header.size(), header) != 0)
+    return false;
+  snapshot_id = unescape_tsv_field(line.substr(header.size()));
+  return true;
+}
+
+// Spotify IDs are base62; anything else could name a path outside the store
+bool safe_file_name(const std::string &id) {
+  if (id.empty())
+    return false;
+  for (char c : id) {
+    if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '-')
+      return false;
+  }
+  return true;
+}
+
+} // namespace
+
+PlaylistStore::PlaylistStore(const std::string &directory)
+    : directory_(directory) {
+  mkdir(directory_.c_str(), 0700);
+}
+
+std::string PlaylistStore::path_of(const std::string &playlist_id) const {
+  if (!safe_file_name(playlist_id))
+    return "";
+  return directory_ + "/" + playlist_id + kExtension;
+}
+
+bool PlaylistStore::has(const std::string &playlist_id,
+                        const std::string &snapshot_id) {
+  std::string path = path_of(playlist_id);
+  if (path.empty() || snapshot_id.empty())
+    return false;
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::ifstream in(path);
+  std::string stored;
+  return in && read_snapshot(in, stored) && stored == snapshot_id;
+}
+
+bool PlaylistStore::load(const std::string &playlist_id,
+                         const std::string &snapshot_id,
+                         std::vector<NamedItem> &tracks) {
+  std::string path = path_of(playlist_id);
+  std::lock_guard<std::mutex> lock(mutex_);
+  // An empty path fails to open
+  std::ifstream in(path);
+  std::string stored;
+  if (snapshot_id.empty() || !in || !read_snapshot(in, stored) ||
+      stored != snapshot_id) {
+    ++stats_.misses;
+    return false;
+  }
+  std::vector<NamedItem> loaded;
+  std::string line;
+  while (std::getline(in, line)) {
+    size_t tab = line.find('\t');
+    if (tab == std::string::npos)
+      continue;
+    NamedItem item;
+    item.key = line.substr(0, tab);
+    item.name = unescape_tsv_field(line.substr(tab + 1));
+    loaded.push_back(std::move(item));
+  }
+  tracks.swap(loaded);
+  ++stats_.hits;
+  return true;
+}
+
+// Writes to a temporary file and renames it so a crash never leaves a
+// truncated copy behind
+bool PlaylistStore::save(const std::string &playlist_id,
+                         const std::string &snapshot_id,
+                         const std::vector<NamedItem> &tracks) {
+  std::string path = path_of(playlist_id);
+  if (path.empty() || snapshot_id.empty())
+    return false;
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::string tmp_path = path + ".tmp";
+  {
+    std::ofstream out(tmp_path, std::ios::trunc);
+    if (!out)
+      return false;
+    out << kHeader << escape_tsv_field(snapshot_id) << "\n";
+    for (auto &track : tracks)
+      out << track.key << '\t' << escape_tsv_field(track.name) << '\n';
+    if (!out)
+      return false;
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0)
+    return false;
+  ++stats_.saves;
+  return true;
+}
+
+void PlaylistStore::retain(const std::vector<std::string> &playlist_ids) {
+  std::unordered_set<std::string> keep;
+  for (auto &id : playlist_ids)
+    keep.insert(id + kExtension);
+  std::string extension = kExtension;
+  std::lock_guard<std::mutex> lock(mutex_);
+  DIR *dir = opendir(directory_.c_str());
+  if (!dir)
+    return;
+  while (struct dirent *entry = readdir(dir)) {
+    std::string name = entry->d_name;
+    if (name.size() > extension.size() &&
+        name.compare(name.size() - extension.size(), extension.size(),
+                     extension) == 0 &&
+        !keep.count(name))
+      std::remove((directory_ + "/" + name).c_str());
+  }
+  closedir(dir);
+}
+
+PlaylistStoreStats PlaylistStore::stats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+PlaylistStore &playlist_store() {
+  static PlaylistStore store(cache_directory() + "/playlists");
+  return store;
+}
@@ -0,0 +1,187 @@
+// src/request_builder.cpp
+#include "request_builder.h"
+#include "utils.h"
+#include <cstdio>
+#include <cstring>
+
+UrlBuilder::UrlBuilder(const std::string &base)
+    : url_(base), base_length_(base.size()),
+      base_has_query_(base.find('?') != std::string::npos) {}
+
+UrlBuilder &UrlBuilder::reset() {
+  url_.resize(base_length_);
+  return *this;
+}
+
+void UrlBuilder::separator() {
+  url_ += base_has_query_ || url_.size() > base_length_ ? '&' : '?';
+}
+
+UrlBuilder &UrlBuilder::param(const char *name, const std::string &value) {
+  separator();
+  url_ += name;
+  url_ += '=';
+  append_url_encoded(url_, value.data(), value.size());
+  return *this;
+}
+
+UrlBuilder &UrlBuilder::param(const char *name, long long value) {
+  char digits[24];
+  int len = std::snprintf(digits, sizeof(digits), "%lld", value);
+  separator();
+  url_ += name;
+  url_ += '=';
+  url_.append(digits, len);
+  return *this;
+}
+
+void append_json_string(std::string &out, const char *data, size_t len) {
+  static const char kHex[] = "0123456789abcdef";
+  out += '"';
+  size_t run = 0; // start of the bytes not yet copied
+  for (size_t i = 0; i < len; ++i) {
+    unsigned char c = static_cast<unsigned char>(data[i]);
+    if (c >= 0x20 && c != '"' && c != '\\')
+      continue;
+    out.append(data + run, i - run);
+    run = i + 1;
+    out += '\\';
+    switch (c) {
+    case '"':
+    case '\\':
+      out += static_cast<char>(c);
+      break;
+    case '\n':
+      out += 'n';
+      break;
+    case '\r':
+      out += 'r';
+      break;
+    case '\t':
+      out += 't';
+      break;
+    default:
+      out += "u00";
+      out += kHex[c >> 4];
+      out += kHex[c & 0xF];
+      break;
+    }
+  }
+  out.append(data + run, len - run);
+  out += '"';
+}
+
+JsonBuilder::JsonBuilder() : depth_(0), after_key_(false) { first_[0] = true; }
+
+JsonBuilder &JsonBuilder::reserve(size_t bytes) {
+  json_.reserve(bytes);
+  return *this;
+}
+
+JsonBuilder &JsonBuilder::clear() {
+  json_.clear();
+  depth_ = 0;
+  first_[0] = true;
+  after_key_ = false;
+  return *this;
+}
+
+void JsonBuilder::separate() {
+  if (after_key_)
+    after_key_ = false;
+  else if (!first_[depth_])
+    json_ += ',';
+  first_[depth_] = false;
+}
+
+JsonBuilder &JsonBuilder::open(char bracket) {
+  separate();
+  json_ += bracket;
+  if (depth_ < kMaxDepth)
+    first_[++depth_] = true;
+  return *this;
+}
+
+JsonBuilder &JsonBuilder::close(char bracket) {
+  json_ += bracket;
+  if (depth_ > 0)
+    --depth_;
+  return *this;
+}
+
+JsonBuilder &JsonBuilder::begin_object() { return open('{'); }
+
+JsonBuilder &JsonBuilder::end_object() { return close('}'); }
+
+JsonBuilder &JsonBuilder::begin_array() { return open('['); }
+
+JsonBuilder &JsonBuilder::end_array() { return close(']'); }
+
+JsonBuilder &JsonBuilder::key(const char *name) {
+  separate();
+  append_json_string(json_, name, std::strlen(name));
+  json_ += ':';
+  after_key_ = true;
+  return *this;
+}
+
+JsonBuilder &JsonBuilder::value(const std::string &value) {
+  separate();
+  append_json_string(json_, value.data(), value.size());
+  return *this;
+}
+
+JsonBuilder &JsonBuilder::value(const char *value) {
+  separate();
+  append_json_string(json_, value, std::strlen(value));
+  return *this;
+}
+
+JsonBuilder &JsonBuilder::value(long long value) {
+  char digits[24];
+  int len = std::snprintf(digits, sizeof(digits), "%lld", value);
+  separate();
+  json_.append(digits, len);
+  return *this;
+}
+
+JsonBuilder &JsonBuilder::string_array(const std::string *values,
+                                       size_t count) {
+  begin_array();
+  for (size_t i = 0; i < count; ++i)
+    value(values[i]);
+  return end_array();
+}
+
+std::string JsonBuilder::release() {
+  std::string json;
+  json.swap(json_);
+  clear();
+  return json;
+}
+
+namespace {
+
+std::string string_array_body(const char *name, const std::string *values,
+                              size_t count) {
+  size_t length = std::strlen(name) + 8;
+  for (size_t i = 0; i < count; ++i)
+    length += values[i].size() + 3;
+  JsonBuilder json;
+  // Exact unless a value has characters to escape
+  json.reserve(length);
+  json.begin_object().key(name).string_array(values, count).end_object();
+  return json.release();
+}
+
+} // namespace
+
+std::string json_string_array_body(const char *name,
+                                   const std::vector<std::string> &values) {
+  return string_array_body(name, values.data(), values.size());
+}
+
+std::string json_string_array_body(const char *name,
+                                   const std::string &value) {
+  return string_array_body(name, &value, 1);
+}
@@ -0,0 +1,308 @@
+// src/request_stats.cpp
+#include "request_stats.h"
+#include <algorithm>
+#include <cctype>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <ostream>
+#include <pthread.h>
+#include <thread>
+
+namespace {
+
+// Values below this get a bucket each; above, each power of two is split
+// into half as many buckets
+const uint64_t kLinearValues = 64;
+const uint64_t kSubBuckets = kLinearValues / 2;
+
+const char *const kPhaseNames[kRequestPhases] = {
+    "dns", "connect", "tls", "first byte", "total", "parse"};
+
+int phase_index(RequestPhase phase) { return static_cast<int>(phase); }
+
+// Collections whose next path segment is the ID of one of their objects,
+// as in /v1/playlists/{id} and /v1/users/{id}. Only counted right after the
+// version or another ID, so /v1/me/tracks/contains keeps its last segment.
+const char *const kCollections[] = {"albums",   "artists",  "audiobooks",
+                                    "chapters", "episodes", "playlists",
+                                    "shows",    "tracks",   "users"};
+
+bool segment_is(const std::string &url, size_t begin, size_t end,
+                const char *name) {
+  return url.compare(begin, end - begin, name) == 0;
+}
+
+bool is_collection(const std::string &url, size_t begin, size_t end) {
+  for (const char *name : kCollections) {
+    if (segment_is(url, begin, end, name))
+      return true;
+  }
+  return false;
+}
+
+// Spotify IDs: 22 base62 characters
+bool is_spotify_id(const std::string &url, size_t begin, size_t end) {
+  if (end - begin != 22)
+    return false;
+  for (size_t i = begin; i < end; ++i) {
+    if (!std::isalnum(static_cast<unsigned char>(url[i])))
+      return false;
+  }
+  return true;
+}
+
+// "v1"
+bool is_version(const std::string &url, size_t begin, size_t end) {
+  if (end - begin < 2 || url[begin] != 'v')
+    return false;
+  for (size_t i = begin + 1; i < end; ++i) {
+    if (!std::isdigit(static_cast<unsigned char>(url[i])))
+      return false;
+  }
+  return true;
+}
+
+void append_ms(std::ostream &out, uint64_t us) {
+  char buffer[16];
+  std::snprintf(buffer, sizeof(buffer), " %8.2f", us / 1000.0);
+  out << buffer;
+}
+
+} // namespace
+
+const uint64_t LatencyHistogram::kMaxValueUs;
+
+LatencyHistogram::LatencyHistogram()
+    : buckets_(bucket_of(kMaxValueUs) + 1), count_(0), total_(0), min_(0),
+      max_(0) {}
+
+size_t LatencyHistogram::bucket_of(uint64_t value) {
+  if (value < kLinearValues)
+    return value;
+  // Shift that brings value into [kSubBuckets, kLinearValues)
+  int shift = 1;
+  while (value >> shift >= kLinearValues)
+    ++shift;
+  return kLinearValues + (shift - 1) * kSubBuckets +
+         ((value >> shift) - kSubBuckets);
+}
+
+uint64_t LatencyHistogram::highest_in(size_t bucket) {
+  if (bucket < kLinearValues)
+    return bucket;
+  int shift = static_cast<int>((bucket - kLinearValues) / kSubBuckets) + 1;
+  uint64_t sub = (bucket - kLinearValues) % kSubBuckets + kSubBuckets;
+  return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t value_us) {
+  value_us = std::min(value_us, kMaxValueUs);
+  ++buckets_[bucket_of(value_us)];
+  if (count_ == 0 || value_us < min_)
+    min_ = value_us;
+  max_ = std::max(max_, value_us);
+  ++count_;
+  total_ += value_us;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other) {
+  if (other.count_ == 0)
+    return;
+  for (size_t i = 0; i < buckets_.size(); ++i)
+    buckets_[i] += other.buckets_[i];
+  min_ = count_ ? std::min(min_, other.min_) : other.min_;
+  max_ = std::max(max_, other.max_);
+  count_ += other.count_;
+  total_ += other.total_;
+}
+
+uint64_t LatencyHistogram::percentile(double percent) const {
+  if (count_ == 0)
+    return 0;
+  double rank = percent / 100 * count_;
+  uint64_t wanted = std::max<uint64_t>(1, static_cast<uint64_t>(rank + 0.5));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < buckets_.size(); ++i) {
+    seen += buckets_[i];
+    if (seen >= wanted)
+      return std::min(highest_in(i), max_);
+  }
+  return max_;
+}
+
+const char *request_phase_name(RequestPhase phase) {
+  return kPhaseNames[phase_index(phase)];
+}
+
+std::string request_endpoint(const std::string &method,
+                             const std::string &url) {
+  size_t scheme = url.find("://");
+  size_t pos = url.find('/', scheme == std::string::npos ? 0 : scheme + 3);
+  size_t end = std::min(url.find_first_of("?#"), url.size());
+  std::string endpoint = method + " ";
+  if (pos >= end)
+    return endpoint + "/";
+  // Whether the previous segment was the root, the version or an ID, and
+  // whether it was a collection whose next segment is an ID
+  bool after_root = true, after_collection = false;
+  while (pos < end) {
+    size_t next = std::min(url.find('/', pos + 1), end);
+    size_t begin = pos + 1;
+    endpoint += '/';
+    if (after_collection || is_spotify_id(url, begin, next)) {
+      endpoint += "{id}";
+      after_root = true;
+      after_collection = false;
+    } else {
+      endpoint.append(url, begin, next - begin);
+      after_collection = after_root && is_collection(url, begin, next);
+      after_root = is_version(url, begin, next);
+    }
+    pos = next;
+  }
+  return endpoint;
+}
+
+RequestStats::RequestStats() {}
+
+EndpointStats &RequestStats::entry(const std::string &endpoint) {
+  auto it = endpoints_.find(endpoint);
+  if (it != endpoints_.end())
+    return *it->second;
+  std::string key = endpoint;
+  if (endpoints_.size() >= kMaxEndpoints) {
+    key = "other";
+    it = endpoints_.find(key);
+    if (it != endpoints_.end())
+      return *it->second;
+  }
+  std::unique_ptr<EndpointStats> stats(new EndpointStats());
+  stats->endpoint = key;
+  EndpointStats &added = *stats;
+  endpoints_[key] = std::move(stats);
+  return added;
+}
+
+void RequestStats::record_transfer(const HttpRequest &request,
+                                   const HttpResponse &response) {
+  std::string endpoint = request_endpoint(request.method, request.url);
+  const HttpTimings &timings = response.timings;
+  std::lock_guard<std::mutex> lock(mutex_);
+  EndpointStats &stats = entry(endpoint);
+  ++stats.requests;
+  if (response.transport_ok) {
+    ++stats.statuses[response.status];
+    stats.response_bytes += response.body.size();
+    stats.phases[phase_index(RequestPhase::FIRST_BYTE)].record(
+        timings.first_byte_us);
+  } else {
+    ++stats.transport_errors;
+  }
+  if (timings.new_connection) {
+    ++stats.new_connections;
+    stats.phases[phase_index(RequestPhase::DNS)].record(timings.dns_us);
+    stats.phases[phase_index(RequestPhase::CONNECT)].record(
+        timings.connect_us);
+    if (timings.tls_us)
+      stats.phases[phase_index(RequestPhase::TLS)].record(timings.tls_us);
+  }
+  stats.phases[phase_index(RequestPhase::TOTAL)].record(timings.total_us);
+}
+
+void RequestStats::record_parse(const std::string &method,
+                                const std::string &url, uint64_t elapsed_us) {
+  std::string endpoint = request_endpoint(method, url);
+  std::lock_guard<std::mutex> lock(mutex_);
+  entry(endpoint).phases[phase_index(RequestPhase::PARSE)].record(elapsed_us);
+}
+
+std::vector<EndpointStats> RequestStats::snapshot() {
+  std::vector<EndpointStats> copy;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    copy.reserve(endpoints_.size());
+    for (auto &entry : endpoints_)
+      copy.push_back(*entry.second);
+  }
+  std::stable_sort(copy.begin(), copy.end(),
+                   [](const EndpointStats &a, const EndpointStats &b) {
+                     return a.requests > b.requests;
+                   });
+  return copy;
+}
+
+void RequestStats::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  endpoints_.clear();
+}
+
+RequestStats &request_stats() {
+  static RequestStats stats;
+  return stats;
+}
+
+void write_request_stats(std::ostream &out,
+                         const std::vector<EndpointStats> &endpoints) {
+  if (endpoints.empty()) {
+    out << "No requests yet.\n";
+    return;
+  }
+  char line[96];
+  for (auto &stats : endpoints) {
+    std::snprintf(line, sizeof(line),
+                  "  %llu requests, %llu new connections, %.1f KB received",
+                  (unsigned long long)stats.requests,
+                  (unsigned long long)stats.new_connections,
+                  stats.response_bytes / 1024.0);
+    out << stats.endpoint << "\n" << line;
+    if (stats.transport_errors)
+      out << ", " << stats.transport_errors << " transport errors";
+    out << "\n";
+    if (!stats.statuses.empty()) {
+      out << "  status";
+      const char *separator = " ";
+      for (auto &status : stats.statuses) {
+        out << separator << status.first << " x" << status.second;
+        separator = ", ";
+      }
+      out << "\n";
+    }
+    out << "  phase        count      p50      p90      p99      max (ms)\n";
+    for (int p = 0; p < kRequestPhases; ++p) {
+      const LatencyHistogram &histogram = stats.phases[p];
+      if (histogram.count() == 0)
+        continue;
+      std::snprintf(line, sizeof(line), "  %-10s %7llu", kPhaseNames[p],
+                    (unsigned long long)histogram.count());
+      out << line;
+      append_ms(out, histogram.percentile(50));
+      append_ms(out, histogram.percentile(90));
+      append_ms(out, histogram.percentile(99));
+      append_ms(out, histogram.max());
+      out << "\n";
+    }
+  }
+}
+
+bool dump_request_stats(const std::string &path) {
+  std::ofstream out(path.c_str(), std::ios::trunc);
+  if (!out)
+    return false;
+  write_request_stats(out, request_stats().snapshot());
+  out.close();
+  return !out.fail();
+}
+
+void dump_request_stats_on_signal(const std::string &path) {
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGUSR1);
+  if (pthread_sigmask(SIG_BLOCK, &signals, NULL) != 0)
+    return;
+  std::thread([path, signals] {
+    int received = 0;
+    while (sigwait(&signals, &received) == 0)
+      dump_request_stats(path);
+  }).detach();
+}
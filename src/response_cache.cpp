@@ -0,0 +1,102 @@
+// src/response_cache.cpp
+#include "response_cache.h"
+
+ResponseCache::ResponseCache(size_t max_entries) : max_entries_(max_entries) {}
+
+std::shared_ptr<const rapidjson::Document>
+ResponseCache::find(const std::string &url, std::string &etag) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++stats_.lookups;
+  auto it = by_url_.find(url);
+  if (it == by_url_.end())
+    return std::shared_ptr<const rapidjson::Document>();
+  lru_.splice(lru_.begin(), lru_, it->second);
+  etag = it->second->etag;
+  return it->second->doc;
+}
+
+std::shared_ptr<const ItemPage>
+ResponseCache::find_items(const std::string &url, ItemView view,
+                          std::string &etag) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++stats_.lookups;
+  auto it = by_url_.find(url);
+  if (it == by_url_.end() || !it->second->items || it->second->view != view)
+    return std::shared_ptr<const ItemPage>();
+  lru_.splice(lru_.begin(), lru_, it->second);
+  etag = it->second->etag;
+  return it->second->items;
+}
+
+ResponseCache::Entry &ResponseCache::entry_for(const std::string &url,
+                                               const std::string &etag,
+                                               size_t body_bytes) {
+  ++stats_.stores;
+  auto it = by_url_.find(url);
+  if (it != by_url_.end()) {
+    if (it->second->etag == etag) {
+      lru_.splice(lru_.begin(), lru_, it->second);
+      return lru_.front();
+    }
+    lru_.erase(it->second);
+    by_url_.erase(it);
+  }
+  while (!lru_.empty() && lru_.size() >= max_entries_) {
+    by_url_.erase(lru_.back().url);
+    lru_.pop_back();
+  }
+  Entry entry;
+  entry.url = url;
+  entry.etag = etag;
+  entry.view = ItemView::PLAYLISTS;
+  entry.body_bytes = body_bytes;
+  lru_.push_front(entry);
+  by_url_[url] = lru_.begin();
+  return lru_.front();
+}
+
+void ResponseCache::store(const std::string &url, const std::string &etag,
+                          const rapidjson::Value &doc, size_t body_bytes) {
+  std::shared_ptr<rapidjson::Document> copy =
+      std::make_shared<rapidjson::Document>();
+  copy->CopyFrom(doc, copy->GetAllocator());
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  entry_for(url, etag, body_bytes).doc = copy;
+}
+
+void ResponseCache::store_items(const std::string &url,
+                                const std::string &etag, ItemView view,
+                                const ItemPage &page, size_t body_bytes) {
+  std::shared_ptr<const ItemPage> copy = std::make_shared<ItemPage>(page);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  Entry &entry = entry_for(url, etag, body_bytes);
+  entry.items = copy;
+  entry.view = view;
+}
+
+void ResponseCache::record_hit(const std::string &url) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++stats_.hits;
+  auto it = by_url_.find(url);
+  if (it != by_url_.end())
+    stats_.bytes_saved += it->second->body_bytes;
+}
+
+ResponseCacheStats ResponseCache::stats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void ResponseCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  lru_.clear();
+  by_url_.clear();
+  stats_ = ResponseCacheStats();
+}
+
+ResponseCache &response_cache() {
+  static ResponseCache cache;
+  return cache;
+}
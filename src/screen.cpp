@@ -0,0 +1,389 @@
+// src/screen.cpp
+#include "screen.h"
+#include <algorithm>
+#include <chrono>
+#include <clocale>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <wchar.h>
+
+namespace {
+
+// How long the rest of an escape sequence or UTF-8 glyph may trail its
+// first byte before the byte is taken on its own
+const int kEscapeWaitMs = 25;
+// Front buffer content that matches no cell, forcing a full redraw
+const uint32_t kUnknownGlyph = 0xFFFFFFFF;
+
+volatile std::sig_atomic_t window_resized = 0;
+
+void on_window_change(int) { window_resized = 1; }
+
+// Decodes the code point starting at s[i] and advances i past it; malformed
+// input decodes to U+FFFD one byte at a time
+uint32_t decode_utf8(const std::string &s, size_t &i) {
+  unsigned char lead = s[i++];
+  if (lead < 0x80)
+    return lead;
+  int length = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : -1;
+  if (length < 0 || i + length > s.size())
+    return 0xFFFD;
+  uint32_t cp = lead & (0x3F >> length);
+  for (int k = 0; k < length; ++k) {
+    unsigned char next = s[i + k];
+    if ((next & 0xC0) != 0x80)
+      return 0xFFFD;
+    cp = (cp << 6) | (next & 0x3F);
+  }
+  i += length;
+  return cp;
+}
+
+void append_utf8(std::string &out, uint32_t cp) {
+  if (cp < 0x80) {
+    out += static_cast<char>(cp);
+  } else if (cp < 0x800) {
+    out += static_cast<char>(0xC0 | (cp >> 6));
+    out += static_cast<char>(0x80 | (cp & 0x3F));
+  } else if (cp < 0x10000) {
+    out += static_cast<char>(0xE0 | (cp >> 12));
+    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (cp & 0x3F));
+  } else {
+    out += static_cast<char>(0xF0 | (cp >> 18));
+    out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (cp & 0x3F));
+  }
+}
+
+// Columns a glyph takes; combining marks take none and are dropped, since a
+// cell holds a single code point
+int glyph_width(uint32_t cp) {
+  if (cp < 0x80)
+    return 1;
+  int width = wcwidth(static_cast<wchar_t>(cp));
+  return width < 0 ? 1 : width;
+}
+
+void append_number(std::string &out, int value) {
+  char buffer[16];
+  std::snprintf(buffer, sizeof(buffer), "%d", value);
+  out += buffer;
+}
+
+void append_style(std::string &out, uint8_t style) {
+  out += "\033[0";
+  if (style & kStyleBold)
+    out += ";1";
+  if (style & kStyleDim)
+    out += ";2";
+  if (style & kStyleReverse)
+    out += ";7";
+  out += 'm';
+}
+
+} // namespace
+
+struct Screen::Terminal {
+  struct termios saved;
+  struct sigaction saved_winch;
+};
+
+Screen::Screen()
+    : rows_(0), cols_(0), started_(false), terminal_(new Terminal()) {}
+
+Screen::~Screen() { stop(); }
+
+bool Screen::available() {
+  const char *term = std::getenv("TERM");
+  return isatty(STDIN_FILENO) && isatty(STDOUT_FILENO) && term &&
+         std::strcmp(term, "dumb") != 0;
+}
+
+bool Screen::start() {
+  if (started_)
+    return true;
+  if (!available() || tcgetattr(STDIN_FILENO, &terminal_->saved) != 0)
+    return false;
+  // wcwidth() needs the user's character set
+  std::setlocale(LC_CTYPE, "");
+
+  struct termios raw = terminal_->saved;
+  raw.c_lflag &= ~(ICANON | ECHO);
+  raw.c_cc[VMIN] = 1;
+  raw.c_cc[VTIME] = 0;
+  tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+
+  // Without SA_RESTART so that a resize interrupts the wait for a key
+  struct sigaction winch;
+  std::memset(&winch, 0, sizeof(winch));
+  winch.sa_handler = on_window_change;
+  sigemptyset(&winch.sa_mask);
+  sigaction(SIGWINCH, &winch, &terminal_->saved_winch);
+  window_resized = 0;
+
+  int rows = 24;
+  int cols = 80;
+  terminal_size(rows, cols);
+  resize(rows, cols);
+  std::cout.flush();
+  write_out("\033[?1049h\033[?25l\033[2J");
+  started_ = true;
+  return true;
+}
+
+void Screen::stop() {
+  if (!started_)
+    return;
+  write_out("\033[0m\033[?25h\033[?1049l");
+  tcsetattr(STDIN_FILENO, TCSANOW, &terminal_->saved);
+  sigaction(SIGWINCH, &terminal_->saved_winch, NULL);
+  input_.clear();
+  started_ = false;
+}
+
+void Screen::resize(int rows, int cols) {
+  rows_ = rows > 0 ? rows : 0;
+  cols_ = cols > 0 ? cols : 0;
+  Cell blank = {' ', 0};
+  Cell unknown = {kUnknownGlyph, 0};
+  back_.assign(static_cast<size_t>(rows_) * cols_, blank);
+  front_.assign(back_.size(), unknown);
+}
+
+void Screen::clear() {
+  Cell blank = {' ', 0};
+  std::fill(back_.begin(), back_.end(), blank);
+}
+
+int Screen::draw_text(int row, int col, const std::string &utf8,
+                      uint8_t style, int width) {
+  if (row < 0 || row >= rows_ || col < 0 || col >= cols_)
+    return 0;
+  if (width < 0 || width > cols_ - col)
+    width = cols_ - col;
+  Cell *line = &back_[static_cast<size_t>(row) * cols_];
+  int used = 0;
+  size_t i = 0;
+  while (i < utf8.size()) {
+    uint32_t cp = decode_utf8(utf8, i);
+    // Tabs and newlines in names would move the cursor
+    if (cp < 0x20 || cp == 0x7F)
+      cp = '?';
+    int glyph = glyph_width(cp);
+    if (glyph == 0)
+      continue;
+    if (used + glyph > width)
+      break;
+    int at = col + used;
+    // Never leave half of a wide glyph behind
+    if (line[at].ch == 0 && at > 0)
+      line[at - 1].ch = ' ';
+    if (at + glyph < cols_ && line[at + glyph].ch == 0)
+      line[at + glyph].ch = ' ';
+    line[at].ch = cp;
+    line[at].style = style;
+    if (glyph == 2) {
+      line[at + 1].ch = 0;
+      line[at + 1].style = style;
+    }
+    used += glyph;
+  }
+  return used;
+}
+
+void Screen::fill(int row, int col, int width, uint8_t style) {
+  if (row < 0 || row >= rows_ || col < 0 || col >= cols_)
+    return;
+  if (width > cols_ - col)
+    width = cols_ - col;
+  Cell *line = &back_[static_cast<size_t>(row) * cols_];
+  if (col > 0 && line[col].ch == 0)
+    line[col - 1].ch = ' ';
+  if (col + width < cols_ && line[col + width].ch == 0)
+    line[col + width].ch = ' ';
+  for (int c = col; c < col + width; ++c) {
+    line[c].ch = ' ';
+    line[c].style = style;
+  }
+}
+
+void Screen::diff(std::string &out) {
+  size_t changed = 0;
+  int cursor_row = -1;
+  int cursor_col = -1;
+  int style = -1;
+  for (int r = 0; r < rows_; ++r) {
+    size_t base = static_cast<size_t>(r) * cols_;
+    for (int c = 0; c < cols_; ++c) {
+      const Cell &cell = back_[base + c];
+      if (!(cell != front_[base + c]))
+        continue;
+      front_[base + c] = cell;
+      // The right half of a wide glyph is drawn with its left half
+      if (cell.ch == 0)
+        continue;
+      if (r != cursor_row || c != cursor_col) {
+        out += "\033[";
+        append_number(out, r + 1);
+        out += ';';
+        append_number(out, c + 1);
+        out += 'H';
+      }
+      if (cell.style != style) {
+        append_style(out, cell.style);
+        style = cell.style;
+      }
+      append_utf8(out, cell.ch);
+      bool wide = c + 1 < cols_ && back_[base + c + 1].ch == 0;
+      cursor_row = r;
+      cursor_col = c + (wide ? 2 : 1);
+      ++changed;
+    }
+  }
+  if (style > 0)
+    out += "\033[0m";
+  stats_.cells_changed = changed;
+}
+
+void Screen::present() {
+  auto start = std::chrono::steady_clock::now();
+  out_.clear();
+  diff(out_);
+  if (started_ && !out_.empty())
+    write_out(out_);
+  double ms = std::chrono::duration<double, std::milli>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+  stats_.last_ms = ms;
+  if (ms > stats_.max_ms)
+    stats_.max_ms = ms;
+  if (ms > kFrameBudgetMs)
+    ++stats_.over_budget;
+  ++stats_.frames;
+  stats_.bytes_written = out_.size();
+}
+
+KeyEvent Screen::read_key(int timeout_ms) {
+  if (input_.empty() && !window_resized)
+    fill_input(timeout_ms);
+  if (window_resized) {
+    window_resized = 0;
+    int rows = rows_;
+    int cols = cols_;
+    if (terminal_size(rows, cols)) {
+      resize(rows, cols);
+      if (started_)
+        write_out("\033[2J");
+    }
+    return KeyEvent(Key::RESIZE);
+  }
+  if (input_.empty())
+    return KeyEvent(Key::NONE);
+
+  unsigned char first = input_[0];
+  if (first == 0x1B)
+    return parse_escape();
+  if (first == '\r' || first == '\n') {
+    input_.erase(0, 1);
+    return KeyEvent(Key::ENTER);
+  }
+  if (first == 0x7F || first == 0x08) {
+    input_.erase(0, 1);
+    return KeyEvent(Key::BACKSPACE);
+  }
+  // Wait for the rest of a multi-byte glyph
+  size_t length = first >= 0xF0 ? 4 : first >= 0xE0 ? 3 : first >= 0xC0 ? 2 : 1;
+  if (input_.size() < length)
+    fill_input(kEscapeWaitMs);
+  size_t i = 0;
+  uint32_t cp = decode_utf8(input_, i);
+  input_.erase(0, i);
+  if (cp < 0x20)
+    return KeyEvent(Key::NONE);
+  return KeyEvent(Key::CHAR, cp);
+}
+
+// Decodes the escape sequence at the front of the input: the cursor and
+// paging keys in their CSI and SS3 forms. A lone ESC is the Escape key;
+// sequences for other keys are consumed and reported as NONE.
+KeyEvent Screen::parse_escape() {
+  if (input_.size() < 2)
+    fill_input(kEscapeWaitMs);
+  if (input_.size() < 2 || (input_[1] != '[' && input_[1] != 'O')) {
+    input_.erase(0, 1);
+    return KeyEvent(Key::ESCAPE);
+  }
+  size_t end = 2;
+  while (true) {
+    while (end < input_.size() &&
+           (input_[end] < 0x40 || input_[end] > 0x7E))
+      ++end;
+    if (end < input_.size() || !fill_input(kEscapeWaitMs))
+      break;
+  }
+  if (end >= input_.size()) {
+    input_.clear();
+    return KeyEvent(Key::NONE);
+  }
+  std::string body = input_.substr(2, end - 1);
+  input_.erase(0, end + 1);
+  if (body == "A")
+    return KeyEvent(Key::UP);
+  if (body == "B")
+    return KeyEvent(Key::DOWN);
+  if (body == "H" || body == "1~" || body == "7~")
+    return KeyEvent(Key::HOME);
+  if (body == "F" || body == "4~" || body == "8~")
+    return KeyEvent(Key::END);
+  if (body == "5~")
+    return KeyEvent(Key::PAGE_UP);
+  if (body == "6~")
+    return KeyEvent(Key::PAGE_DOWN);
+  return KeyEvent(Key::NONE);
+}
+
+// Waits up to timeout_ms for terminal input and appends what arrived
+bool Screen::fill_input(int timeout_ms) {
+  struct pollfd fd;
+  fd.fd = STDIN_FILENO;
+  fd.events = POLLIN;
+  fd.revents = 0;
+  if (poll(&fd, 1, timeout_ms) <= 0)
+    return false;
+  char buffer[256];
+  ssize_t n = read(STDIN_FILENO, buffer, sizeof(buffer));
+  if (n <= 0)
+    return false;
+  input_.append(buffer, n);
+  return true;
+}
+
+bool Screen::terminal_size(int &rows, int &cols) const {
+  struct winsize size;
+  if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) != 0 || size.ws_row == 0 ||
+      size.ws_col == 0)
+    return false;
+  rows = size.ws_row;
+  cols = size.ws_col;
+  return true;
+}
+
+void Screen::write_out(const std::string &out) {
+  size_t written = 0;
+  while (written < out.size()) {
+    ssize_t n = write(STDOUT_FILENO, out.data() + written,
+                      out.size() - written);
+    if (n <= 0)
+      break;
+    written += n;
+  }
+}
@@ -0,0 +1,242 @@
+// src/search_index.cpp
+#include "search_index.h"
+#include <algorithm>
+#include <cctype>
+
+namespace {
+
+// Share of the query's trigrams a candidate must contain
+const double kMinOverlap = 0.5;
+
+uint32_t trigram(const std::string &s, size_t i) {
+  return static_cast<uint32_t>(static_cast<unsigned char>(s[i])) << 16 |
+         static_cast<uint32_t>(static_cast<unsigned char>(s[i + 1])) << 8 |
+         static_cast<uint32_t>(static_cast<unsigned char>(s[i + 2]));
+}
+
+// Distinct trigrams of " " + folded, plus the closing " " for entries. The
+// leading space anchors word starts; queries leave the end open so that the
+// last word matches as a prefix.
+std::vector<uint32_t> trigrams(const std::string &folded, bool closed) {
+  std::string padded = " " + folded;
+  if (closed)
+    padded += " ";
+  std::vector<uint32_t> grams;
+  for (size_t i = 0; i + 3 <= padded.size(); ++i)
+    grams.push_back(trigram(padded, i));
+  std::sort(grams.begin(), grams.end());
+  grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+  return grams;
+}
+
+std::string entry_key(LocalKind kind, const std::string &name,
+                      const std::string &uri) {
+  std::string key(1, static_cast<char>('0' + static_cast<int>(kind)));
+  return key + ":" + (uri.empty() ? fold_for_search(name) : uri);
+}
+
+// Ranks whole, leading and word-prefix matches above trigram overlap alone
+int rank(const std::string &folded, const std::string &query, size_t matched,
+         size_t grams) {
+  int score = static_cast<int>(matched * 100 / grams);
+  size_t at = folded.find(query);
+  if (at == std::string::npos)
+    return score;
+  if (at == 0)
+    return score + (folded.size() == query.size() ? 300 : 200);
+  while (at != std::string::npos) {
+    if (folded[at - 1] == ' ')
+      return score + 150;
+    at = folded.find(query, at + 1);
+  }
+  return score + 100;
+}
+
+} // namespace
+
+std::string fold_for_search(const std::string &text) {
+  std::string folded;
+  folded.reserve(text.size());
+  bool space = true;
+  for (unsigned char c : text) {
+    if (c >= 0x80 || std::isalnum(c)) {
+      folded += static_cast<char>(c < 0x80 ? std::tolower(c) : c);
+      space = false;
+    } else if (!space) {
+      folded += ' ';
+      space = true;
+    }
+  }
+  if (!folded.empty() && folded.back() == ' ')
+    folded.pop_back();
+  return folded;
+}
+
+void SearchIndex::add(LocalKind kind, const std::string &name,
+                      const std::string &uri) {
+  if (name.empty())
+    return;
+  std::string key = entry_key(kind, name, uri);
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (by_key_.count(key))
+    return;
+  uint32_t id = static_cast<uint32_t>(entries_.size());
+  Entry entry;
+  entry.name = name;
+  entry.uri = uri;
+  entry.folded = fold_for_search(name);
+  entry.kind = kind;
+  for (uint32_t gram : trigrams(entry.folded, true))
+    postings_[gram].push_back(id);
+  entries_.push_back(std::move(entry));
+  by_key_[key] = id;
+}
+
+std::vector<LocalHit> SearchIndex::search(const std::string &query,
+                                          size_t limit) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return search_locked(query, nullptr, limit);
+}
+
+std::vector<LocalHit> SearchIndex::search(const std::string &query,
+                                          LocalKind kind, size_t limit) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return search_locked(query, &kind, limit);
+}
+
+std::vector<LocalHit> SearchIndex::search_locked(const std::string &query,
+                                                 const LocalKind *kind,
+                                                 size_t limit) {
+  std::vector<LocalHit> hits;
+  std::string folded = fold_for_search(query);
+  if (folded.empty() || limit == 0)
+    return hits;
+
+  std::vector<std::pair<int, uint32_t>> scored;
+  auto accept = [&](uint32_t id, size_t matched, size_t grams) {
+    if (kind && entries_[id].kind != *kind)
+      return;
+    scored.emplace_back(rank(entries_[id].folded, folded, matched, grams), id);
+  };
+
+  std::vector<uint32_t> grams = trigrams(folded, false);
+  if (grams.empty()) {
+    // A single character has no trigram; match it against word starts
+    for (uint32_t id = 0; id < entries_.size(); ++id) {
+      const std::string &name = entries_[id].folded;
+      if (name.compare(0, folded.size(), folded) == 0 ||
+          name.find(" " + folded) != std::string::npos)
+        accept(id, 1, 1);
+    }
+  } else {
+    std::vector<const std::vector<uint32_t> *> lists;
+    for (uint32_t gram : grams) {
+      auto postings = postings_.find(gram);
+      if (postings != postings_.end())
+        lists.push_back(&postings->second);
+    }
+    std::sort(lists.begin(), lists.end(),
+              [](const std::vector<uint32_t> *a,
+                 const std::vector<uint32_t> *b) {
+                return a->size() < b->size();
+              });
+    size_t needed = std::max<size_t>(
+        1, static_cast<size_t>(grams.size() * kMinOverlap + 0.5));
+    if (lists.size() < needed)
+      return hits;
+
+    // An entry sharing `needed` trigrams appears in at least one of the
+    // rarest lists.size() - needed + 1 lists, so only those seed candidates.
+    // The remaining lists are walked when short and probed per candidate
+    // with a binary search when long.
+    counts_.resize(entries_.size());
+    size_t seeds = lists.size() - needed + 1;
+    for (size_t i = 0; i < seeds; ++i) {
+      for (uint32_t id : *lists[i]) {
+        if (counts_[id]++ == 0)
+          touched_.push_back(id);
+      }
+    }
+    for (size_t i = seeds; i < lists.size(); ++i) {
+      const std::vector<uint32_t> &list = *lists[i];
+      if (list.size() < touched_.size() * 16) {
+        for (uint32_t id : list) {
+          if (counts_[id] > 0)
+            ++counts_[id];
+        }
+      } else {
+        for (uint32_t id : touched_) {
+          if (std::binary_search(list.begin(), list.end(), id))
+            ++counts_[id];
+        }
+      }
+    }
+    for (uint32_t id : touched_) {
+      if (counts_[id] >= needed)
+        accept(id, counts_[id], grams.size());
+      counts_[id] = 0;
+    }
+    touched_.clear();
+  }
+
+  auto better = [this](const std::pair<int, uint32_t> &a,
+                       const std::pair<int, uint32_t> &b) {
+    if (a.first != b.first)
+      return a.first > b.first;
+    size_t a_size = entries_[a.second].folded.size();
+    size_t b_size = entries_[b.second].folded.size();
+    if (a_size != b_size)
+      return a_size < b_size;
+    return a.second < b.second;
+  };
+  size_t kept = std::min(limit, scored.size());
+  std::partial_sort(scored.begin(), scored.begin() + kept, scored.end(),
+                    better);
+  for (size_t i = 0; i < kept; ++i) {
+    const Entry &entry = entries_[scored[i].second];
+    hits.push_back(
+        LocalHit{entry.name, entry.uri, entry.kind, scored[i].first});
+  }
+  return hits;
+}
+
+size_t SearchIndex::size() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+void SearchIndex::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+  by_key_.clear();
+  postings_.clear();
+}
+
+SearchIndex &search_index() {
+  static SearchIndex index;
+  return index;
+}
+
+void index_item_page(ItemView view, const ItemPage &page) {
+  SearchIndex &index = search_index();
+  for (auto &item : page.items) {
+    switch (view) {
+    case ItemView::PLAYLISTS:
+      index.add(LocalKind::PLAYLIST, item.name,
+                "spotify:playlist:" + item.key);
+      break;
+    case ItemView::SEARCH_ARTISTS:
+      index.add(LocalKind::ARTIST, item.name, item.key);
+      break;
+    case ItemView::SEARCH_ALBUMS:
+      index.add(LocalKind::ALBUM, item.name, item.key);
+      break;
+    case ItemView::SEARCH_PLAYLISTS:
+      index.add(LocalKind::PLAYLIST, item.name, item.key);
+      break;
+    default:
+      index.add(LocalKind::TRACK, item.name, item.key);
+      break;
+    }
+  }
+}
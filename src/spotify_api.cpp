@@ -0,0 +1,426 @@
+// src/spotify_api.cpp
+#include "spotify_api.h"
+#include "http_client.h"
+#include "request_stats.h"
+#include "response_cache.h"
+#include "search_index.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+
+namespace {
+
+const char *const kDefaultApiBase = "https://api.spotify.com/v1";
+const char *const kDefaultAccountsBase = "https://accounts.spotify.com";
+// Client-side budget for the real Web API, kept under its rolling limit so
+// that bulk operations are paced instead of answered with 429s
+const double kDefaultRequestsPerSecond = 25;
+
+struct Endpoints {
+  std::string api_base;
+  std::string accounts_base;
+
+  Endpoints() {
+    const char *root = std::getenv("SPOTIFY_TUI_ENDPOINT");
+    set_root(root ? root : "");
+  }
+
+  // A local stand-in gets no budget unless SPOTIFY_TUI_RATE_LIMIT (requests
+  // per second, 0 for none) asks for one
+  void set_root(const std::string &root) {
+    double rate = kDefaultRequestsPerSecond;
+    if (root.empty()) {
+      api_base = kDefaultApiBase;
+      accounts_base = kDefaultAccountsBase;
+    } else {
+      accounts_base = root;
+      while (!accounts_base.empty() && accounts_base.back() == '/')
+        accounts_base.pop_back();
+      api_base = accounts_base + "/v1";
+      rate = 0;
+    }
+    const char *limit = std::getenv("SPOTIFY_TUI_RATE_LIMIT");
+    if (limit)
+      rate = std::atof(limit);
+    http_set_rate_limit(rate, 2 * rate);
+  }
+};
+
+Endpoints &endpoints() {
+  static Endpoints instance;
+  return instance;
+}
+
+// Header lists of the most recent access token, rebuilt when it changes, so
+// that requests share them instead of building their own
+struct AuthHeaders {
+  std::mutex mutex;
+  std::string token;
+  std::shared_ptr<const HttpHeaderList> plain;
+  std::shared_ptr<const HttpHeaderList> json;
+};
+
+AuthHeaders &auth_headers() {
+  static AuthHeaders instance;
+  return instance;
+}
+
+HttpRequest authorized_request(const std::string &access_token,
+                               const std::string &method,
+                               const std::string &url, bool json = false) {
+  HttpRequest request;
+  request.method = method;
+  request.url = url;
+  request.shared_headers = spotify_auth_headers(access_token, json);
+  return request;
+}
+
+bool succeeded(const HttpResponse &response) {
+  return response.transport_ok && response.status >= 200 &&
+         response.status < 300;
+}
+
+HttpRequest json_request(const std::string &access_token,
+                         const std::string &method, const std::string &url,
+                         const std::string &json_body) {
+  HttpRequest request = authorized_request(access_token, method, url, true);
+  request.body = json_body;
+  return request;
+}
+
+// Runs requests on the async engine with at most concurrency in flight and
+// reports a 2xx status per request
+std::vector<bool> send_batch(const std::vector<HttpRequest> &requests,
+                             int concurrency) {
+  struct BatchState {
+    std::mutex mutex;
+    std::condition_variable finished;
+    int in_flight = 0;
+    std::vector<bool> results;
+  };
+  std::shared_ptr<BatchState> state = std::make_shared<BatchState>();
+  state->results.assign(requests.size(), false);
+  if (concurrency < 1)
+    concurrency = 1;
+
+  for (size_t i = 0; i < requests.size(); ++i) {
+    {
+      std::unique_lock<std::mutex> lock(state->mutex);
+      state->finished.wait(lock, [&state, concurrency] {
+        return state->in_flight < concurrency;
+      });
+      ++state->in_flight;
+    }
+    http_perform_async(requests[i], [state, i](HttpResponse &response) {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      state->results[i] = succeeded(response);
+      --state->in_flight;
+      state->finished.notify_all();
+    });
+  }
+
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->finished.wait(lock, [&state] { return state->in_flight == 0; });
+  return state->results;
+}
+
+// Makes the GET conditional when a cached copy of url exists
+HttpRequest
+conditional_get(const std::string &access_token, const std::string &url,
+                std::shared_ptr<const rapidjson::Document> &cached) {
+  HttpRequest request = authorized_request(access_token, "GET", url);
+  std::string etag;
+  cached = response_cache().find(url, etag);
+  if (cached)
+    request.headers.push_back("If-None-Match: " + etag);
+  return request;
+}
+
+// Same as conditional_get for the items of a list view
+HttpRequest conditional_items_get(const std::string &access_token,
+                                  const std::string &url, ItemView view,
+                                  std::shared_ptr<const ItemPage> &cached) {
+  HttpRequest request = authorized_request(access_token, "GET", url);
+  std::string etag;
+  cached = response_cache().find_items(url, view, etag);
+  if (cached)
+    request.headers.push_back("If-None-Match: " + etag);
+  return request;
+}
+
+// Records the time spent parsing a response to a GET of url
+void record_parse_time(const std::string &url,
+                       std::chrono::steady_clock::time_point started) {
+  std::chrono::steady_clock::duration elapsed =
+      std::chrono::steady_clock::now() - started;
+  request_stats().record_parse(
+      "GET", url,
+      std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+}
+
+// Extracts a list view's items from a GET response to url, answering a 304
+// from the cached items and caching fresh responses that carry an ETag
+bool extract_response_items(const std::string &url,
+                            const std::shared_ptr<const ItemPage> &cached,
+                            const HttpResponse &response, ItemView view,
+                            ItemPage &page) {
+  if (response.transport_ok && response.status == 304 && cached) {
+    page.items.insert(page.items.end(), cached->items.begin(),
+                      cached->items.end());
+    page.total = cached->total;
+    page.bytes = response.body.size();
+    response_cache().record_hit(url);
+    return true;
+  }
+  if (!succeeded(response))
+    return false;
+  std::chrono::steady_clock::time_point started =
+      std::chrono::steady_clock::now();
+  bool ok = extract_items(response.body.c_str(), view, page);
+  page.bytes = response.body.size();
+  record_parse_time(url, started);
+  if (!ok)
+    return false;
+  std::string etag = response.header("etag");
+  if (response.status == 200 && !etag.empty())
+    response_cache().store_items(url, etag, view, page, response.body.size());
+  return true;
+}
+
+// Fills doc from a GET response, answering a 304 from the cached copy and
+// caching fresh responses that carry an ETag
+template <typename Doc>
+bool parse_get_response(
+    const std::string &url,
+    const std::shared_ptr<const rapidjson::Document> &cached,
+    const HttpResponse &response, Doc &doc) {
+  if (!response.transport_ok)
+    return false;
+  if (response.status == 304 && cached) {
+    doc.CopyFrom(*cached, doc.GetAllocator());
+    response_cache().record_hit(url);
+    return true;
+  }
+  if (!succeeded(response))
+    return false;
+  // No Content, such as me/player with nothing playing
+  if (response.status == 204) {
+    doc.SetNull();
+    return true;
+  }
+  std::chrono::steady_clock::time_point started =
+      std::chrono::steady_clock::now();
+  bool parsed = !doc.Parse(response.body.c_str()).HasParseError();
+  record_parse_time(url, started);
+  if (!parsed)
+    return false;
+  std::string etag = response.header("etag");
+  if (response.status == 200 && !etag.empty())
+    response_cache().store(url, etag, doc, response.body.size());
+  return true;
+}
+
+} // namespace
+
+std::shared_ptr<const HttpHeaderList>
+spotify_auth_headers(const std::string &access_token, bool json) {
+  AuthHeaders &cache = auth_headers();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  if (!cache.plain || cache.token != access_token) {
+    std::string authorization = "Authorization: Bearer " + access_token;
+    cache.token = access_token;
+    cache.plain = std::make_shared<HttpHeaderList>(
+        std::vector<std::string>{authorization});
+    cache.json = std::make_shared<HttpHeaderList>(std::vector<std::string>{
+        authorization, "Content-Type: application/json"});
+  }
+  return json ? cache.json : cache.plain;
+}
+
+std::string spotify_api_url(const std::string &path) {
+  return endpoints().api_base + path;
+}
+
+std::string spotify_accounts_url(const std::string &path) {
+  return endpoints().accounts_base + path;
+}
+
+std::string spotify_id_from_uri(const std::string &uri) {
+  size_t colon = uri.rfind(':');
+  return colon == std::string::npos ? uri : uri.substr(colon + 1);
+}
+
+std::string spotify_failure_message(const HttpResponse &response) {
+  if (!response.transport_ok)
+    return response.error;
+  std::string description = "HTTP " + std::to_string(response.status);
+  rapidjson::Document doc;
+  if (!doc.Parse(response.body.c_str()).HasParseError() && doc.IsObject() &&
+      doc.HasMember("error") && doc["error"].IsObject() &&
+      doc["error"].HasMember("message") && doc["error"]["message"].IsString())
+    description += std::string(": ") + doc["error"]["message"].GetString();
+  return description;
+}
+
+void set_spotify_endpoint_root(const std::string &root) {
+  endpoints().set_root(root);
+}
+
+bool spotify_get_json(const std::string &access_token, const std::string &url,
+                      rapidjson::Document &doc) {
+  std::shared_ptr<const rapidjson::Document> cached;
+  HttpResponse response;
+  http_perform(conditional_get(access_token, url, cached), response);
+  return parse_get_response(url, cached, response, doc);
+}
+
+void spotify_get_json_async(const std::string &access_token,
+                            const std::string &url, JsonCallback callback) {
+  std::shared_ptr<const rapidjson::Document> cached;
+  HttpRequest request = conditional_get(access_token, url, cached);
+  http_perform_async(request, [url, cached, callback](HttpResponse &response) {
+    rapidjson::Document doc;
+    bool ok = parse_get_response(url, cached, response, doc);
+    callback(ok, doc);
+  });
+}
+
+std::future<bool> spotify_get_json_async(const std::string &access_token,
+                                         const std::string &url,
+                                         rapidjson::Document &doc) {
+  std::shared_ptr<std::promise<bool>> promise =
+      std::make_shared<std::promise<bool>>();
+  rapidjson::Document *target = &doc;
+  spotify_get_json_async(access_token, url,
+                         [promise, target](bool ok, rapidjson::Document &doc) {
+                           if (ok)
+                             target->Swap(doc);
+                           promise->set_value(ok);
+                         });
+  return promise->get_future();
+}
+
+bool spotify_get_pooled_json(const std::string &access_token,
+                             const std::string &url, DocumentLease &doc) {
+  if (!doc)
+    doc = document_pool().acquire();
+  std::shared_ptr<const rapidjson::Document> cached;
+  HttpResponse response;
+  http_perform(conditional_get(access_token, url, cached), response);
+  return parse_get_response(url, cached, response, *doc);
+}
+
+void spotify_get_pooled_json_async(const std::string &access_token,
+                                   const std::string &url,
+                                   PooledJsonCallback callback) {
+  std::shared_ptr<const rapidjson::Document> cached;
+  HttpRequest request = conditional_get(access_token, url, cached);
+  http_perform_async(request, [url, cached, callback](HttpResponse &response) {
+    DocumentLease doc = document_pool().acquire();
+    bool ok = parse_get_response(url, cached, response, *doc);
+    callback(ok, doc);
+  });
+}
+
+bool spotify_get_items(const std::string &access_token, const std::string &url,
+                       ItemView view, ItemPage &page) {
+  std::shared_ptr<const ItemPage> cached;
+  HttpResponse response;
+  http_perform(conditional_items_get(access_token, url, view, cached),
+               response);
+  if (!extract_response_items(url, cached, response, view, page))
+    return false;
+  index_item_page(view, page);
+  return true;
+}
+
+HttpRequestId spotify_get_items_async(const std::string &access_token,
+                                      const std::string &url, ItemView view,
+                                      ItemsCallback callback) {
+  std::shared_ptr<const ItemPage> cached;
+  HttpRequest request = conditional_items_get(access_token, url, view, cached);
+  return http_perform_async(
+      request, [url, cached, view, callback](HttpResponse &response) {
+        ItemPage page;
+        bool ok = extract_response_items(url, cached, response, view, page);
+        if (ok)
+          index_item_page(view, page);
+        callback(ok, page);
+      });
+}
+
+std::future<bool> spotify_get_items_async(const std::string &access_token,
+                                          const std::string &url,
+                                          ItemView view, ItemPage &page) {
+  std::shared_ptr<std::promise<bool>> promise =
+      std::make_shared<std::promise<bool>>();
+  ItemPage *target = &page;
+  spotify_get_items_async(access_token, url, view,
+                          [promise, target](bool ok, ItemPage &page) {
+                            if (ok)
+                              std::swap(*target, page);
+                            promise->set_value(ok);
+                          });
+  return promise->get_future();
+}
+
+bool spotify_send(const std::string &access_token, const std::string &method,
+                  const std::string &url) {
+  HttpResponse response;
+  http_perform(authorized_request(access_token, method, url), response);
+  return succeeded(response);
+}
+
+bool spotify_send_json(const std::string &access_token,
+                       const std::string &method, const std::string &url,
+                       const std::string &json_body, std::string *error) {
+  HttpResponse response;
+  http_perform(json_request(access_token, method, url, json_body), response);
+  bool ok = succeeded(response);
+  if (!ok && error)
+    *error = spotify_failure_message(response);
+  return ok;
+}
+
+void spotify_send_async(const std::string &access_token,
+                        const std::string &method, const std::string &url,
+                        SendCallback callback) {
+  http_perform_async(authorized_request(access_token, method, url),
+                     [callback](HttpResponse &response) {
+                       callback(succeeded(response), response);
+                     });
+}
+
+void spotify_send_json_async(const std::string &access_token,
+                             const std::string &method,
+                             const std::string &url,
+                             const std::string &json_body,
+                             SendCallback callback) {
+  http_perform_async(json_request(access_token, method, url, json_body),
+                     [callback](HttpResponse &response) {
+                       callback(succeeded(response), response);
+                     });
+}
+
+std::vector<bool>
+spotify_send_json_batch(const std::string &access_token,
+                        const std::string &method, const std::string &url,
+                        const std::vector<std::string> &bodies,
+                        int concurrency) {
+  std::vector<HttpRequest> requests;
+  for (auto &body : bodies)
+    requests.push_back(json_request(access_token, method, url, body));
+  return send_batch(requests, concurrency);
+}
+
+std::vector<bool> spotify_send_batch(const std::string &access_token,
+                                     const std::string &method,
+                                     const std::vector<std::string> &urls,
+                                     int concurrency) {
+  std::vector<HttpRequest> requests;
+  for (auto &url : urls)
+    requests.push_back(authorized_request(access_token, method, url));
+  return send_batch(requests, concurrency);
+}
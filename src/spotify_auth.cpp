@@ -1,21 +1,99 @@
 // src/spotify_auth.cpp
 #include "spotify_auth.h"
 #include "base64/base64.h"
+#include "http_client.h"
+#include "spotify_api.h"
 #include "rapidjson/document.h"
 #include "utils.h"
-#include <curl/curl.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
 #include <iostream>
 #include <map>
 #include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
 
-size_t WriteCallbackAuth(void *contents, size_t size, size_t nmemb,
-                         void *userp) {
-  size_t totalSize = size * nmemb;
-  std::string *response = static_cast<std::string *>(userp);
-  response->append(static_cast<char *>(contents), totalSize);
-  return totalSize;
+namespace {
+
+const char *const kSessionHeader = "#spotify-tui session 1";
+const char *const kRedirectUri = "http://localhost:5000/callback";
+
+// Tokens are refreshed this long before they actually expire
+const std::time_t kExpiryMargin = 60;
+
+SpotifySession &current_session() {
+  static SpotifySession session;
+  return session;
+}
+
+// POSTs a grant to the token endpoint and stores the tokens it returns
+bool request_token(SpotifySession &session, const std::string &post_fields) {
+  std::string credentials = session.client_id + ":" + session.client_secret;
+  std::string encoded_credentials = base64_encode(
+      reinterpret_cast<const unsigned char *>(credentials.c_str()),
+      credentials.length());
+
+  HttpRequest request;
+  request.method = "POST";
+  request.url = spotify_accounts_url("/api/token");
+  request.headers.push_back("Content-Type: application/x-www-form-urlencoded");
+  request.headers.push_back("Authorization: Basic " + encoded_credentials);
+  request.body = post_fields;
+
+  HttpResponse response;
+  if (!http_perform(request, response) || response.status != 200)
+    return false;
+
+  rapidjson::Document doc;
+  if (doc.Parse(response.body.c_str()).HasParseError() || !doc.IsObject())
+    return false;
+  if (!doc.HasMember("access_token") || !doc["access_token"].IsString())
+    return false;
+
+  session.access_token = doc["access_token"].GetString();
+  if (doc.HasMember("refresh_token") && doc["refresh_token"].IsString())
+    session.refresh_token = doc["refresh_token"].GetString();
+  session.expires_at = 0;
+  if (doc.HasMember("expires_in") && doc["expires_in"].IsInt())
+    session.expires_at = std::time(nullptr) + doc["expires_in"].GetInt();
+  return true;
+}
+
+bool expiring(const SpotifySession &session) {
+  return session.expires_at == 0 ||
+         session.expires_at - kExpiryMargin <= std::time(nullptr);
+}
+
+// Runs the authorization code flow, prompting for credentials and the code
+bool authorize_interactively(SpotifySession &session) {
+  session = SpotifySession();
+  session.client_id = get_input("Enter your Spotify Client ID: ");
+  session.client_secret = get_input("Enter your Spotify Client Secret: ");
+
+  std::string auth_url =
+      spotify_accounts_url("/authorize?response_type=code&client_id=") +
+      url_encode(session.client_id) +
+      "&scope=playlist-modify-public%20playlist-modify-private%20user-read-"
+      "playback-state%20user-modify-playback-state&redirect_uri=" +
+      url_encode(kRedirectUri);
+
+  std::cout
+      << "\nPlease open the following URL in your browser to authorize the "
+         "application:\n"
+      << auth_url
+      << "\n\nAfter authorization, you will be redirected to a URL.\n"
+      << "Please copy the 'code' parameter from that URL and paste it below.\n";
+
+  std::string auth_code = get_input("Enter the authorization code: ");
+  return request_token(session, "grant_type=authorization_code&code=" +
+                                    url_encode(auth_code) + "&redirect_uri=" +
+                                    url_encode(kRedirectUri));
 }
 
+} // namespace
+
 bool parse_query(const std::string &query,
                  std::map<std::string, std::string> &params) {
   std::stringstream ss(query);
@@ -31,69 +109,115 @@ bool parse_query(const std::string &query,
   return true;
 }
 
-bool authenticate(std::string &access_token) {
-  std::string client_id = get_input("Enter your Spotify Client ID: ");
-  std::string client_secret = get_input("Enter your Spotify Client Secret: ");
-  std::string redirect_uri = "http://localhost:5000/callback";
+std::string session_path() { return config_directory() + "/session"; }
 
-  std::string auth_url =
-      "https://accounts.spotify.com/authorize?response_type=code&client_id=" +
-      url_encode(client_id) +
-      "&scope=playlist-modify-public%20playlist-modify-private%20user-read-"
-      "playback-state%20user-modify-playback-state&redirect_uri=" +
-      url_encode(redirect_uri);
+bool load_session(const std::string &path, SpotifySession &session) {
+  struct stat info;
+  if (stat(path.c_str(), &info) != 0)
+    return false;
+  if (info.st_mode & (S_IRWXG | S_IRWXO)) {
+    std::cerr << "Ignoring " << path
+              << ": it is accessible by other users.\n";
+    return false;
+  }
 
-  std::cout
-      << "\nPlease open the following URL in your browser to authorize the "
-         "application:\n"
-      << auth_url
-      << "\n\nAfter authorization, you will be redirected to a URL.\n"
-      << "Please copy the 'code' parameter from that URL and paste it below.\n";
+  std::ifstream in(path);
+  std::string line;
+  if (!std::getline(in, line) || line != kSessionHeader)
+    return false;
+  std::map<std::string, std::string> fields;
+  while (std::getline(in, line)) {
+    size_t eq = line.find('=');
+    if (eq != std::string::npos)
+      fields[line.substr(0, eq)] = line.substr(eq + 1);
+  }
 
-  std::string auth_code = get_input("Enter the authorization code: ");
+  SpotifySession loaded;
+  loaded.client_id = fields["client_id"];
+  loaded.client_secret = fields["client_secret"];
+  loaded.access_token = fields["access_token"];
+  loaded.refresh_token = fields["refresh_token"];
+  loaded.expires_at =
+      static_cast<std::time_t>(std::atoll(fields["expires_at"].c_str()));
+  if (loaded.client_id.empty() || loaded.refresh_token.empty())
+    return false;
+  session = loaded;
+  return true;
+}
 
-  std::string token_url = "https://accounts.spotify.com/api/token";
-  std::string post_fields =
-      "grant_type=authorization_code&code=" + url_encode(auth_code) +
-      "&redirect_uri=" + url_encode(redirect_uri);
+// Creates the temporary file with mode 0600 before anything is written to it,
+// then renames it over the old session
+bool save_session(const std::string &path, const SpotifySession &session) {
+  std::string tmp_path = path + ".tmp";
+  int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  if (fd < 0)
+    return false;
+  fchmod(fd, 0600);
 
-  std::string credentials = client_id + ":" + client_secret;
-  std::string encoded_credentials = base64_encode(
-      reinterpret_cast<const unsigned char *>(credentials.c_str()),
-      credentials.length());
+  std::ostringstream out;
+  out << kSessionHeader << "\n"
+      << "client_id=" << session.client_id << "\n"
+      << "client_secret=" << session.client_secret << "\n"
+      << "access_token=" << session.access_token << "\n"
+      << "refresh_token=" << session.refresh_token << "\n"
+      << "expires_at=" << static_cast<long long>(session.expires_at) << "\n";
+  std::string contents = out.str();
+  bool written = write(fd, contents.data(), contents.size()) ==
+                 static_cast<ssize_t>(contents.size());
+  written = fsync(fd) == 0 && written;
+  close(fd);
+  if (!written) {
+    std::remove(tmp_path.c_str());
+    return false;
+  }
+  return std::rename(tmp_path.c_str(), path.c_str()) == 0;
+}
 
-  CURL *curl_token = curl_easy_init();
-  if (curl_token) {
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(
-        headers, "Content-Type: application/x-www-form-urlencoded");
-    headers = curl_slist_append(
-        headers, ("Authorization: Basic " + encoded_credentials).c_str());
-
-    std::string response;
-    curl_easy_setopt(curl_token, CURLOPT_URL, token_url.c_str());
-    curl_easy_setopt(curl_token, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl_token, CURLOPT_POSTFIELDS, post_fields.c_str());
-    curl_easy_setopt(curl_token, CURLOPT_WRITEFUNCTION, WriteCallbackAuth);
-    curl_easy_setopt(curl_token, CURLOPT_WRITEDATA, &response);
-
-    CURLcode res = curl_easy_perform(curl_token);
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl_token);
-
-    if (res != CURLE_OK) {
-      return false;
-    }
+bool refresh_session(SpotifySession &session) {
+  if (session.refresh_token.empty())
+    return false;
+  return request_token(session, "grant_type=refresh_token&refresh_token=" +
+                                    url_encode(session.refresh_token));
+}
 
-    rapidjson::Document doc;
-    if (doc.Parse(response.c_str()).HasParseError()) {
-      return false;
-    }
+bool resume_session(const std::string &path, SpotifySession &session) {
+  if (!load_session(path, session))
+    return false;
+  if (!expiring(session))
+    return true;
+  if (!refresh_session(session))
+    return false;
+  save_session(path, session);
+  return true;
+}
 
-    if (doc.HasMember("access_token") && doc["access_token"].IsString()) {
-      access_token = doc["access_token"].GetString();
-      return true;
-    }
+bool authenticate(std::string &access_token) {
+  SpotifySession &session = current_session();
+  if (!resume_session(session_path(), session)) {
+    if (!authorize_interactively(session))
+      return false;
+    if (!save_session(session_path(), session))
+      std::cerr << "Could not save the session to " << session_path() << "\n";
   }
-  return false;
+  access_token = session.access_token;
+  return true;
+}
+
+bool resume_saved_session(std::string &access_token) {
+  SpotifySession &session = current_session();
+  if (!resume_session(session_path(), session))
+    return false;
+  access_token = session.access_token;
+  return true;
+}
+
+bool refresh_if_expiring(std::string &access_token) {
+  SpotifySession &session = current_session();
+  if (session.refresh_token.empty() || !expiring(session))
+    return true;
+  if (!refresh_session(session))
+    return session.expires_at > std::time(nullptr);
+  save_session(session_path(), session);
+  access_token = session.access_token;
+  return true;
 }
@@ -1,155 +1,219 @@
 #include "spotify_operations/LibraryOperations.h"
+#include "list_view.h"
+#include "request_builder.h"
+#include "spotify_api.h"
+#include "spotify_operations/PlaylistOperations.h"
 #include "spotify_operations/SearchOperations.h"
 #include "utils.h"
-#include <curl/curl.h>
+#include <algorithm>
 #include <iostream>
 
-size_t WriteCallbackSavedTracks(void *contents, size_t size, size_t nmemb,
-                                void *userp) {
-  size_t totalSize = size * nmemb;
-  std::string *saved_tracks = static_cast<std::string *>(userp);
-  saved_tracks->append(static_cast<char *>(contents), totalSize);
-  return totalSize;
+namespace {
+
+const int kSavedTrackPageSize = 50;
+const int kAlbumTrackPageSize = 50;
+
+std::string saved_tracks_url(int limit, int offset) {
+  return spotify_api_url("/me/tracks?limit=") + std::to_string(limit) +
+         "&offset=" + std::to_string(offset);
+}
+
+std::string album_tracks_url(const std::string &album_id, int limit,
+                             int offset) {
+  return spotify_api_url("/albums/") + album_id +
+         "/tracks?limit=" + std::to_string(limit) +
+         "&offset=" + std::to_string(offset);
 }
 
+// Saves (PUT) or removes (DELETE) tracks in requests of up to
+// kLibraryBatchSize bare IDs and returns the URIs whose request succeeded
+std::vector<std::string>
+change_library(const std::string &access_token, const std::string &method,
+               const std::vector<std::string> &track_uris, int concurrency) {
+  std::vector<std::string> bodies;
+  JsonBuilder body;
+  for (size_t start = 0; start < track_uris.size();
+       start += kLibraryBatchSize) {
+    size_t end = std::min(track_uris.size(), start + kLibraryBatchSize);
+    body.clear().begin_object().key("ids").begin_array();
+    for (size_t i = start; i < end; ++i)
+      body.value(spotify_id_from_uri(track_uris[i]));
+    body.end_array().end_object();
+    bodies.push_back(body.str());
+  }
+  std::vector<bool> results =
+      spotify_send_json_batch(access_token, method,
+                              spotify_api_url("/me/tracks"), bodies,
+                              concurrency);
+  std::vector<std::string> changed;
+  for (size_t i = 0; i < track_uris.size(); ++i) {
+    if (results[i / kLibraryBatchSize])
+      changed.push_back(track_uris[i]);
+  }
+  return changed;
+}
+
+// Collects every track of the chosen source that can be saved to the library
+// (not local files or episodes) and saves them in batches
+void save_all_tracks(
+    const std::string &access_token,
+    const std::function<bool(const ItemPageCallback &)> &fetch_all) {
+  std::vector<std::string> uris;
+  bool fetched = fetch_all([&uris](const ItemPage &page, int) {
+    for (auto &item : page.items) {
+      if (item.key.compare(0, 14, "spotify:track:") == 0)
+        uris.push_back(item.key);
+    }
+    return true;
+  });
+  if (!fetched) {
+    std::cout << "Failed to retrieve tracks.\n";
+    return;
+  }
+  if (uris.empty()) {
+    std::cout << "No tracks to save.\n";
+    return;
+  }
+  size_t saved = save_tracks_to_library(access_token, uris);
+  std::cout << "Saved " << saved << " of " << uris.size()
+            << " tracks to your library.\n";
+}
+
+} // namespace
+
 bool get_saved_tracks(const std::string &access_token,
                       rapidjson::Document &saved_tracks, int limit,
                       int offset) {
-  CURL *curl = curl_easy_init();
-  if (curl) {
-    std::string url =
-        "https://api.spotify.com/v1/me/tracks?limit=" + std::to_string(limit) +
-        "&offset=" + std::to_string(offset);
-    std::string response;
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(
-        headers, ("Authorization: Bearer " + access_token).c_str());
-
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallbackSavedTracks);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-
-    CURLcode res = curl_easy_perform(curl);
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
-
-    if (res != CURLE_OK)
-      return false;
-
-    if (saved_tracks.Parse(response.c_str()).HasParseError())
-      return false;
-    return true;
-  }
-  return false;
+  return spotify_get_json(access_token, saved_tracks_url(limit, offset),
+                          saved_tracks);
+}
+
+bool get_saved_tracks(const std::string &access_token,
+                      DocumentLease &saved_tracks, int limit, int offset) {
+  return spotify_get_pooled_json(
+      access_token, saved_tracks_url(limit, offset), saved_tracks);
+}
+
+std::future<bool> get_saved_tracks_async(const std::string &access_token,
+                                         rapidjson::Document &saved_tracks,
+                                         int limit, int offset) {
+  return spotify_get_json_async(access_token, saved_tracks_url(limit, offset),
+                                saved_tracks);
 }
 
-std::vector<std::pair<std::string, std::string>>
+bool get_all_saved_tracks(const std::string &access_token,
+                          const PageCallback &on_page, int window) {
+  return fetch_all_pages(access_token, saved_tracks_url, kSavedTrackPageSize,
+                         window, on_page);
+}
+
+CatalogView
 display_saved_tracks_and_select(const rapidjson::Document &saved_tracks) {
-  std::vector<std::pair<std::string, std::string>> selected_tracks;
-  if (saved_tracks.HasMember("items") && saved_tracks["items"].IsArray()) {
-    const rapidjson::Value &items = saved_tracks["items"];
-    for (auto &item : items.GetArray()) {
-      if (item.HasMember("track") && item["track"].IsObject()) {
-        std::string name = item["track"]["name"].GetString();
-        std::string uri = item["track"]["uri"].GetString();
-        std::cout << "- " << name << " (URI: " << uri << ")\n";
-        selected_tracks.emplace_back(name, uri);
-      }
-    }
+  CatalogView selected_tracks;
+  display_track_page(saved_tracks, selected_tracks);
+  return selected_tracks;
+}
+
+// Lists the locally stored saved tracks without touching the network,
+// scrollable full screen when the terminal allows it
+CatalogView display_saved_tracks_and_select(LibraryStore &store) {
+  CatalogView selected_tracks = store.catalog_view();
+  if (Screen::available()) {
+    if (!selected_tracks.empty())
+      pick_from_list("Saved Tracks", selected_tracks.size(),
+                     [&selected_tracks](size_t index) {
+                       return catalog_entry_text(selected_tracks[index]);
+                     });
+    return selected_tracks;
   }
+  for (size_t i = 0; i < selected_tracks.size(); ++i)
+    display_catalog_entry(i + 1, selected_tracks[i]);
   return selected_tracks;
 }
 
 bool add_track_to_library(const std::string &access_token,
                           const std::string &track_uri) {
-  CURL *curl = curl_easy_init();
-  if (curl) {
-    std::string url =
-        "https://api.spotify.com/v1/me/tracks?ids=" + url_encode(track_uri);
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(
-        headers, ("Authorization: Bearer " + access_token).c_str());
-    headers = curl_slist_append(headers, "Content-Type: application/json");
-
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_PUT, 1L);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, "");
-
-    CURLcode res = curl_easy_perform(curl);
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
-
-    return res == CURLE_OK;
-  }
-  return false;
+  return save_tracks_to_library(access_token, {track_uri}) == 1;
 }
 
 bool remove_track_from_library(const std::string &access_token,
                                const std::string &track_uri) {
-  CURL *curl = curl_easy_init();
-  if (curl) {
-    std::string url =
-        "https://api.spotify.com/v1/me/tracks?ids=" + url_encode(track_uri);
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(
-        headers, ("Authorization: Bearer " + access_token).c_str());
-    headers = curl_slist_append(headers, "Content-Type: application/json");
-
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE");
-
-    CURLcode res = curl_easy_perform(curl);
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
-
-    return res == CURLE_OK;
-  }
-  return false;
+  return remove_tracks_from_library(access_token, {track_uri}) == 1;
+}
+
+// Returns the number of tracks saved
+size_t save_tracks_to_library(const std::string &access_token,
+                              const std::vector<std::string> &track_uris,
+                              int concurrency) {
+  return change_library(access_token, "PUT", track_uris, concurrency).size();
+}
+
+// Returns the number of tracks removed; the local store follows along
+size_t remove_tracks_from_library(const std::string &access_token,
+                                  const std::vector<std::string> &track_uris,
+                                  int concurrency) {
+  std::vector<std::string> removed =
+      change_library(access_token, "DELETE", track_uris, concurrency);
+  library_store().remove(removed);
+  return removed.size();
+}
+
+// Streams the name and URI of every track on an album to on_page
+bool get_all_album_track_items(const std::string &access_token,
+                               const std::string &album_id,
+                               const ItemPageCallback &on_page, int window) {
+  return fetch_all_item_pages(
+      access_token,
+      [&album_id](int limit, int offset) {
+        return album_tracks_url(album_id, limit, offset);
+      },
+      kAlbumTrackPageSize, window, ItemView::ALBUM_TRACKS, on_page);
 }
 
 void library_menu(const std::string &access_token) {
+  // Loading the store also puts the saved tracks in the local search index
+  library_store();
   while (true) {
     std::cout << "\n--- Library Management Menu ---\n";
     std::cout << "1. View Saved Tracks\n";
     std::cout << "2. Add a Track to Library\n";
     std::cout << "3. Remove a Track from Library\n";
+    std::cout << "4. Save All Tracks of a Playlist\n";
+    std::cout << "5. Save All Tracks of an Album\n";
+    std::cout << "6. Refresh All Playlists\n";
     std::cout << "b. Back to Main Menu\n";
     std::cout << "Select an option: ";
 
     std::string choice = get_input("");
 
     if (choice == "1") {
-      rapidjson::Document saved_tracks_doc;
-      if (get_saved_tracks(access_token, saved_tracks_doc)) {
-        auto tracks = display_saved_tracks_and_select(saved_tracks_doc);
-        if (tracks.empty()) {
-          std::cout << "No saved tracks found.\n";
-          continue;
-        }
-        std::cout << "Saved Tracks:\n";
-        for (auto &tr : tracks) {
-          std::cout << "- " << tr.first << " (URI: " << tr.second << ")\n";
-        }
-      } else {
+      LibraryStore &store = library_store();
+      if (store.sync(access_token)) {
+        store.reconcile_in_background(access_token);
+      } else if (store.size() == 0) {
         std::cout << "Failed to retrieve saved tracks.\n";
+        continue;
+      } else {
+        std::cout << "Could not sync saved tracks; showing cached copy.\n";
+      }
+      std::cout << "Saved Tracks:\n";
+      auto tracks = display_saved_tracks_and_select(store);
+      if (tracks.empty()) {
+        std::cout << "No saved tracks found.\n";
+        continue;
       }
     } else if (choice == "2") {
       std::cout << "\n--- Add a Track to Your Library ---\n";
       std::string query = get_input("Enter the name of the track to add: ");
-      rapidjson::Document search_results;
-      if (search_spotify(access_token, query, SearchType::TRACK,
-                         search_results)) {
-        display_search_results(search_results, SearchType::TRACK);
-        auto selected =
-            select_from_search_results(search_results, SearchType::TRACK);
-        if (selected.empty()) {
+      ItemPage search_results;
+      if (search_local_first(access_token, query, SearchType::TRACK,
+                             search_results)) {
+        CatalogRef selected = select_from_search_results(search_results);
+        if (selected == kNoCatalogEntry) {
           std::cout << "No track selected.\n";
           continue;
         }
-        if (add_track_to_library(access_token, selected[0].second)) {
+        if (add_track_to_library(access_token, catalog().uri(selected))) {
           std::cout << "Track added to library.\n";
         } else {
           std::cout << "Failed to add track to library.\n";
@@ -160,17 +224,15 @@ void library_menu(const std::string &access_token) {
     } else if (choice == "3") {
       std::cout << "\n--- Remove a Track from Your Library ---\n";
       std::string query = get_input("Enter the name of the track to remove: ");
-      rapidjson::Document search_results;
-      if (search_spotify(access_token, query, SearchType::TRACK,
-                         search_results)) {
-        display_search_results(search_results, SearchType::TRACK);
-        auto selected =
-            select_from_search_results(search_results, SearchType::TRACK);
-        if (selected.empty()) {
+      ItemPage search_results;
+      if (search_local_first(access_token, query, SearchType::TRACK,
+                             search_results)) {
+        CatalogRef selected = select_from_search_results(search_results);
+        if (selected == kNoCatalogEntry) {
           std::cout << "No track selected.\n";
           continue;
         }
-        if (remove_track_from_library(access_token, selected[0].second)) {
+        if (remove_track_from_library(access_token, catalog().uri(selected))) {
           std::cout << "Track removed from library.\n";
         } else {
           std::cout << "Failed to remove track from library.\n";
@@ -178,6 +240,61 @@ void library_menu(const std::string &access_token) {
       } else {
         std::cout << "Search failed.\n";
       }
+    } else if (choice == "4") {
+      CatalogView playlists;
+      std::cout << "\nYour Playlists:\n";
+      if (!get_all_user_playlist_items(
+              access_token, [&playlists](const ItemPage &page, int) {
+                list_item_page(page, CatalogKind::PLAYLIST, playlists);
+                return true;
+              })) {
+        std::cout << "Failed to retrieve playlists.\n";
+        continue;
+      }
+      CatalogRef playlist = choose_from_view(
+          playlists, "Save All Tracks of a Playlist",
+          "\nEnter the number or name of the playlist to save: ");
+      if (playlist == kNoCatalogEntry) {
+        std::cout << "Playlist not found.\n";
+        continue;
+      }
+      std::string playlist_id = catalog().id(playlist);
+      save_all_tracks(access_token, [&](const ItemPageCallback &on_page) {
+        return get_all_playlist_track_items(access_token, playlist_id,
+                                            on_page);
+      });
+    } else if (choice == "5") {
+      std::string query = get_input("Enter the name of the album to save: ");
+      ItemPage albums;
+      if (!search_spotify_items(access_token, query, SearchType::ALBUM,
+                                albums)) {
+        std::cout << "Search failed.\n";
+        continue;
+      }
+      display_search_results(albums);
+      CatalogRef selected =
+          select_from_search_results(albums, SearchType::ALBUM);
+      if (selected == kNoCatalogEntry) {
+        std::cout << "No album selected.\n";
+        continue;
+      }
+      std::string album_id = catalog().id(selected);
+      save_all_tracks(access_token, [&](const ItemPageCallback &on_page) {
+        return get_all_album_track_items(access_token, album_id, on_page);
+      });
+    } else if (choice == "6") {
+      // Only playlists edited since the last refresh are fetched
+      PlaylistRefresh refresh;
+      bool ok = refresh_playlists(access_token, refresh);
+      if (!ok && refresh.failed == 0) {
+        std::cout << "Failed to retrieve playlists.\n";
+        continue;
+      }
+      std::cout << refresh.playlists << " playlists: " << refresh.unchanged
+                << " unchanged, " << refresh.fetched << " fetched";
+      if (!ok)
+        std::cout << ", " << refresh.failed << " failed";
+      std::cout << "\n";
     } else if (choice == "b" || choice == "B") {
       break;
     } else {
@@ -1,192 +1,559 @@
 #include "spotify_operations/PlaybackOperations.h"
+#include "player_state.h"
+#include "screen.h"
+#include "spotify_api.h"
 #include "utils.h"
-#include <curl/curl.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
 #include <iostream>
+#include <mutex>
+#include <thread>
 
-bool play_music(const std::string &access_token) {
-  CURL *curl = curl_easy_init();
-  if (curl) {
-    std::string url = "https://api.spotify.com/v1/me/player/play";
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(
-        headers, ("Authorization: Bearer " + access_token).c_str());
-    headers = curl_slist_append(headers, "Content-Type: application/json");
-
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, "{}");
-
-    CURLcode res = curl_easy_perform(curl);
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
-
-    return res == CURLE_OK;
+namespace {
+
+// Redraw interval of the now playing screen; progress between polls is
+// interpolated, so this costs no requests
+const int kNowPlayingFrameMs = 250;
+const int kVolumeStep = 10;
+
+// Player commands go ahead of queued library and prefetch requests, and have
+// the poller pick up their effect
+bool player_command(const std::string &access_token,
+                    const std::string &method, const std::string &path) {
+  RequestPriorityScope interactive(RequestPriority::INTERACTIVE);
+  bool ok = spotify_send(access_token, method, spotify_api_url(path));
+  if (ok)
+    player_poller().poke();
+  return ok;
+}
+
+void draw_now_playing(Screen &screen, const PlayerState &state, bool known,
+                      int skips, const std::string &message) {
+  int cols = screen.cols();
+  screen.clear();
+  const uint8_t title_style = kStyleBold | kStyleReverse;
+  screen.fill(0, 0, cols, title_style);
+  screen.draw_text(0, 1, "Now Playing", title_style, cols - 2);
+
+  if (!known) {
+    screen.draw_text(2, 2, "Waiting for the player...");
+  } else if (!state.active) {
+    screen.draw_text(2, 2, "Nothing playing");
+  } else {
+    std::string title = skips ? "Skipping (" + std::to_string(skips) + ")..."
+                              : state.track_name;
+    screen.draw_text(2, 2, title, kStyleBold, cols - 4);
+    screen.draw_text(3, 2, state.artist, 0, cols - 4);
+    // Progress bar between the elapsed and total times
+    int progress = state.progress_now();
+    std::string described = describe_player_state(state);
+    int bar = std::max(cols - 4, 10);
+    int filled = state.duration_ms > 0
+                     ? static_cast<int>(static_cast<long long>(bar) *
+                                        progress / state.duration_ms)
+                     : 0;
+    screen.fill(5, 2, filled, kStyleReverse);
+    screen.fill(5, 2 + filled, bar - filled, kStyleDim);
+    screen.draw_text(6, 2, described, kStyleDim, cols - 4);
   }
-  return false;
+
+  screen.draw_text(8, 2,
+                   "space: play/pause  n: next  +/-: volume  "
+                   "s: shuffle  r: repeat  q: back",
+                   kStyleDim, cols - 4);
+  int last = screen.rows() - 1;
+  screen.fill(last, 0, cols, kStyleReverse);
+  PlayerPollerStats stats = player_poller().stats();
+  std::string status = message.empty()
+                           ? std::to_string(stats.polls) +
+                                 " polls, next in " +
+                                 std::to_string(stats.interval_ms) + "ms"
+                           : message;
+  screen.draw_text(last, 1, status, kStyleReverse, cols - 2);
 }
 
-bool pause_music(const std::string &access_token) {
-  CURL *curl = curl_easy_init();
-  if (curl) {
-    std::string url = "https://api.spotify.com/v1/me/player/pause";
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(
-        headers, ("Authorization: Bearer " + access_token).c_str());
-
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
-
-    CURLcode res = curl_easy_perform(curl);
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
-
-    return res == CURLE_OK;
+// Applies a key of the now playing screen through the command queue, so
+// that held keys coalesce instead of waiting on each other
+void now_playing_key(const std::string &access_token, const KeyEvent &key) {
+  if (key.key != Key::CHAR)
+    return;
+  PlayerCommands &commands = player_commands();
+  switch (key.ch) {
+  case ' ':
+    commands.toggle_playing(access_token);
+    break;
+  case 'n':
+    commands.skip(access_token);
+    break;
+  case '+':
+  case '-':
+    commands.nudge_volume(access_token,
+                          key.ch == '+' ? kVolumeStep : -kVolumeStep);
+    break;
+  case 's': {
+    PlayerState state;
+    if (commands.snapshot(state))
+      commands.set_shuffle(access_token, !state.shuffle);
+    break;
+  }
+  case 'r': {
+    // off -> context -> track -> off
+    PlayerState state;
+    if (commands.snapshot(state))
+      commands.set_repeat(access_token,
+                          state.repeat == "off"       ? "context"
+                          : state.repeat == "context" ? "track"
+                                                      : "off");
+    break;
+  }
   }
-  return false;
 }
 
-bool skip_track(const std::string &access_token) {
-  CURL *curl = curl_easy_init();
-  if (curl) {
-    std::string url = "https://api.spotify.com/v1/me/player/next";
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(
-        headers, ("Authorization: Bearer " + access_token).c_str());
-
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "POST");
-
-    CURLcode res = curl_easy_perform(curl);
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
-
-    return res == CURLE_OK;
+const char *const kSettingNames[kPlayerSettings] = {"Play/pause", "Volume",
+                                                    "Shuffle", "Repeat"};
+
+// Describes a failed command for take_error()
+std::string command_failure(const char *name, const HttpResponse &response) {
+  return std::string(name) + " failed: " + spotify_failure_message(response);
+}
+
+// Shows a setting's value in a player state
+void apply_setting(PlayerSetting setting, const std::string &value,
+                   PlayerState &state) {
+  switch (setting) {
+  case PlayerSetting::PLAYBACK:
+    // Progress stops or starts counting from here
+    state.progress_ms = state.progress_now();
+    state.fetched_at = std::chrono::steady_clock::now();
+    state.playing = value == "play";
+    break;
+  case PlayerSetting::VOLUME:
+    state.volume = std::atoi(value.c_str());
+    break;
+  case PlayerSetting::SHUFFLE:
+    state.shuffle = value == "true";
+    break;
+  case PlayerSetting::REPEAT:
+    state.repeat = value;
+    break;
   }
-  return false;
 }
 
-bool set_volume(const std::string &access_token, int volume) {
+// A skip restarts progress; the new track shows once the poller reads it
+void apply_skip(PlayerState &state) {
+  state.progress_ms = 0;
+  state.fetched_at = std::chrono::steady_clock::now();
+}
+
+std::string setting_path(PlayerSetting setting, const std::string &value) {
+  switch (setting) {
+  case PlayerSetting::PLAYBACK:
+    return "/me/player/" + value;
+  case PlayerSetting::VOLUME:
+    return "/me/player/volume?volume_percent=" + value;
+  case PlayerSetting::SHUFFLE:
+    return "/me/player/shuffle?state=" + value;
+  case PlayerSetting::REPEAT:
+    return "/me/player/repeat?state=" + value;
+  }
+  return "";
+}
+
+} // namespace
+
+// One setting's latest value and the request sending it
+struct CommandSlot {
+  std::string value;   // latest value asked for
+  std::string sending; // value of the request in flight
+  bool queued = false; // value has not been sent yet
+  bool in_flight = false;
+  bool settling = false; // the settler sends value once changes stop
+  std::chrono::steady_clock::time_point changed_at;
+};
+
+struct PlayerCommands::State {
+  std::mutex mutex;
+  std::condition_variable idle;
+  std::condition_variable settle; // a setting changed, or stopping
+  bool running = false;           // the settler thread is up
+  std::string access_token;
+  std::chrono::milliseconds settle_interval;
+  CommandSlot slots[kPlayerSettings];
+  int skips_queued = 0;
+  bool skip_in_flight = false;
+  PlayerCommandStats stats;
+  std::string error;
+
+  bool busy() const {
+    for (const CommandSlot &slot : slots) {
+      if (slot.queued || slot.in_flight)
+        return true;
+    }
+    return skips_queued > 0 || skip_in_flight;
+  }
+};
+
+PlayerCommands::PlayerCommands(int settle_ms)
+    : state_(std::make_shared<State>()) {
+  state_->settle_interval = std::chrono::milliseconds(settle_ms);
+}
+
+PlayerCommands::~PlayerCommands() { stop(); }
+
+void PlayerCommands::set_playing(const std::string &access_token,
+                                 bool playing) {
+  change(access_token, PlayerSetting::PLAYBACK, playing ? "play" : "pause");
+}
+
+bool PlayerCommands::toggle_playing(const std::string &access_token) {
+  PlayerState state;
+  if (!snapshot(state))
+    return false;
+  set_playing(access_token, !state.playing);
+  return true;
+}
+
+bool PlayerCommands::set_volume(const std::string &access_token, int volume) {
   if (volume < 0 || volume > 100)
     return false;
-  CURL *curl = curl_easy_init();
-  if (curl) {
-    std::string url =
-        "https://api.spotify.com/v1/me/player/volume?volume_percent=" +
-        std::to_string(volume);
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(
-        headers, ("Authorization: Bearer " + access_token).c_str());
-
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
-
-    CURLcode res = curl_easy_perform(curl);
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
-
-    return res == CURLE_OK;
+  change(access_token, PlayerSetting::VOLUME, std::to_string(volume));
+  return true;
+}
+
+bool PlayerCommands::nudge_volume(const std::string &access_token,
+                                  int delta) {
+  PlayerState state;
+  if (!snapshot(state) || state.volume < 0)
+    return false;
+  return set_volume(access_token,
+                    std::min(100, std::max(0, state.volume + delta)));
+}
+
+void PlayerCommands::set_shuffle(const std::string &access_token,
+                                 bool enable) {
+  change(access_token, PlayerSetting::SHUFFLE, enable ? "true" : "false");
+}
+
+bool PlayerCommands::set_repeat(const std::string &access_token,
+                                const std::string &state) {
+  if (state != "track" && state != "context" && state != "off")
+    return false;
+  change(access_token, PlayerSetting::REPEAT, state);
+  return true;
+}
+
+void PlayerCommands::skip(const std::string &access_token) {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  state_->access_token = access_token;
+  ++state_->stats.requested;
+  ++state_->skips_queued;
+  send_skip(state_);
+}
+
+bool PlayerCommands::snapshot(PlayerState &state, int *pending_skips) {
+  bool known = player_poller().snapshot(state);
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  int skips = state_->skips_queued + (state_->skip_in_flight ? 1 : 0);
+  if (pending_skips)
+    *pending_skips = skips;
+  if (!known)
+    return false;
+  if (skips)
+    apply_skip(state);
+  for (int i = 0; i < kPlayerSettings; ++i) {
+    const CommandSlot &slot = state_->slots[i];
+    if (slot.queued || slot.in_flight)
+      apply_setting(static_cast<PlayerSetting>(i), slot.value, state);
   }
-  return false;
+  return true;
 }
 
-bool toggle_shuffle(const std::string &access_token, bool enable) {
-  CURL *curl = curl_easy_init();
-  if (curl) {
-    std::string url = "https://api.spotify.com/v1/me/player/shuffle?state=" +
-                      std::string(enable ? "true" : "false");
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(
-        headers, ("Authorization: Bearer " + access_token).c_str());
-
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
-
-    CURLcode res = curl_easy_perform(curl);
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
-
-    return res == CURLE_OK;
+void PlayerCommands::wait() {
+  std::unique_lock<std::mutex> lock(state_->mutex);
+  state_->idle.wait(lock, [this] { return !state_->busy(); });
+}
+
+std::string PlayerCommands::take_error() {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  std::string error;
+  error.swap(state_->error);
+  return error;
+}
+
+void PlayerCommands::stop() {
+  std::thread settler;
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->running = false;
+    settler.swap(settler_);
   }
-  return false;
+  state_->settle.notify_all();
+  if (settler.joinable())
+    settler.join();
+}
+
+PlayerCommandStats PlayerCommands::stats() {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->stats;
+}
+
+void PlayerCommands::change(const std::string &access_token,
+                            PlayerSetting setting, const std::string &value) {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  state_->access_token = access_token;
+  ++state_->stats.requested;
+  CommandSlot &slot = state_->slots[static_cast<int>(setting)];
+  if (slot.queued)
+    ++state_->stats.coalesced;
+  slot.value = value;
+  slot.queued = true;
+  slot.changed_at = std::chrono::steady_clock::now();
+  if (state_->settle_interval.count() == 0) {
+    send_setting(state_, static_cast<int>(setting));
+    return;
+  }
+  slot.settling = true;
+  if (!state_->running) {
+    state_->running = true;
+    std::shared_ptr<State> shared = state_;
+    settler_ = std::thread([shared] { run(shared); });
+  }
+  state_->settle.notify_all();
+}
+
+// Sends each setting once it has not changed for the settle interval, so
+// that a held key sends one request with the value it stopped at
+void PlayerCommands::run(const std::shared_ptr<State> &state) {
+  std::unique_lock<std::mutex> lock(state->mutex);
+  while (state->running) {
+    auto now = std::chrono::steady_clock::now();
+    auto next = std::chrono::steady_clock::time_point::max();
+    for (int i = 0; i < kPlayerSettings; ++i) {
+      CommandSlot &slot = state->slots[i];
+      if (!slot.settling)
+        continue;
+      auto due = slot.changed_at + state->settle_interval;
+      if (due <= now) {
+        slot.settling = false;
+        send_setting(state, i);
+      } else {
+        next = std::min(next, due);
+      }
+    }
+    if (next == std::chrono::steady_clock::time_point::max())
+      state->settle.wait(lock);
+    else
+      state->settle.wait_until(lock, next);
+  }
+}
+
+// Called with the mutex held. Sends the setting's latest value unless a
+// request for it is in flight, whose callback sends whatever came after, or
+// the value is still settling.
+void PlayerCommands::send_setting(const std::shared_ptr<State> &state,
+                                  int index) {
+  CommandSlot &slot = state->slots[index];
+  if (slot.in_flight || !slot.queued || slot.settling)
+    return;
+  PlayerSetting setting = static_cast<PlayerSetting>(index);
+  slot.queued = false;
+  slot.in_flight = true;
+  slot.sending = slot.value;
+  ++state->stats.sent;
+
+  std::shared_ptr<State> shared = state;
+  SendCallback done = [shared, index](bool ok, HttpResponse &response) {
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    CommandSlot &slot = shared->slots[index];
+    PlayerSetting setting = static_cast<PlayerSetting>(index);
+    slot.in_flight = false;
+    if (ok) {
+      std::string value = slot.sending;
+      player_poller().amend([setting, value](PlayerState &cached) {
+        apply_setting(setting, value, cached);
+      });
+      player_poller().poke();
+      // Set back to the value just confirmed, such as volume up then down
+      if (slot.queued && slot.value == slot.sending) {
+        slot.queued = false;
+        ++shared->stats.coalesced;
+      }
+    } else {
+      ++shared->stats.failed;
+      shared->error = command_failure(kSettingNames[index], response);
+    }
+    send_setting(shared, index);
+    if (!shared->busy())
+      shared->idle.notify_all();
+  };
+
+  RequestPriorityScope interactive(RequestPriority::INTERACTIVE);
+  std::string url = spotify_api_url(setting_path(setting, slot.sending));
+  const char *method = "PUT";
+  if (setting == PlayerSetting::PLAYBACK && slot.sending == "play")
+    spotify_send_json_async(state->access_token, method, url, "{}", done);
+  else
+    spotify_send_async(state->access_token, method, url, done);
+}
+
+// Called with the mutex held. Skips go one at a time so that each lands on
+// the track the previous one moved to.
+void PlayerCommands::send_skip(const std::shared_ptr<State> &state) {
+  if (state->skip_in_flight || state->skips_queued == 0)
+    return;
+  --state->skips_queued;
+  state->skip_in_flight = true;
+  ++state->stats.sent;
+
+  std::shared_ptr<State> shared = state;
+  RequestPriorityScope interactive(RequestPriority::INTERACTIVE);
+  spotify_send_async(
+      state->access_token, "POST", spotify_api_url("/me/player/next"),
+      [shared](bool ok, HttpResponse &response) {
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        shared->skip_in_flight = false;
+        if (ok) {
+          player_poller().amend(apply_skip);
+          player_poller().poke();
+        } else {
+          // The skips after a failed one would land somewhere unexpected
+          shared->stats.failed += 1 + shared->skips_queued;
+          shared->skips_queued = 0;
+          shared->error = command_failure("Skip", response);
+        }
+        send_skip(shared);
+        if (!shared->busy())
+          shared->idle.notify_all();
+      });
+}
+
+PlayerCommands &player_commands() {
+  static PlayerCommands commands;
+  return commands;
+}
+
+bool play_music(const std::string &access_token) {
+  RequestPriorityScope interactive(RequestPriority::INTERACTIVE);
+  bool ok = spotify_send_json(access_token, "PUT",
+                              spotify_api_url("/me/player/play"), "{}");
+  if (ok)
+    player_poller().poke();
+  return ok;
+}
+
+bool pause_music(const std::string &access_token) {
+  return player_command(access_token, "PUT", "/me/player/pause");
+}
+
+bool skip_track(const std::string &access_token) {
+  return player_command(access_token, "POST", "/me/player/next");
+}
+
+bool set_volume(const std::string &access_token, int volume) {
+  if (volume < 0 || volume > 100)
+    return false;
+  return player_command(access_token, "PUT",
+                        "/me/player/volume?volume_percent=" +
+                            std::to_string(volume));
+}
+
+bool toggle_shuffle(const std::string &access_token, bool enable) {
+  return player_command(access_token, "PUT",
+                        "/me/player/shuffle?state=" +
+                            std::string(enable ? "true" : "false"));
 }
 
 bool toggle_repeat(const std::string &access_token, const std::string &state) {
   if (state != "track" && state != "context" && state != "off")
     return false;
-  CURL *curl = curl_easy_init();
-  if (curl) {
-    std::string url =
-        "https://api.spotify.com/v1/me/player/repeat?state=" + state;
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(
-        headers, ("Authorization: Bearer " + access_token).c_str());
-
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
-
-    CURLcode res = curl_easy_perform(curl);
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
-
-    return res == CURLE_OK;
+  return player_command(access_token, "PUT",
+                        "/me/player/repeat?state=" + state);
+}
+
+// Shows the player state full screen, redrawn from the poller's cache, with
+// single-key controls; prints it once when there is no full screen
+void now_playing_view(const std::string &access_token) {
+  player_poller().start(access_token);
+  PlayerCommands &commands = player_commands();
+  PlayerState state;
+  Screen screen;
+  if (!screen.start()) {
+    if (commands.snapshot(state) || get_player_state(access_token, state))
+      std::cout << describe_player_state(state) << "\n";
+    else
+      std::cout << "Failed to get the player state.\n";
+    return;
   }
-  return false;
+  std::string message;
+  while (true) {
+    int skips = 0;
+    bool known = commands.snapshot(state, &skips);
+    std::string error = commands.take_error();
+    if (!error.empty())
+      message = error;
+    draw_now_playing(screen, state, known, skips, message);
+    screen.present();
+    KeyEvent key = screen.read_key(kNowPlayingFrameMs);
+    if (key.key == Key::ESCAPE ||
+        (key.key == Key::CHAR && (key.ch == 'q' || key.ch == 'b')))
+      break;
+    if (key.key != Key::NONE && key.key != Key::RESIZE) {
+      message.clear();
+      now_playing_key(access_token, key);
+    }
+  }
+  screen.stop();
 }
 
+// Commands return at once; a command that fails is reported, and undone on
+// screen, the next time the menu is shown
 void playback_menu(const std::string &access_token) {
+  player_poller().start(access_token);
+  PlayerCommands &commands = player_commands();
   while (true) {
     std::cout << "\n--- Playback Control Menu ---\n";
+    std::string error = commands.take_error();
+    if (!error.empty())
+      std::cout << error << "; undone.\n";
+    PlayerState player;
+    if (commands.snapshot(player))
+      std::cout << describe_player_state(player) << "\n";
     std::cout << "1. Play\n";
     std::cout << "2. Pause\n";
     std::cout << "3. Skip Track\n";
     std::cout << "4. Set Volume\n";
     std::cout << "5. Toggle Shuffle\n";
     std::cout << "6. Toggle Repeat\n";
+    std::cout << "7. Now Playing\n";
     std::cout << "b. Back to Main Menu\n";
     std::cout << "Select an option: ";
 
     std::string choice = get_input("");
 
     if (choice == "1") {
-      if (play_music(access_token)) {
-        std::cout << "Playback started.\n";
-      } else {
-        std::cout << "Failed to start playback.\n";
-      }
+      commands.set_playing(access_token, true);
+      std::cout << "Starting playback.\n";
     } else if (choice == "2") {
-      if (pause_music(access_token)) {
-        std::cout << "Playback paused.\n";
-      } else {
-        std::cout << "Failed to pause playback.\n";
-      }
+      commands.set_playing(access_token, false);
+      std::cout << "Pausing playback.\n";
     } else if (choice == "3") {
-      if (skip_track(access_token)) {
-        std::cout << "Skipped to next track.\n";
-      } else {
-        std::cout << "Failed to skip track.\n";
-      }
+      commands.skip(access_token);
+      std::cout << "Skipping to the next track.\n";
     } else if (choice == "4") {
       std::string vol_str = get_input("Enter volume (0-100): ");
       int volume = std::stoi(vol_str);
-      if (set_volume(access_token, volume)) {
-        std::cout << "Volume set to " << volume << "%.\n";
+      if (commands.set_volume(access_token, volume)) {
+        std::cout << "Setting volume to " << volume << "%.\n";
       } else {
-        std::cout << "Failed to set volume.\n";
+        std::cout << "Volume must be between 0 and 100.\n";
       }
     } else if (choice == "5") {
       std::string toggle = get_input("Enable shuffle? (y/n): ");
       bool enable = (toggle == "y" || toggle == "Y");
-      if (toggle_shuffle(access_token, enable)) {
-        std::cout << "Shuffle " << (enable ? "enabled.\n" : "disabled.\n");
-      } else {
-        std::cout << "Failed to toggle shuffle.\n";
-      }
+      commands.set_shuffle(access_token, enable);
+      std::cout << (enable ? "Enabling" : "Disabling") << " shuffle.\n";
     } else if (choice == "6") {
       std::cout << "Select repeat mode:\n";
       std::cout << "1. Track\n";
@@ -205,12 +572,16 @@ void playback_menu(const std::string &access_token) {
         std::cout << "Invalid choice.\n";
         continue;
       }
-      if (toggle_repeat(access_token, state)) {
-        std::cout << "Repeat set to " << state << ".\n";
-      } else {
-        std::cout << "Failed to set repeat.\n";
-      }
+      commands.set_repeat(access_token, state);
+      std::cout << "Setting repeat to " << state << ".\n";
+    } else if (choice == "7") {
+      now_playing_view(access_token);
     } else if (choice == "b" || choice == "B") {
+      // Sends a value still settling and reports it if it fails
+      commands.wait();
+      std::string error = commands.take_error();
+      if (!error.empty())
+        std::cout << error << "; undone.\n";
       break;
     } else {
       std::cout << "Invalid option. Try again.\n";
@@ -1,200 +1,504 @@
 #include "spotify_operations/PlaylistOperations.h"
+#include "library_store.h"
+#include "list_view.h"
+#include "page_prefetch.h"
+#include "playlist_store.h"
+#include "request_builder.h"
+#include "search_index.h"
+#include "spotify_api.h"
 #include "utils.h"
-#include <curl/curl.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
-// Callback function to handle cURL responses for playlists
-size_t WriteCallbackPlaylists(void *contents, size_t size, size_t nmemb,
-                              void *userp) {
-  size_t totalSize = size * nmemb;
-  std::string *playlists = static_cast<std::string *>(userp);
-  playlists->append(static_cast<char *>(contents), totalSize);
-  return totalSize;
+namespace {
+
+// Largest page sizes the Web API accepts for these endpoints
+const int kPlaylistPageSize = 50;
+const int kPlaylistTrackPageSize = 100;
+// Playlists whose first page of tracks is prefetched while the list is
+// shown, of which up to kPrefetchRecentPlaylists recently opened ones
+const size_t kPrefetchPlaylists = 4;
+const size_t kPrefetchRecentPlaylists = 2;
+
+std::string playlists_url(int limit, int offset) {
+  return spotify_api_url("/me/playlists?limit=") + std::to_string(limit) +
+         "&offset=" + std::to_string(offset);
+}
+
+std::string playlist_tracks_url(const std::string &playlist_id, int limit,
+                                int offset) {
+  return spotify_api_url("/playlists/") + playlist_id +
+         "/tracks?limit=" + std::to_string(limit) +
+         "&offset=" + std::to_string(offset);
+}
+
+// Playlists opened from the menu, most recent first
+std::deque<std::string> recent_playlists;
+const size_t kRecentPlaylists = 8;
+
+void note_playlist_opened(const std::string &playlist_id) {
+  auto it = std::find(recent_playlists.begin(), recent_playlists.end(),
+                      playlist_id);
+  if (it != recent_playlists.end())
+    recent_playlists.erase(it);
+  recent_playlists.push_front(playlist_id);
+  if (recent_playlists.size() > kRecentPlaylists)
+    recent_playlists.pop_back();
+}
+
+// Requests the first page of tracks of the playlists the user is most likely
+// to open next: the most recently opened ones still in the list, then the
+// top of the list. Playlists stored at their listed snapshot are skipped, as
+// opening them needs no request.
+void prefetch_likely_playlists(
+    const std::string &access_token, const CatalogView &playlists,
+    const std::unordered_map<std::string, std::string> &snapshots) {
+  std::vector<std::string> likely;
+  // Listed, not stored at its snapshot and not picked yet
+  auto wanted = [&snapshots, &likely](const std::string &id) {
+    auto snapshot = snapshots.find(id);
+    return snapshot != snapshots.end() &&
+           std::find(likely.begin(), likely.end(), id) == likely.end() &&
+           !playlist_store().has(id, snapshot->second);
+  };
+  for (auto &id : recent_playlists) {
+    if (likely.size() >= kPrefetchRecentPlaylists)
+      break;
+    if (wanted(id))
+      likely.push_back(id);
+  }
+  for (CatalogRef ref : playlists) {
+    if (likely.size() >= kPrefetchPlaylists)
+      break;
+    std::string id = catalog().id(ref);
+    if (wanted(id))
+      likely.push_back(id);
+  }
+  for (auto &id : likely)
+    page_prefetcher().prefetch(
+        access_token, playlist_tracks_url(id, kPlaylistTrackPageSize, 0),
+        ItemView::TRACK_ITEMS);
+}
+
+} // namespace
+
+struct PlaylistTrackBatch::State {
+  std::string access_token;
+  std::string url;
+  int position = -1;
+  std::mutex mutex;
+  std::condition_variable idle;
+  // Batches of URIs waiting for the request in flight
+  std::deque<std::vector<std::string>> queued;
+  bool in_flight = false;
+  size_t added = 0;
+  size_t failed = 0;
+};
+
+PlaylistTrackBatch::PlaylistTrackBatch(const std::string &access_token,
+                                       const std::string &playlist_id,
+                                       int position)
+    : state_(std::make_shared<State>()) {
+  state_->access_token = access_token;
+  state_->position = position;
+  state_->url = spotify_api_url("/playlists/") + playlist_id + "/tracks";
+}
+
+PlaylistTrackBatch::~PlaylistTrackBatch() { flush(); }
+
+void PlaylistTrackBatch::add(const std::string &track_uri) {
+  pending_.push_back(track_uri);
+  if (pending_.size() >= static_cast<size_t>(kPlaylistAddBatchSize))
+    submit_pending();
+}
+
+size_t PlaylistTrackBatch::flush() {
+  submit_pending();
+  std::unique_lock<std::mutex> lock(state_->mutex);
+  state_->idle.wait(lock, [this] {
+    return !state_->in_flight && state_->queued.empty();
+  });
+  return state_->added;
+}
+
+size_t PlaylistTrackBatch::failed() {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->failed;
+}
+
+void PlaylistTrackBatch::submit_pending() {
+  if (pending_.empty())
+    return;
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  state_->queued.push_back(std::move(pending_));
+  pending_.clear();
+  send_next(state_);
+}
+
+// Starts the next queued request unless one is in flight; called with
+// state->mutex held, including from the completion callback
+void PlaylistTrackBatch::send_next(const std::shared_ptr<State> &state) {
+  if (state->in_flight || state->queued.empty())
+    return;
+  const std::vector<std::string> &uris = state->queued.front();
+  size_t count = uris.size();
+  JsonBuilder builder;
+  builder.begin_object().key("uris").string_array(uris);
+  // After the tracks that landed; earlier batches have all completed
+  if (state->position >= 0)
+    builder.key("position")
+        .value(static_cast<long long>(state->position + state->added));
+  std::string body = builder.end_object().release();
+  state->queued.pop_front();
+  state->in_flight = true;
+  std::shared_ptr<State> shared = state;
+  spotify_send_json_async(state->access_token, "POST", state->url, body,
+                          [shared, count](bool ok, HttpResponse &) {
+                            std::lock_guard<std::mutex> lock(shared->mutex);
+                            shared->in_flight = false;
+                            (ok ? shared->added : shared->failed) += count;
+                            send_next(shared);
+                            shared->idle.notify_all();
+                          });
 }
 
 // Fetches the user's playlists from Spotify
 bool get_user_playlists(const std::string &access_token,
                         rapidjson::Document &playlists, int limit, int offset) {
-  CURL *curl = curl_easy_init();
-  if (curl) {
-    std::string url = "https://api.spotify.com/v1/me/playlists?limit=" +
-                      std::to_string(limit) +
-                      "&offset=" + std::to_string(offset);
-    std::string response;
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(
-        headers, ("Authorization: Bearer " + access_token).c_str());
-
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallbackPlaylists);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-
-    CURLcode res = curl_easy_perform(curl);
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
-
-    if (res != CURLE_OK)
-      return false;
-
-    if (playlists.Parse(response.c_str()).HasParseError())
-      return false;
-    return true;
-  }
-  return false;
+  return spotify_get_json(access_token, playlists_url(limit, offset),
+                          playlists);
+}
+
+std::future<bool> get_user_playlists_async(const std::string &access_token,
+                                           rapidjson::Document &playlists,
+                                           int limit, int offset) {
+  return spotify_get_json_async(access_token, playlists_url(limit, offset),
+                                playlists);
+}
+
+// Streams every page of the user's playlists to on_page
+bool get_all_user_playlists(const std::string &access_token,
+                            const PageCallback &on_page, int window) {
+  return fetch_all_pages(access_token, playlists_url, kPlaylistPageSize,
+                         window, on_page);
+}
+
+// Streams the name and ID of every playlist to on_page
+bool get_all_user_playlist_items(const std::string &access_token,
+                                 const ItemPageCallback &on_page, int window) {
+  return fetch_all_item_pages(access_token, playlists_url, kPlaylistPageSize,
+                              window, ItemView::PLAYLISTS, on_page);
 }
 
 // Displays playlists and allows user to select one
-std::vector<std::pair<std::string, std::string>>
-display_playlists_and_select(const rapidjson::Document &playlists) {
-  std::vector<std::pair<std::string, std::string>> selected_playlists;
+CatalogView display_playlists_and_select(const rapidjson::Document &playlists) {
+  CatalogView selected_playlists;
   if (playlists.HasMember("items") && playlists["items"].IsArray()) {
-    const rapidjson::Value &items = playlists["items"];
     std::cout << "\nYour Playlists:\n";
-    for (auto &item : items.GetArray()) {
-      std::string name = item["name"].GetString();
-      std::string id = item["id"].GetString();
-      std::cout << "- " << name << " (ID: " << id << ")\n";
-      selected_playlists.emplace_back(name, id);
-    }
+    display_playlist_page(playlists, selected_playlists);
   }
   return selected_playlists;
 }
 
-// Callback function to handle cURL responses for tracks
-size_t WriteCallbackTracks(void *contents, size_t size, size_t nmemb,
-                           void *userp) {
-  size_t totalSize = size * nmemb;
-  std::string *tracks = static_cast<std::string *>(userp);
-  tracks->append(static_cast<char *>(contents), totalSize);
-  return totalSize;
+// Displays one page of playlists and appends them to playlists
+void display_playlist_page(const rapidjson::Value &page,
+                           CatalogView &playlists) {
+  if (!page.HasMember("items") || !page["items"].IsArray())
+    return;
+  for (auto &item : page["items"].GetArray()) {
+    if (!item.IsObject())
+      continue;
+    playlists.push_back(catalog().add(CatalogKind::PLAYLIST,
+                                      item["name"].GetString(),
+                                      item["id"].GetString()));
+    display_catalog_entry(playlists.size(), playlists.back());
+  }
 }
 
 // Fetches tracks from a specific playlist
 bool get_playlist_tracks(const std::string &access_token,
                          const std::string &playlist_id,
                          rapidjson::Document &tracks, int limit, int offset) {
-  CURL *curl = curl_easy_init();
-  if (curl) {
-    std::string url = "https://api.spotify.com/v1/playlists/" + playlist_id +
-                      "/tracks?limit=" + std::to_string(limit) +
-                      "&offset=" + std::to_string(offset);
-    std::string response;
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(
-        headers, ("Authorization: Bearer " + access_token).c_str());
-
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallbackTracks);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-
-    CURLcode res = curl_easy_perform(curl);
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
-
-    if (res != CURLE_OK)
-      return false;
-
-    if (tracks.Parse(response.c_str()).HasParseError())
-      return false;
+  return spotify_get_json(access_token,
+                          playlist_tracks_url(playlist_id, limit, offset),
+                          tracks);
+}
+
+std::future<bool> get_playlist_tracks_async(const std::string &access_token,
+                                            const std::string &playlist_id,
+                                            rapidjson::Document &tracks,
+                                            int limit, int offset) {
+  return spotify_get_json_async(
+      access_token, playlist_tracks_url(playlist_id, limit, offset), tracks);
+}
+
+// Streams every page of a playlist's tracks to on_page
+bool get_all_playlist_tracks(const std::string &access_token,
+                             const std::string &playlist_id,
+                             const PageCallback &on_page, int window) {
+  return fetch_all_pages(
+      access_token,
+      [&playlist_id](int limit, int offset) {
+        return playlist_tracks_url(playlist_id, limit, offset);
+      },
+      kPlaylistTrackPageSize, window, on_page);
+}
+
+// Streams the name and URI of every track in a playlist to on_page
+bool get_all_playlist_track_items(const std::string &access_token,
+                                  const std::string &playlist_id,
+                                  const ItemPageCallback &on_page,
+                                  int window) {
+  return fetch_all_item_pages(
+      access_token,
+      [&playlist_id](int limit, int offset) {
+        return playlist_tracks_url(playlist_id, limit, offset);
+      },
+      kPlaylistTrackPageSize, window, ItemView::TRACK_ITEMS, on_page);
+}
+
+// Streams a playlist's tracks from playlist_store() when its copy is at
+// snapshot_id, as one page and without a request; otherwise fetches them
+// and, once every page has arrived, stores them under snapshot_id
+bool get_playlist_track_items_cached(const std::string &access_token,
+                                     const std::string &playlist_id,
+                                     const std::string &snapshot_id,
+                                     const ItemPageCallback &on_page,
+                                     int window) {
+  ItemPage stored;
+  if (playlist_store().load(playlist_id, snapshot_id, stored.items)) {
+    stored.total = static_cast<int>(stored.items.size());
+    index_item_page(ItemView::TRACK_ITEMS, stored);
+    on_page(stored, 0);
     return true;
   }
-  return false;
+  std::vector<NamedItem> fetched;
+  bool complete = true;
+  bool ok = get_all_playlist_track_items(
+      access_token, playlist_id,
+      [&](const ItemPage &page, int offset) {
+        fetched.insert(fetched.end(), page.items.begin(), page.items.end());
+        complete = on_page(page, offset);
+        return complete;
+      },
+      window);
+  if (ok && complete)
+    playlist_store().save(playlist_id, snapshot_id, fetched);
+  return ok;
+}
+
+// Lists the user's playlists and fetches the tracks of those whose
+// snapshot_id differs from the stored copy, concurrency playlists at a time.
+// Copies of playlists that are no longer listed are deleted.
+bool refresh_playlists(const std::string &access_token,
+                       PlaylistRefresh &result, int concurrency) {
+  std::vector<NamedItem> listed;
+  if (!get_all_user_playlist_items(
+          access_token, [&listed](const ItemPage &page, int) {
+            listed.insert(listed.end(), page.items.begin(), page.items.end());
+            return true;
+          }))
+    return false;
+  result.playlists = listed.size();
+
+  std::vector<std::string> ids;
+  std::vector<const NamedItem *> changed;
+  for (auto &playlist : listed) {
+    ids.push_back(playlist.key);
+    if (playlist_store().has(playlist.key, playlist.version))
+      ++result.unchanged;
+    else
+      changed.push_back(&playlist);
+  }
+  playlist_store().retain(ids);
+
+  std::mutex mutex;
+  size_t next = 0;
+  auto work = [&] {
+    for (;;) {
+      const NamedItem *playlist;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (next == changed.size())
+          return;
+        playlist = changed[next++];
+      }
+      bool ok = get_playlist_track_items_cached(
+          access_token, playlist->key, playlist->version,
+          [](const ItemPage &, int) { return true; });
+      std::lock_guard<std::mutex> lock(mutex);
+      if (ok)
+        ++result.fetched;
+      else
+        ++result.failed;
+    }
+  };
+  std::vector<std::thread> workers;
+  for (int i = 1; i < concurrency && static_cast<size_t>(i) < changed.size();
+       ++i)
+    workers.push_back(std::thread(work));
+  work();
+  for (auto &worker : workers)
+    worker.join();
+  return result.failed == 0;
 }
 
 // Displays tracks and allows user to select one
-std::vector<std::pair<std::string, std::string>>
-display_tracks_and_select(const rapidjson::Document &tracks) {
-  std::vector<std::pair<std::string, std::string>> selected_tracks;
+CatalogView display_tracks_and_select(const rapidjson::Document &tracks) {
+  CatalogView selected_tracks;
   if (tracks.HasMember("items") && tracks["items"].IsArray()) {
-    const rapidjson::Value &items = tracks["items"];
     std::cout << "\nTracks in Playlist:\n";
-    for (auto &item : items.GetArray()) {
-      if (item.HasMember("track") && item["track"].IsObject()) {
-        std::string name = item["track"]["name"].GetString();
-        std::string uri = item["track"]["uri"].GetString();
-        std::cout << "- " << name << " (URI: " << uri << ")\n";
-        selected_tracks.emplace_back(name, uri);
-      }
-    }
+    display_track_page(tracks, selected_tracks);
   }
   return selected_tracks;
 }
 
+// Displays one page of playlist or saved track items and appends them to
+// tracks
+void display_track_page(const rapidjson::Value &page, CatalogView &tracks) {
+  if (!page.HasMember("items") || !page["items"].IsArray())
+    return;
+  SavedTrack track;
+  for (auto &item : page["items"].GetArray()) {
+    if (!saved_track_from_item(item, track))
+      continue;
+    tracks.push_back(catalog().add_track(track.name, track.uri, track.artist,
+                                         track.album, track.duration_ms));
+    display_catalog_entry(tracks.size(), tracks.back());
+  }
+}
+
+// Displays one page of extracted items and appends them to items
+void display_item_page(const ItemPage &page, CatalogKind kind,
+                       CatalogView &items) {
+  size_t first = items.size();
+  catalog().add_page(kind, page, items);
+  for (size_t i = first; i < items.size(); ++i)
+    display_catalog_entry(i + 1, items[i]);
+}
+
+// Adds one page of items to items for a full-screen list, which is only
+// drawn once they have all arrived; prints them when there is no full screen
+void list_item_page(const ItemPage &page, CatalogKind kind,
+                    CatalogView &items) {
+  if (!Screen::available()) {
+    display_item_page(page, kind, items);
+    return;
+  }
+  catalog().add_page(kind, page, items);
+  std::cout << "\rLoaded " << items.size() << std::flush;
+}
+
+// Shows view full screen when the terminal allows it and returns the chosen
+// entry; otherwise reads a number or name typed after prompt
+CatalogRef choose_from_view(const CatalogView &view, const std::string &title,
+                            const std::string &prompt) {
+  if (!Screen::available())
+    return select_from_view(view, get_input(prompt));
+  std::cout << "\n";
+  size_t picked = pick_from_list(title, view.size(), [&view](size_t index) {
+    return catalog_entry_text(view[index]);
+  });
+  return picked < view.size() ? view[picked] : kNoCatalogEntry;
+}
+
+// Text of a menu list line, after its number
+std::string catalog_entry_text(CatalogRef ref) {
+  Catalog &entries = catalog();
+  const char *label =
+      entries.kind(ref) == CatalogKind::PLAYLIST ? "ID" : "URI";
+  return entries.name(ref) + " (" + label + ": " + entries.key(ref) + ")";
+}
+
+// Prints one numbered line of a menu list; the number selects it
+void display_catalog_entry(size_t number, CatalogRef ref) {
+  std::cout << number << ". " << catalog_entry_text(ref) << "\n";
+}
+
+// Adds tracks in order at position (appends when negative); returns the
+// number of tracks added
+size_t add_tracks_to_playlist(const std::string &access_token,
+                              const std::string &playlist_id,
+                              const std::vector<std::string> &track_uris,
+                              int position) {
+  PlaylistTrackBatch batch(access_token, playlist_id, position);
+  for (auto &uri : track_uris)
+    batch.add(uri);
+  return batch.flush();
+}
+
 // Sends a request to play a selected track
 void play_selected_track(const std::string &access_token,
                          const std::string &track_uri) {
-  CURL *curl = curl_easy_init();
-  if (curl) {
-    std::string url = "https://api.spotify.com/v1/me/player/play";
-    std::string json_body = "{ \"uris\": [\"" + track_uri + "\"] }";
-
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(
-        headers, ("Authorization: Bearer " + access_token).c_str());
-    headers = curl_slist_append(headers, "Content-Type: application/json");
-
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, json_body.c_str());
-
-    CURLcode res = curl_easy_perform(curl);
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
-
-    if (res == CURLE_OK) {
-      std::cout << "Track is now playing.\n";
-    } else {
-      std::cerr << "Failed to play track: " << curl_easy_strerror(res) << "\n";
-    }
+  std::string url = spotify_api_url("/me/player/play");
+  std::string json_body = json_string_array_body("uris", track_uri);
+
+  std::string error;
+  if (spotify_send_json(access_token, "PUT", url, json_body, &error)) {
+    std::cout << "Track is now playing.\n";
+  } else {
+    std::cerr << "Failed to play track: " << error << "\n";
   }
 }
 
 // Main playlist menu function
 void playlist_menu(const std::string &access_token) {
-  rapidjson::Document playlists_doc;
-  if (get_user_playlists(access_token, playlists_doc)) {
-    auto playlists = display_playlists_and_select(playlists_doc);
+  CatalogView playlists;
+  // snapshot_id by playlist ID
+  std::unordered_map<std::string, std::string> snapshots;
+  std::cout << "\nYour Playlists:\n";
+  bool fetched = get_all_user_playlist_items(
+      access_token, [&playlists, &snapshots](const ItemPage &page, int) {
+        for (auto &item : page.items)
+          snapshots[item.key] = item.version;
+        list_item_page(page, CatalogKind::PLAYLIST, playlists);
+        return true;
+      });
+  if (fetched) {
     if (playlists.empty()) {
       std::cout << "No playlists found.\n";
       return;
     }
-    std::string choice =
-        get_input("\nEnter the name of the playlist to view tracks: ");
-    std::string selected_id;
-    for (auto &pl : playlists) {
-      if (pl.first == choice) {
-        selected_id = pl.second;
-        break;
-      }
-    }
-    if (selected_id.empty()) {
+    // Fetched while the user reads the list
+    prefetch_likely_playlists(access_token, playlists, snapshots);
+    CatalogRef playlist = choose_from_view(
+        playlists, "Your Playlists",
+        "\nEnter the number or name of the playlist to view tracks: ");
+    if (playlist == kNoCatalogEntry) {
+      page_prefetcher().discard();
       std::cout << "Playlist not found.\n";
       return;
     }
-    rapidjson::Document tracks_doc;
-    if (get_playlist_tracks(access_token, selected_id, tracks_doc)) {
-      auto tracks = display_tracks_and_select(tracks_doc);
+    CatalogView tracks;
+    std::string playlist_id = catalog().id(playlist);
+    note_playlist_opened(playlist_id);
+    std::cout << "\nTracks in Playlist:\n";
+    bool loaded = get_playlist_track_items_cached(
+        access_token, playlist_id, snapshots[playlist_id],
+        [&tracks](const ItemPage &page, int) {
+          list_item_page(page, CatalogKind::TRACK, tracks);
+          return true;
+        });
+    // The other playlists were not opened
+    page_prefetcher().discard();
+    if (loaded) {
       if (tracks.empty()) {
         std::cout << "No tracks found in this playlist.\n";
         return;
       }
-      std::string track_choice =
-          get_input("\nEnter the name of the track to play: ");
-      std::string selected_uri;
-      for (auto &tr : tracks) {
-        if (tr.first == track_choice) {
-          selected_uri = tr.second;
-          break;
-        }
-      }
-      if (selected_uri.empty()) {
+      CatalogRef track = choose_from_view(
+          tracks, "Tracks in " + catalog().name(playlist),
+          "\nEnter the number or name of the track to play: ");
+      if (track == kNoCatalogEntry) {
         std::cout << "Track not found.\n";
         return;
       }
-      play_selected_track(access_token, selected_uri);
+      play_selected_track(access_token, catalog().uri(track));
     } else {
       std::cout << "Failed to retrieve tracks.\n";
     }
@@ -1,44 +1,27 @@
 #include "spotify_operations/RecommendationsOperations.h"
+#include "request_builder.h"
+#include "spotify_api.h"
+#include "spotify_operations/PlaylistOperations.h"
 #include "utils.h"
-#include <curl/curl.h>
 #include <iostream>
 
-size_t WriteCallbackGenres(void *contents, size_t size, size_t nmemb,
-                           void *userp) {
-  size_t totalSize = size * nmemb;
-  std::string *genres = static_cast<std::string *>(userp);
-  genres->append(static_cast<char *>(contents), totalSize);
-  return totalSize;
+namespace {
+
+std::string recommendations_url(const std::vector<std::string> &seed_genres,
+                                int limit) {
+  UrlBuilder url(spotify_api_url("/recommendations"));
+  url.param("limit", limit);
+  for (auto &genre : seed_genres)
+    url.param("seed_genres", genre);
+  return url.str();
 }
 
+} // namespace
+
 bool get_available_genres(const std::string &access_token,
                           rapidjson::Document &available_genres) {
-  CURL *curl = curl_easy_init();
-  if (curl) {
-    std::string url =
-        "https://api.spotify.com/v1/recommendations/available-genre-seeds";
-    std::string response;
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(
-        headers, ("Authorization: Bearer " + access_token).c_str());
-
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallbackGenres);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-
-    CURLcode res = curl_easy_perform(curl);
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
-
-    if (res != CURLE_OK)
-      return false;
-
-    if (available_genres.Parse(response.c_str()).HasParseError())
-      return false;
-    return true;
-  }
-  return false;
+  std::string url = spotify_api_url("/recommendations/available-genre-seeds");
+  return spotify_get_json(access_token, url, available_genres);
 }
 
 std::vector<std::string>
@@ -67,98 +50,65 @@ display_available_genres_and_select(const rapidjson::Document &available_genres,
   return selected_genres;
 }
 
-size_t WriteCallbackRecommendations(void *contents, size_t size, size_t nmemb,
-                                    void *userp) {
-  size_t totalSize = size * nmemb;
-  std::string *recommendations = static_cast<std::string *>(userp);
-  recommendations->append(static_cast<char *>(contents), totalSize);
-  return totalSize;
-}
-
 bool get_recommendations(const std::string &access_token,
                          const std::vector<std::string> &seed_genres,
                          rapidjson::Document &recommendations, int limit) {
-  CURL *curl = curl_easy_init();
-  if (curl) {
-    std::string url = "https://api.spotify.com/v1/recommendations?limit=" +
-                      std::to_string(limit);
-    for (auto &genre : seed_genres) {
-      url += "&seed_genres=" + url_encode(genre);
-    }
-    std::string response;
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(
-        headers, ("Authorization: Bearer " + access_token).c_str());
-
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallbackRecommendations);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-
-    CURLcode res = curl_easy_perform(curl);
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
+  return spotify_get_json(access_token,
+                          recommendations_url(seed_genres, limit),
+                          recommendations);
+}
 
-    if (res != CURLE_OK)
-      return false;
+std::future<bool>
+get_recommendations_async(const std::string &access_token,
+                          const std::vector<std::string> &seed_genres,
+                          rapidjson::Document &recommendations, int limit) {
+  return spotify_get_json_async(
+      access_token, recommendations_url(seed_genres, limit), recommendations);
+}
 
-    if (recommendations.Parse(response.c_str()).HasParseError())
-      return false;
-    return true;
-  }
-  return false;
+// Fetches recommendations keeping only the name and URI of each track
+bool get_recommendation_items(const std::string &access_token,
+                              const std::vector<std::string> &seed_genres,
+                              ItemPage &recommendations, int limit) {
+  return spotify_get_items(access_token,
+                           recommendations_url(seed_genres, limit),
+                           ItemView::RECOMMENDATIONS, recommendations);
 }
 
-std::vector<std::pair<std::string, std::string>>
+CatalogRef
 display_recommendations_and_select(const rapidjson::Document &recommendations) {
-  std::vector<std::pair<std::string, std::string>> selected_tracks;
+  ItemPage page;
   if (recommendations.HasMember("tracks") &&
       recommendations["tracks"].IsArray()) {
-    const rapidjson::Value &tracks = recommendations["tracks"];
-    for (auto &track : tracks.GetArray()) {
-      std::string name = track["name"].GetString();
-      std::string uri = track["uri"].GetString();
-      std::cout << "- " << name << " (URI: " << uri << ")\n";
-      selected_tracks.emplace_back(name, uri);
-    }
-    std::cout << "\nEnter the name of the track to play: ";
-    std::string choice = get_input("");
-    for (auto &tr : selected_tracks) {
-      if (tr.first == choice) {
-        return {tr};
-      }
-    }
-    std::cout << "Track not found.\n";
+    for (auto &track : recommendations["tracks"].GetArray())
+      page.items.push_back(NamedItem{track["name"].GetString(),
+                                     track["uri"].GetString(), std::string()});
   }
-  return selected_tracks;
+  return display_recommendations_and_select(page);
+}
+
+CatalogRef display_recommendations_and_select(const ItemPage &recommendations) {
+  if (recommendations.items.empty())
+    return kNoCatalogEntry;
+  CatalogView tracks;
+  display_item_page(recommendations, CatalogKind::TRACK, tracks);
+  CatalogRef selected = select_from_view(
+      tracks, get_input("\nEnter the number or name of the track to play: "));
+  if (selected == kNoCatalogEntry)
+    std::cout << "Track not found.\n";
+  return selected;
 }
 
 void play_recommended_track(const std::string &access_token,
                             const std::string &track_uri) {
-  CURL *curl = curl_easy_init();
-  if (curl) {
-    std::string url = "https://api.spotify.com/v1/me/player/play";
-    std::string json_body = "{ \"uris\": [\"" + track_uri + "\"] }";
-
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(
-        headers, ("Authorization: Bearer " + access_token).c_str());
-    headers = curl_slist_append(headers, "Content-Type: application/json");
-
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, json_body.c_str());
-
-    CURLcode res = curl_easy_perform(curl);
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
+  std::string url = spotify_api_url("/me/player/play");
+  std::string json_body = json_string_array_body("uris", track_uri);
 
-    if (res == CURLE_OK) {
-      std::cout << "Track is now playing.\n";
-    } else {
-      std::cerr << "Failed to play track: " << curl_easy_strerror(res) << "\n";
-    }
+  std::string error;
+  if (spotify_send_json(access_token, "PUT", url, json_body, &error)) {
+    std::cout << "Track is now playing.\n";
+  } else {
+    std::cerr << "Failed to play track: " << error << "\n";
   }
 }
 
@@ -170,16 +120,17 @@ void recommendations_menu(const std::string &access_token) {
       std::cout << "No genres selected.\n";
       return;
     }
-    rapidjson::Document recommendations_doc;
-    if (get_recommendations(access_token, selected_genres,
-                            recommendations_doc)) {
-      auto recommended_tracks =
-          display_recommendations_and_select(recommendations_doc);
-      if (recommended_tracks.empty()) {
+    ItemPage recommendations;
+    if (get_recommendation_items(access_token, selected_genres,
+                                 recommendations)) {
+      if (recommendations.items.empty()) {
         std::cout << "No recommendations found.\n";
         return;
       }
-      play_recommended_track(access_token, recommended_tracks[0].second);
+      CatalogRef selected =
+          display_recommendations_and_select(recommendations);
+      if (selected != kNoCatalogEntry)
+        play_recommended_track(access_token, catalog().uri(selected));
     } else {
       std::cout << "Failed to get recommendations.\n";
     }
@@ -1,210 +1,458 @@
 #include "spotify_operations/SearchOperations.h"
+#include "request_builder.h"
+#include "search_index.h"
+#include "spotify_api.h"
+#include "spotify_operations/PlaylistOperations.h"
+#include "typeahead_search.h"
 #include "utils.h"
-#include <curl/curl.h>
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
 #include <iostream>
+#include <poll.h>
+#include <sstream>
+#include <termios.h>
+#include <unistd.h>
+#include <unordered_set>
 
-size_t WriteCallbackSearch(void *contents, size_t size, size_t nmemb,
-                           void *userp) {
-  size_t totalSize = size * nmemb;
-  std::string *results = static_cast<std::string *>(userp);
-  results->append(static_cast<char *>(contents), totalSize);
-  return totalSize;
+namespace {
+
+std::string search_url(const std::string &query, SearchType type, int limit) {
+  std::string type_str;
+  switch (type) {
+  case SearchType::TRACK:
+    type_str = "track";
+    break;
+  case SearchType::ARTIST:
+    type_str = "artist";
+    break;
+  case SearchType::ALBUM:
+    type_str = "album";
+    break;
+  case SearchType::PLAYLIST:
+    type_str = "playlist";
+    break;
+  default:
+    type_str = "track";
+    break;
+  }
+  UrlBuilder url(spotify_api_url("/search"));
+  url.param("q", query).param("type", type_str).param("limit", limit);
+  return url.str();
 }
 
-bool search_spotify(const std::string &access_token, const std::string &query,
-                    SearchType type, rapidjson::Document &results, int limit) {
-  CURL *curl = curl_easy_init();
-  if (curl) {
-    std::string type_str;
-    switch (type) {
-    case SearchType::TRACK:
-      type_str = "track";
-      break;
-    case SearchType::ARTIST:
-      type_str = "artist";
-      break;
-    case SearchType::ALBUM:
-      type_str = "album";
-      break;
-    case SearchType::PLAYLIST:
-      type_str = "playlist";
-      break;
-    default:
-      type_str = "track";
-      break;
-    }
-    std::string url =
-        "https://api.spotify.com/v1/search?q=" + url_encode(query) +
-        "&type=" + type_str + "&limit=" + std::to_string(limit);
-    std::string response;
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(
-        headers, ("Authorization: Bearer " + access_token).c_str());
-
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallbackSearch);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-
-    CURLcode res = curl_easy_perform(curl);
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
-
-    if (res != CURLE_OK)
-      return false;
-
-    if (results.Parse(response.c_str()).HasParseError())
-      return false;
-    return true;
+ItemView search_view(SearchType type) {
+  switch (type) {
+  case SearchType::ARTIST:
+    return ItemView::SEARCH_ARTISTS;
+  case SearchType::ALBUM:
+    return ItemView::SEARCH_ALBUMS;
+  case SearchType::PLAYLIST:
+    return ItemView::SEARCH_PLAYLISTS;
+  default:
+    return ItemView::SEARCH_TRACKS;
   }
-  return false;
 }
 
-void display_search_results(const rapidjson::Document &results,
-                            SearchType type) {
-  std::cout << "\nSearch Results:\n";
-  if (type == SearchType::TRACK && results.HasMember("tracks") &&
-      results["tracks"].HasMember("items")) {
-    const rapidjson::Value &items = results["tracks"]["items"];
-    for (auto &item : items.GetArray()) {
-      std::string name = item["name"].GetString();
-      std::string uri = item["uri"].GetString();
-      std::cout << "- " << name << " (URI: " << uri << ")\n";
+LocalKind local_kind(SearchType type) {
+  switch (type) {
+  case SearchType::ARTIST:
+    return LocalKind::ARTIST;
+  case SearchType::ALBUM:
+    return LocalKind::ALBUM;
+  case SearchType::PLAYLIST:
+    return LocalKind::PLAYLIST;
+  default:
+    return LocalKind::TRACK;
+  }
+}
+
+CatalogKind catalog_kind(SearchType type) {
+  switch (type) {
+  case SearchType::ARTIST:
+    return CatalogKind::ARTIST;
+  case SearchType::ALBUM:
+    return CatalogKind::ALBUM;
+  case SearchType::PLAYLIST:
+    return CatalogKind::PLAYLIST;
+  default:
+    return CatalogKind::TRACK;
+  }
+}
+
+// The items array of a search response, or null if it has none
+const rapidjson::Value *search_items(const rapidjson::Document &results,
+                                     SearchType type) {
+  const char *member = "tracks";
+  if (type == SearchType::ARTIST)
+    member = "artists";
+  else if (type == SearchType::ALBUM)
+    member = "albums";
+  else if (type == SearchType::PLAYLIST)
+    member = "playlists";
+  if (!results.IsObject() || !results.HasMember(member) ||
+      !results[member].IsObject() || !results[member].HasMember("items") ||
+      !results[member]["items"].IsArray())
+    return nullptr;
+  return &results[member]["items"];
+}
+
+void display_result(size_t number, const std::string &name,
+                    const std::string &uri) {
+  std::cout << number << ". " << name;
+  if (!uri.empty())
+    std::cout << " (URI: " << uri << ")";
+  std::cout << "\n";
+}
+
+// Puts the terminal in non-canonical, no-echo mode for its lifetime so that
+// keystrokes can be read one at a time
+class RawTerminal {
+public:
+  RawTerminal() : active_(tcgetattr(STDIN_FILENO, &saved_) == 0) {
+    if (!active_)
+      return;
+    termios raw = saved_;
+    raw.c_lflag &= ~static_cast<tcflag_t>(ICANON | ECHO);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+  }
+  ~RawTerminal() {
+    if (active_)
+      tcsetattr(STDIN_FILENO, TCSANOW, &saved_);
+  }
+  bool active() const { return active_; }
+
+private:
+  bool active_;
+  termios saved_;
+};
+
+void render_live_search(const std::string &query, const std::string &status,
+                        const ItemPage &results) {
+  std::cout << "\033[2J\033[H"
+            << "Live search (Enter to pick a result, Esc to cancel)\n"
+            << "\033[K" << status << "\n\n";
+  for (auto &item : results.items)
+    std::cout << "- " << item.name << " (URI: " << item.key << ")\n";
+  std::cout << "\033[2;1H\033[K> " << query << std::flush;
+}
+
+// Interactive type-ahead over the Web API. Returns false when cancelled;
+// otherwise results holds what was on screen when Enter was pressed.
+bool live_search(const std::string &access_token, SearchType type,
+                 ItemPage &results) {
+  RawTerminal terminal;
+  if (!terminal.active()) {
+    std::cout << "Live search needs an interactive terminal.\n";
+    return false;
+  }
+  TypeAheadSearch search(access_token, type);
+  std::string query;
+  std::string status = "Start typing to search.";
+  std::vector<double> latencies;
+  bool picked = false;
+  render_live_search(query, status, results);
+
+  while (true) {
+    int timeout = search.poll();
+    pollfd fds[2] = {{STDIN_FILENO, POLLIN, 0}, {search.wake_fd(), POLLIN, 0}};
+    if (::poll(fds, 2, timeout) < 0)
+      break;
+
+    TypeAheadResult result;
+    if (search.take_result(result) && result.query == query) {
+      results = std::move(result.page);
+      if (!result.ok)
+        status = "Search failed.";
+      else
+        status = std::to_string(results.items.size()) + " results" +
+                 (result.from_cache ? " (cached)" : "");
+      render_live_search(query, status, results);
+      double ms = std::chrono::duration<double, std::milli>(
+                      TypeAheadClock::now() - result.keystroke_at)
+                      .count();
+      latencies.push_back(ms);
+      std::cout << "\033[s\033[1;60H" << static_cast<int>(ms + 0.5)
+                << " ms\033[u" << std::flush;
     }
-  } else if (type == SearchType::ARTIST && results.HasMember("artists") &&
-             results["artists"].HasMember("items")) {
-    const rapidjson::Value &items = results["artists"]["items"];
-    for (auto &item : items.GetArray()) {
-      std::string name = item["name"].GetString();
-      std::string uri = item["uri"].GetString();
-      std::cout << "- " << name << " (URI: " << uri << ")\n";
+
+    if (!(fds[0].revents & POLLIN))
+      continue;
+    char c;
+    if (read(STDIN_FILENO, &c, 1) != 1 || c == 4) // EOF or Ctrl-D
+      break;
+    if (c == '\n' || c == '\r') {
+      picked = true;
+      break;
     }
-  } else if (type == SearchType::ALBUM && results.HasMember("albums") &&
-             results["albums"].HasMember("items")) {
-    const rapidjson::Value &items = results["albums"]["items"];
-    for (auto &item : items.GetArray()) {
-      std::string name = item["name"].GetString();
-      std::string uri = item["uri"].GetString();
-      std::cout << "- " << name << " (URI: " << uri << ")\n";
+    if (c == 27) {
+      // A lone Esc cancels; escape sequences such as arrow keys are skipped
+      pollfd next = {STDIN_FILENO, POLLIN, 0};
+      if (::poll(&next, 1, 0) <= 0)
+        break;
+      char sequence[8];
+      ssize_t skipped = read(STDIN_FILENO, sequence, sizeof(sequence));
+      (void)skipped;
+      continue;
     }
-  } else if (type == SearchType::PLAYLIST && results.HasMember("playlists") &&
-             results["playlists"].HasMember("items")) {
-    const rapidjson::Value &items = results["playlists"]["items"];
-    for (auto &item : items.GetArray()) {
-      std::string name = item["name"].GetString();
-      std::string uri = item["uri"].GetString();
-      std::cout << "- " << name << " (URI: " << uri << ")\n";
+    if (c == 127 || c == 8) {
+      if (query.empty())
+        continue;
+      query.pop_back();
+      // Drop the rest of a multibyte UTF-8 character
+      while (!query.empty() && (query.back() & 0xC0) == 0x80)
+        query.pop_back();
+    } else if (static_cast<unsigned char>(c) >= 0x20) {
+      query += c;
+    } else {
+      continue;
     }
+    search.set_query(query);
+    status = "Searching...";
+    render_live_search(query, status, results);
   }
+
+  std::cout << "\033[2J\033[H";
+  if (!latencies.empty()) {
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << "Keystroke to results: median "
+              << static_cast<int>(latencies[latencies.size() / 2] + 0.5)
+              << " ms, worst " << static_cast<int>(latencies.back() + 0.5)
+              << " ms over " << latencies.size() << " updates\n";
+  }
+  if (picked)
+    display_search_results(results);
+  return picked && !results.items.empty();
 }
 
-std::vector<std::pair<std::string, std::string>>
-select_from_search_results(const rapidjson::Document &results,
-                           SearchType type) {
-  std::vector<std::pair<std::string, std::string>> selected;
-  std::string choice = get_input("Enter the name of the item to select: ");
-  if (type == SearchType::TRACK && results.HasMember("tracks") &&
-      results["tracks"].HasMember("items")) {
-    const rapidjson::Value &items = results["tracks"]["items"];
-    for (auto &item : items.GetArray()) {
-      std::string name = item["name"].GetString();
-      std::string uri = item["uri"].GetString();
-      if (name == choice) {
-        selected.emplace_back(name, uri);
-        break;
-      }
+// Parses a pick of results numbered 1..count such as "1 3 5-8" or "a" for
+// all into zero-based indexes, in the order given and without repeats.
+// False when a number or range is malformed or out of range.
+bool parse_result_picks(const std::string &input, size_t count,
+                        std::vector<size_t> &picks) {
+  std::vector<bool> taken(count, false);
+  std::istringstream tokens(input);
+  std::string token;
+  while (tokens >> token) {
+    size_t first, last;
+    if (token == "a" || token == "A") {
+      first = 1;
+      last = count;
+    } else {
+      char *end;
+      first = last = std::strtoul(token.c_str(), &end, 10);
+      if (*end == '-')
+        last = std::strtoul(end + 1, &end, 10);
+      if (*end != '\0' || first == 0 || first > last || last > count)
+        return false;
     }
-  } else if (type == SearchType::ARTIST && results.HasMember("artists") &&
-             results["artists"].HasMember("items")) {
-    const rapidjson::Value &items = results["artists"]["items"];
-    for (auto &item : items.GetArray()) {
-      std::string name = item["name"].GetString();
-      std::string uri = item["uri"].GetString();
-      if (name == choice) {
-        selected.emplace_back(name, uri);
-        break;
-      }
+    for (size_t i = first - 1; i < last; ++i) {
+      if (!taken[i])
+        picks.push_back(i);
+      taken[i] = true;
     }
-  } else if (type == SearchType::ALBUM && results.HasMember("albums") &&
-             results["albums"].HasMember("items")) {
-    const rapidjson::Value &items = results["albums"]["items"];
-    for (auto &item : items.GetArray()) {
-      std::string name = item["name"].GetString();
-      std::string uri = item["uri"].GetString();
-      if (name == choice) {
-        selected.emplace_back(name, uri);
-        break;
-      }
+  }
+  return true;
+}
+
+// Runs track searches until an empty query and hands the results the user
+// picks from each to add
+void collect_search_results(const std::string &access_token,
+                            const std::function<void(const NamedItem &)> &add) {
+  while (true) {
+    std::string query = get_input("Enter search query (empty to finish): ");
+    if (query.empty())
+      break;
+    ItemPage results;
+    if (!search_spotify_items(access_token, query, SearchType::TRACK, results,
+                              50)) {
+      std::cout << "Search failed.\n";
+      continue;
     }
-  } else if (type == SearchType::PLAYLIST && results.HasMember("playlists") &&
-             results["playlists"].HasMember("items")) {
-    const rapidjson::Value &items = results["playlists"]["items"];
-    for (auto &item : items.GetArray()) {
-      std::string name = item["name"].GetString();
-      std::string uri = item["uri"].GetString();
-      if (name == choice) {
-        selected.emplace_back(name, uri);
-        break;
-      }
+    display_search_results(results);
+    if (results.items.empty())
+      continue;
+    std::vector<size_t> picks;
+    while (!parse_result_picks(
+        get_input("Tracks to add (e.g. 1 3 5-8, a for all, empty for "
+                  "none): "),
+        results.items.size(), picks)) {
+      picks.clear();
+      std::cout << "Enter numbers from 1 to " << results.items.size()
+                << ".\n";
     }
+    for (size_t i : picks)
+      add(results.items[i]);
+    std::cout << picks.size() << " tracks picked.\n";
+  }
+}
+
+} // namespace
+
+bool search_spotify(const std::string &access_token, const std::string &query,
+                    SearchType type, rapidjson::Document &results, int limit) {
+  return spotify_get_json(access_token, search_url(query, type, limit),
+                          results);
+}
+
+std::future<bool> search_spotify_async(const std::string &access_token,
+                                       const std::string &query,
+                                       SearchType type,
+                                       rapidjson::Document &results,
+                                       int limit) {
+  return spotify_get_json_async(access_token, search_url(query, type, limit),
+                                results);
+}
+
+// Searches and keeps only the name and URI of each result
+bool search_spotify_items(const std::string &access_token,
+                          const std::string &query, SearchType type,
+                          ItemPage &results, int limit) {
+  return spotify_get_items(access_token, search_url(query, type, limit),
+                           search_view(type), results);
+}
+
+std::future<bool> search_spotify_items_async(const std::string &access_token,
+                                             const std::string &query,
+                                             SearchType type,
+                                             ItemPage &results, int limit) {
+  return spotify_get_items_async(access_token,
+                                 search_url(query, type, limit),
+                                 search_view(type), results);
+}
+
+HttpRequestId search_spotify_items_async(const std::string &access_token,
+                                         const std::string &query,
+                                         SearchType type,
+                                         ItemsCallback callback, int limit) {
+  return spotify_get_items_async(access_token,
+                                 search_url(query, type, limit),
+                                 search_view(type), callback);
+}
+
+// Prints matches from the local index while the remote search is in flight,
+// then appends the remote results that were not already shown. results holds
+// everything displayed; returns false only if both searches came up empty
+// and the remote one failed.
+bool search_local_first(const std::string &access_token,
+                        const std::string &query, SearchType type,
+                        ItemPage &results, int limit) {
+  ItemPage remote;
+  std::future<bool> fetched =
+      search_spotify_items_async(access_token, query, type, remote, limit);
+
+  std::vector<LocalHit> hits =
+      search_index().search(query, local_kind(type), limit);
+  std::cout << "\nLocal Results:\n";
+  if (hits.empty())
+    std::cout << "(none)\n";
+  std::unordered_set<std::string> shown;
+  for (auto &hit : hits) {
+    results.items.push_back(NamedItem{hit.name, hit.uri, std::string()});
+    display_result(results.items.size(), hit.name, hit.uri);
+    shown.insert(hit.uri.empty() ? hit.name : hit.uri);
   }
-  return selected;
+
+  bool ok = fetched.get();
+  std::cout << "\nFrom Spotify:\n";
+  size_t added = 0;
+  for (auto &item : remote.items) {
+    if (!shown.insert(item.key).second)
+      continue;
+    results.items.push_back(item);
+    display_result(results.items.size(), item.name, item.key);
+    ++added;
+  }
+  if (!ok)
+    std::cout << "(search failed)\n";
+  else if (added == 0)
+    std::cout << "(nothing new)\n";
+  return ok || !results.items.empty();
+}
+
+void display_search_results(const rapidjson::Document &results,
+                            SearchType type) {
+  std::cout << "\nSearch Results:\n";
+  const rapidjson::Value *items = search_items(results, type);
+  if (!items)
+    return;
+  size_t number = 0;
+  for (auto &item : items->GetArray())
+    display_result(++number, item["name"].GetString(),
+                   item["uri"].GetString());
+}
+
+void display_search_results(const ItemPage &results) {
+  std::cout << "\nSearch Results:\n";
+  for (size_t i = 0; i < results.items.size(); ++i)
+    display_result(i + 1, results.items[i].name, results.items[i].key);
+}
+
+CatalogRef select_from_search_results(const rapidjson::Document &results,
+                                      SearchType type) {
+  std::string choice =
+      get_input("Enter the number or name of the item to select: ");
+  CatalogView view;
+  const rapidjson::Value *items = search_items(results, type);
+  if (items) {
+    for (auto &item : items->GetArray())
+      view.push_back(catalog().add(catalog_kind(type),
+                                   item["name"].GetString(),
+                                   item["uri"].GetString()));
+  }
+  return select_from_view(view, choice);
+}
+
+CatalogRef select_from_search_results(const ItemPage &results,
+                                      SearchType type) {
+  std::string choice =
+      get_input("Enter the number or name of the item to select: ");
+  CatalogView view;
+  catalog().add_page(catalog_kind(type), results, view);
+  return select_from_view(view, choice);
 }
 
 bool add_track_to_playlist(const std::string &access_token,
                            const std::string &playlist_id,
                            const std::string &track_uri) {
-  CURL *curl = curl_easy_init();
-  if (curl) {
-    std::string url = "https://api.spotify.com/v1/playlists/" + playlist_id +
-                      "/tracks?uris=" + url_encode(track_uri);
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(
-        headers, ("Authorization: Bearer " + access_token).c_str());
-
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_POST, 1L);
-
-    CURLcode res = curl_easy_perform(curl);
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
-
-    return res == CURLE_OK;
-  }
-  return false;
+  return add_tracks_to_playlist(access_token, playlist_id, {track_uri}) == 1;
 }
 
 bool add_track_to_queue(const std::string &access_token,
                         const std::string &track_uri) {
-  CURL *curl = curl_easy_init();
-  if (curl) {
-    std::string url = "https://api.spotify.com/v1/me/player/queue?uri=" +
-                      url_encode(track_uri);
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(
-        headers, ("Authorization: Bearer " + access_token).c_str());
-
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_POST, 1L);
-
-    CURLcode res = curl_easy_perform(curl);
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
-
-    return res == CURLE_OK;
-  }
-  return false;
+  UrlBuilder url(spotify_api_url("/me/player/queue"));
+  return spotify_send(access_token, "POST", url.param("uri", track_uri).str());
+}
+
+// Queues tracks through the async engine with up to window requests in
+// flight; returns the number queued
+size_t add_tracks_to_queue(const std::string &access_token,
+                           const std::vector<std::string> &track_uris,
+                           int window) {
+  std::vector<std::string> urls;
+  UrlBuilder url(spotify_api_url("/me/player/queue"));
+  for (auto &uri : track_uris)
+    urls.push_back(url.reset().param("uri", uri).str());
+  std::vector<bool> results =
+      spotify_send_batch(access_token, "POST", urls, window);
+  return static_cast<size_t>(std::count(results.begin(), results.end(), true));
 }
 
 void search_menu(const std::string &access_token) {
+  bool local_first = false;
   while (true) {
     std::cout << "\n--- Search Menu ---\n";
     std::cout << "1. Search Tracks\n";
     std::cout << "2. Search Artists\n";
     std::cout << "3. Search Albums\n";
     std::cout << "4. Search Playlists\n";
+    std::cout << "5. Add Search Results to a Playlist\n";
+    std::cout << "6. Add Search Results to the Queue\n";
+    std::cout << "7. Live Track Search\n";
+    std::cout << "l. Local-First Search ("
+              << (local_first ? "on" : "off") << ")\n";
     std::cout << "b. Back to Main Menu\n";
     std::cout << "Select an option: ";
 
@@ -218,19 +466,56 @@ void search_menu(const std::string &access_token) {
       type = SearchType::ALBUM;
     else if (choice == "4")
       type = SearchType::PLAYLIST;
-    else if (choice == "b" || choice == "B")
+    else if (choice == "5") {
+      std::string playlist_id =
+          get_input("Enter Playlist ID to add the tracks: ");
+      PlaylistTrackBatch batch(access_token, playlist_id);
+      collect_search_results(access_token, [&batch](const NamedItem &item) {
+        batch.add(item.key);
+      });
+      size_t added = batch.flush();
+      std::cout << "Added " << added << " tracks to the playlist";
+      if (batch.failed() > 0)
+        std::cout << " (" << batch.failed() << " failed)";
+      std::cout << ".\n";
+      continue;
+    } else if (choice == "6") {
+      std::vector<std::string> uris;
+      collect_search_results(access_token, [&uris](const NamedItem &item) {
+        uris.push_back(item.key);
+      });
+      size_t queued = add_tracks_to_queue(access_token, uris);
+      std::cout << "Queued " << queued << " of " << uris.size()
+                << " tracks.\n";
+      continue;
+    } else if (choice == "7") {
+      type = SearchType::TRACK;
+    } else if (choice == "l" || choice == "L") {
+      local_first = !local_first;
+      continue;
+    } else if (choice == "b" || choice == "B")
       break;
     else {
       std::cout << "Invalid option. Try again.\n";
       continue;
     }
 
-    std::string query = get_input("Enter search query: ");
-    rapidjson::Document results_doc;
-    if (search_spotify(access_token, query, type, results_doc)) {
-      display_search_results(results_doc, type);
-      auto selected = select_from_search_results(results_doc, type);
-      if (selected.empty()) {
+    ItemPage results;
+    bool found;
+    if (choice == "7") {
+      found = live_search(access_token, type, results);
+    } else if (local_first) {
+      std::string query = get_input("Enter search query: ");
+      found = search_local_first(access_token, query, type, results);
+    } else {
+      std::string query = get_input("Enter search query: ");
+      found = search_spotify_items(access_token, query, type, results);
+      if (found)
+        display_search_results(results);
+    }
+    if (found) {
+      CatalogRef selected = select_from_search_results(results, type);
+      if (selected == kNoCatalogEntry) {
         std::cout << "No selection made.\n";
         continue;
       }
@@ -242,13 +527,13 @@ void search_menu(const std::string &access_token) {
           std::string playlist_id =
               get_input("Enter Playlist ID to add the track: ");
           if (add_track_to_playlist(access_token, playlist_id,
-                                    selected[0].second)) {
+                                    catalog().uri(selected))) {
             std::cout << "Track added to playlist.\n";
           } else {
             std::cout << "Failed to add track to playlist.\n";
           }
         } else if (add_choice == "2") {
-          if (add_track_to_queue(access_token, selected[0].second)) {
+          if (add_track_to_queue(access_token, catalog().uri(selected))) {
             std::cout << "Track added to queue.\n";
           } else {
             std::cout << "Failed to add track to queue.\n";
@@ -0,0 +1,176 @@
+// src/typeahead_search.cpp
+#include "typeahead_search.h"
+#include "lru_cache.h"
+#include "utils.h"
+#include <algorithm>
+#include <cctype>
+#include <fcntl.h>
+#include <mutex>
+#include <unistd.h>
+
+namespace {
+
+// Queries differing only in case or surrounding space share a cache entry
+std::string cache_key(SearchType type, const std::string &query) {
+  std::string key = trim(query);
+  std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+  return std::to_string(static_cast<int>(type)) + ":" + key;
+}
+
+} // namespace
+
+// Shared with the completion callbacks, which may run after the search has
+// been destroyed
+struct TypeAheadSearch::State {
+  std::string access_token;
+  SearchType type;
+  int limit;
+  std::chrono::milliseconds debounce;
+
+  std::mutex mutex;
+  std::string query;
+  TypeAheadClock::time_point keystroke_at;
+  bool due = false; // the query changed and has not been searched yet
+  uint64_t generation = 0;
+  HttpRequestId in_flight = 0;
+  bool has_result = false;
+  TypeAheadResult result;
+  LruCache<std::string, ItemPage> cache;
+  TypeAheadStats stats;
+  int wake[2];
+
+  State() : cache(kCacheEntries) {
+    if (pipe(wake) == 0) {
+      fcntl(wake[0], F_SETFL, O_NONBLOCK);
+      fcntl(wake[1], F_SETFL, O_NONBLOCK);
+    } else {
+      wake[0] = wake[1] = -1;
+    }
+  }
+
+  ~State() {
+    if (wake[0] >= 0) {
+      close(wake[0]);
+      close(wake[1]);
+    }
+  }
+
+  // Called with mutex held
+  void cancel_in_flight() {
+    if (in_flight == 0)
+      return;
+    http_cancel(in_flight);
+    in_flight = 0;
+    ++stats.cancelled;
+  }
+
+  // Called with mutex held
+  void publish(const ItemPage &page, bool ok, bool from_cache) {
+    result.query = query;
+    result.page = page;
+    result.ok = ok;
+    result.from_cache = from_cache;
+    result.keystroke_at = keystroke_at;
+    has_result = true;
+    if (wake[1] >= 0) {
+      char byte = 1;
+      ssize_t written = write(wake[1], &byte, 1);
+      (void)written;
+    }
+  }
+};
+
+TypeAheadSearch::TypeAheadSearch(const std::string &access_token,
+                                 SearchType type, int limit, int debounce_ms)
+    : state_(std::make_shared<State>()) {
+  state_->access_token = access_token;
+  state_->type = type;
+  state_->limit = limit;
+  state_->debounce = std::chrono::milliseconds(debounce_ms);
+}
+
+TypeAheadSearch::~TypeAheadSearch() {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  ++state_->generation;
+  state_->cancel_in_flight();
+}
+
+void TypeAheadSearch::set_query(const std::string &query) {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  State &s = *state_;
+  ++s.stats.keystrokes;
+  s.query = query;
+  s.keystroke_at = TypeAheadClock::now();
+  s.due = false;
+
+  // Anything in flight is for an older query now
+  ++s.generation;
+  s.cancel_in_flight();
+
+  ItemPage cached;
+  if (trim(query).empty()) {
+    s.publish(ItemPage(), true, true);
+  } else if (s.cache.get(cache_key(s.type, query), cached)) {
+    ++s.stats.cache_hits;
+    s.publish(cached, true, true);
+  } else {
+    s.due = true;
+  }
+}
+
+int TypeAheadSearch::poll() {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  State &s = *state_;
+  if (!s.due)
+    return -1;
+  auto waited = TypeAheadClock::now() - s.keystroke_at;
+  if (waited < s.debounce) {
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+        s.debounce - waited);
+    return std::max(1, static_cast<int>(remaining.count()));
+  }
+  s.due = false;
+  start_search();
+  return -1;
+}
+
+// Called with the state mutex held
+void TypeAheadSearch::start_search() {
+  State &s = *state_;
+  std::shared_ptr<State> shared = state_;
+  uint64_t generation = s.generation;
+  std::string key = cache_key(s.type, s.query);
+  ++s.stats.requests;
+  s.in_flight = search_spotify_items_async(
+      s.access_token, s.query, s.type,
+      [shared, generation, key](bool ok, ItemPage &page) {
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        if (ok)
+          shared->cache.put(key, page);
+        if (generation != shared->generation)
+          return; // superseded by a later keystroke
+        shared->in_flight = 0;
+        shared->publish(page, ok, false);
+      },
+      s.limit);
+}
+
+bool TypeAheadSearch::take_result(TypeAheadResult &result) {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  State &s = *state_;
+  char buffer[64];
+  while (s.wake[0] >= 0 && read(s.wake[0], buffer, sizeof(buffer)) > 0) {
+  }
+  if (!s.has_result)
+    return false;
+  result = std::move(s.result);
+  s.has_result = false;
+  return true;
+}
+
+int TypeAheadSearch::wake_fd() const { return state_->wake[0]; }
+
+TypeAheadStats TypeAheadSearch::stats() {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->stats;
+}
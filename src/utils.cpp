@@ -2,9 +2,10 @@
 #include "utils.h"
 #include <algorithm>
 #include <cctype>
-#include <curl/curl.h>
+#include <cstdlib>
 #include <iostream>
 #include <sstream>
+#include <sys/stat.h>
 
 size_t WriteCallback(void *contents, size_t size, size_t nmemb, void *userp) {
   size_t totalSize = size * nmemb;
@@ -13,20 +14,52 @@ size_t WriteCallback(void *contents, size_t size, size_t nmemb, void *userp) {
   return totalSize;
 }
 
-std::string url_encode(const std::string &value) {
-  CURL *curl = curl_easy_init();
-  if (curl) {
-    char *output =
-        curl_easy_escape(curl, value.c_str(), static_cast<int>(value.length()));
-    if (output) {
-      std::string encoded(output);
-      curl_free(output);
-      curl_easy_cleanup(curl);
-      return encoded;
+namespace {
+
+// Whether a byte is an RFC 3986 unreserved character, which URL encoding
+// leaves as it is
+struct UnreservedTable {
+  bool keep[256];
+
+  UnreservedTable() {
+    for (int c = 0; c < 256; ++c)
+      keep[c] = (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') ||
+                (c >= 'a' && c <= 'z');
+    keep[static_cast<unsigned char>('-')] = true;
+    keep[static_cast<unsigned char>('.')] = true;
+    keep[static_cast<unsigned char>('_')] = true;
+    keep[static_cast<unsigned char>('~')] = true;
+  }
+};
+
+const UnreservedTable kUnreserved;
+
+} // namespace
+
+void append_url_encoded(std::string &out, const char *data, size_t len) {
+  static const char kHex[] = "0123456789ABCDEF";
+  size_t encoded = len;
+  for (size_t i = 0; i < len; ++i)
+    encoded += kUnreserved.keep[static_cast<unsigned char>(data[i])] ? 0 : 2;
+  size_t at = out.size();
+  out.resize(at + encoded);
+  char *dst = &out[at];
+  for (size_t i = 0; i < len; ++i) {
+    unsigned char c = static_cast<unsigned char>(data[i]);
+    if (kUnreserved.keep[c]) {
+      *dst++ = static_cast<char>(c);
+    } else {
+      *dst++ = '%';
+      *dst++ = kHex[c >> 4];
+      *dst++ = kHex[c & 0xF];
     }
-    curl_easy_cleanup(curl);
   }
-  return "";
+}
+
+std::string url_encode(const std::string &value) {
+  std::string encoded;
+  append_url_encoded(encoded, value.data(), value.size());
+  return encoded;
 }
 
 std::string trim(const std::string &s) {
@@ -47,9 +80,69 @@ std::vector<std::string> split(const std::string &s, char delimiter) {
   return tokens;
 }
 
+std::string escape_tsv_field(const std::string &value) {
+  std::string out;
+  out.reserve(value.size());
+  for (char c : value) {
+    if (c == '\\')
+      out += "\\\\";
+    else if (c == '\t')
+      out += "\\t";
+    else if (c == '\n')
+      out += "\\n";
+    else
+      out += c;
+  }
+  return out;
+}
+
+std::string unescape_tsv_field(const std::string &value) {
+  std::string out;
+  out.reserve(value.size());
+  for (size_t i = 0; i < value.size(); ++i) {
+    if (value[i] == '\\' && i + 1 < value.size()) {
+      char next = value[++i];
+      out += next == 't' ? '\t' : next == 'n' ? '\n' : next;
+    } else {
+      out += value[i];
+    }
+  }
+  return out;
+}
+
 std::string get_input(const std::string &prompt) {
   std::cout << prompt;
   std::string input;
   std::getline(std::cin, input);
   return trim(input);
 }
+
+namespace {
+
+// <$xdg_variable or ~/home_fallback>/spotify-tui, created if needed
+std::string user_directory(const char *xdg_variable,
+                           const char *home_fallback) {
+  std::string base;
+  const char *xdg = std::getenv(xdg_variable);
+  const char *home = std::getenv("HOME");
+  if (xdg && *xdg)
+    base = xdg;
+  else if (home && *home)
+    base = std::string(home) + "/" + home_fallback;
+  else
+    base = ".";
+  mkdir(base.c_str(), 0755);
+  std::string dir = base + "/spotify-tui";
+  mkdir(dir.c_str(), 0700);
+  return dir;
+}
+
+} // namespace
+
+std::string cache_directory() {
+  return user_directory("XDG_CACHE_HOME", ".cache");
+}
+
+std::string config_directory() {
+  return user_directory("XDG_CONFIG_HOME", ".config");
+}